@@ -4,6 +4,8 @@ dist_pkgdata_DATA += gldcore/unitfile.txt
 GLD_SOURCES_PLACE_HOLDER = 
 GLD_SOURCES_PLACE_HOLDER += gldcore/aggregate.c
 GLD_SOURCES_PLACE_HOLDER += gldcore/aggregate.h
+GLD_SOURCES_PLACE_HOLDER += gldcore/arena.c
+GLD_SOURCES_PLACE_HOLDER += gldcore/arena.h
 GLD_SOURCES_PLACE_HOLDER += gldcore/build.h
 GLD_SOURCES_PLACE_HOLDER += gldcore/class.c
 GLD_SOURCES_PLACE_HOLDER += gldcore/class.h
@@ -27,6 +29,8 @@ GLD_SOURCES_PLACE_HOLDER += gldcore/exception.c
 GLD_SOURCES_PLACE_HOLDER += gldcore/exception.h
 GLD_SOURCES_PLACE_HOLDER += gldcore/exec.c
 GLD_SOURCES_PLACE_HOLDER += gldcore/exec.h
+GLD_SOURCES_PLACE_HOLDER += gldcore/executor.c
+GLD_SOURCES_PLACE_HOLDER += gldcore/executor.h
 GLD_SOURCES_PLACE_HOLDER += gldcore/find.c
 GLD_SOURCES_PLACE_HOLDER += gldcore/find.h
 GLD_SOURCES_PLACE_HOLDER += gldcore/gld_sock.h
@@ -121,6 +125,8 @@ GLD_SOURCES_PLACE_HOLDER += gldcore/validate.cpp
 GLD_SOURCES_PLACE_HOLDER += gldcore/validate.h
 GLD_SOURCES_PLACE_HOLDER += gldcore/version.c
 GLD_SOURCES_PLACE_HOLDER += gldcore/version.h
+GLD_SOURCES_PLACE_HOLDER += gldcore/watchdog.c
+GLD_SOURCES_PLACE_HOLDER += gldcore/watchdog.h
 
 GLD_SOURCES_EXTRA_PLACE_HOLDER =
 GLD_SOURCES_EXTRA_PLACE_HOLDER += gldcore/cmex.c
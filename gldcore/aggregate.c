@@ -34,6 +34,8 @@
 #include "aggregate.h"
 #include "output.h"
 #include "find.h"
+#include "exec.h"
+#include "executor.h"
 
 SET_MYCONTEXT(DMC_AGGREGATE)
 
@@ -315,6 +317,15 @@ AGGREGATION *aggregate_mkgroup(char *aggregator, /**< aggregator (min,max,avg,st
 			result->flags = flags;
 			result->punit = to_unit;
 			result->scale = scale;
+			result->member = NULL;
+			result->value = NULL;
+			result->n_members = 0;
+			result->active = NULL;
+			result->n_active = 0;
+			result->valid_from = TS_NEVER;
+			result->valid_to = TS_ZERO;
+			result->block = NULL;
+			result->n_blocks = 0;
 		}
 		else
 		{
@@ -340,121 +351,427 @@ double arg(complex *x)
 	return (x->r==0) ? (x->i>0 ? PI/2 : (x->i==0 ? 0 : -PI/2)) : ((x->i>0) ? (x->r>0 ? atan(x->i/x->r) : PI-atan(x->i/x->r)) : (x->r>0 ? -atan(x->i/x->r) : PI+atan(x->i/x->r)));
 }
 
-/** This function performs an aggregate calculation given by the aggregation 
- **/
-double aggregate_value(AGGREGATION *aggr) /**< the aggregation to perform */
-{
-	OBJECT *obj;
-	double numerator=0, denominator=0, secondary=0, third=0, fourth=0;
-	double scale = (aggr->punit ? aggr->scale : 1.0);
+/* number of values gathered into the buffer of the reduction kernel at a time */
+#define AGGR_BUFSIZE 256
 
-	/* non-constant groups need search program rerun */
-	if ((aggr->group->constflags & CF_CONSTANT) != CF_CONSTANT){
-		aggr->last = find_runpgm(NULL,aggr->group); /** @todo use constant part instead of NULL (ticket #3) */
-	}
+/* minimum number of values in service before the calculation is split among threads */
+#define AGGR_PARALLEL 65536
 
-	for(obj = find_first(aggr->last); obj != NULL; obj = find_next(aggr->last, obj)){
-		double value=0;
-		double *pdouble = NULL;
-		complex *pcomplex = NULL;
+/* number of blocks per thread when the calculation is split among threads */
+#define AGGR_BLOCKSPERTHREAD 4
 
-		/* add time-sensitivity to verify that we are only aggregating objects that are in-service and not out-service. */
-		if(obj->in_svc >= global_clock || obj->out_svc <= global_clock)
-			continue;
+/** Partial result of an aggregation over a block of values **/
+typedef struct s_aggrblock {
+	AGGREGATION *aggr; /**< the aggregation */
+	unsigned int first, last; /**< the range of active values in the block */
+	unsigned int n; /**< the number of values */
+	double sum; /**< the sum of the values */
+	double prod; /**< the product of the values */
+	double min, max; /**< the smallest and largest values */
+	double mean, m2; /**< the mean and the sum of squared deviations from the mean */
+	double logsum; /**< the sum of the logs of the values */
+} AGGRBLOCK;
 
+/* build the list of members and the address of their values from the last search result */
+static int aggregate_compile(AGGREGATION *aggr)
+{
+	OBJECT *obj;
+	unsigned int n = 0;
+	free(aggr->member);
+	free(aggr->value);
+	free(aggr->active);
+	aggr->member = (OBJECT**)malloc(sizeof(OBJECT*)*(aggr->last->hit_count+1));
+	aggr->value = (void**)malloc(sizeof(void*)*(aggr->last->hit_count+1));
+	aggr->active = (void**)malloc(sizeof(void*)*(aggr->last->hit_count+1));
+	if ( aggr->member==NULL || aggr->value==NULL || aggr->active==NULL )
+	{
+		output_error("aggregate_compile(): memory allocation failed");
+		/* TROUBLESHOOT
+			There was not enough memory to build the list of objects in an aggregation.
+			Try reducing the size of your model or freeing up more memory.
+		 */
+		return 0;
+	}
+	for ( obj=find_first(aggr->last) ; obj!=NULL ; obj=find_next(aggr->last,obj) )
+	{
+		void *addr = NULL;
 		switch (aggr->pinfo->ptype) {
 		case PT_complex:
 		case PT_enduse:
-			pcomplex = object_get_complex(obj,aggr->pinfo);
-			if (pcomplex!=NULL)
-			{
-				switch (aggr->part) {
-				case AP_REAL: value=pcomplex->r; break;
-				case AP_IMAG: value=pcomplex->i; break;
-				case AP_MAG: value=mag(pcomplex); break;
-				case AP_ARG: value=arg(pcomplex); break;
-				case AP_ANG: value=arg(pcomplex)*180/PI;  break;
-				default: pcomplex = NULL; break; /* invalidate the result */
-				}
-			}
+			if ( aggr->part!=AP_NONE )
+				addr = object_get_complex(obj,aggr->pinfo);
 			break;
 		case PT_double:
 		case PT_loadshape:
 		case PT_random:
-			pdouble = object_get_double(obj,aggr->pinfo);
-			if (pdouble!=NULL){
-				value = *pdouble;
-				if(aggr->pinfo->unit != 0 && aggr->punit != 0){
-					int rv = unit_convert_ex(aggr->pinfo->unit, aggr->punit, &value);
-					if(rv == 0){ // error
-						;
-					}
-				} // else don't worry
+			addr = object_get_double(obj,aggr->pinfo);
+			break;
+		default:
+			break;
+		}
+		if ( addr!=NULL )
+		{
+			aggr->member[n] = obj;
+			aggr->value[n] = addr;
+			n++;
+		}
+	}
+	aggr->n_members = n;
+	aggr->n_active = 0;
+	aggr->valid_from = TS_NEVER;
+	aggr->valid_to = TS_ZERO;
+	return 1;
+}
+
+/* build the list of the values of members that are in service and find when it next changes */
+static void aggregate_activate(AGGREGATION *aggr)
+{
+	unsigned int n;
+	TIMESTAMP t1 = global_clock, t2 = TS_NEVER;
+	aggr->n_active = 0;
+	for ( n=0 ; n<aggr->n_members ; n++ )
+	{
+		OBJECT *obj = aggr->member[n];
+		if ( obj->in_svc >= t1 )
+		{	/* goes in service the second after in_svc */
+			if ( obj->in_svc < t2 ) t2 = obj->in_svc+1;
+		}
+		else if ( obj->out_svc <= t1 )
+			; /* out of service for good */
+		else
+		{
+			if ( obj->out_svc < t2 ) t2 = obj->out_svc;
+			aggr->active[aggr->n_active++] = aggr->value[n];
+		}
+	}
+	aggr->valid_from = t1;
+	aggr->valid_to = t2;
+}
+
+/* copy values into a contiguous buffer, converting units and taking parts as required */
+static void aggregate_gather(AGGREGATION *aggr, void **addr, unsigned int n, double *x)
+{
+	unsigned int i;
+	switch (aggr->pinfo->ptype) {
+	case PT_complex:
+	case PT_enduse:
+		switch (aggr->part) {
+		case AP_REAL: for ( i=0 ; i<n ; i++ ) x[i] = ((complex*)addr[i])->r; break;
+		case AP_IMAG: for ( i=0 ; i<n ; i++ ) x[i] = ((complex*)addr[i])->i; break;
+		case AP_MAG: for ( i=0 ; i<n ; i++ ) x[i] = mag((complex*)addr[i]); break;
+		case AP_ARG: for ( i=0 ; i<n ; i++ ) x[i] = arg((complex*)addr[i]); break;
+		case AP_ANG: for ( i=0 ; i<n ; i++ ) x[i] = arg((complex*)addr[i])*180/PI; break;
+		default: break;
+		}
+		break;
+	default:
+		if ( aggr->pinfo->unit!=NULL && aggr->punit!=NULL )
+		{	/* same conversion as unit_convert_ex() */
+			double from = aggr->pinfo->unit->b, to = aggr->punit->b;
+			double ratio = aggr->pinfo->unit->a / aggr->punit->a;
+			for ( i=0 ; i<n ; i++ ) x[i] = (*(double*)addr[i] - from) * ratio + to;
+		}
+		else
+		{
+			for ( i=0 ; i<n ; i++ ) x[i] = *(double*)addr[i];
+		}
+		break;
+	}
+	if ( (aggr->flags&AF_ABS)==AF_ABS )
+	{
+		for ( i=0 ; i<n ; i++ ) x[i] = fabs(x[i]);
+	}
+}
+
+/* The reduction kernels below use four independent accumulators so that the
+   compiler can keep them in vector registers and the additions do not wait on
+   each other. */
+static double reduce_sum(double *x, unsigned int n)
+{
+	double s0=0, s1=0, s2=0, s3=0;
+	unsigned int i;
+	for ( i=0 ; i+4<=n ; i+=4 )
+	{
+		s0 += x[i]; s1 += x[i+1]; s2 += x[i+2]; s3 += x[i+3];
+	}
+	for ( ; i<n ; i++ ) s0 += x[i];
+	return (s0+s1)+(s2+s3);
+}
+
+static double reduce_sumsq(double *x, unsigned int n, double mean)
+{
+	double s0=0, s1=0, s2=0, s3=0;
+	unsigned int i;
+	for ( i=0 ; i+4<=n ; i+=4 )
+	{
+		double d0=x[i]-mean, d1=x[i+1]-mean, d2=x[i+2]-mean, d3=x[i+3]-mean;
+		s0 += d0*d0; s1 += d1*d1; s2 += d2*d2; s3 += d3*d3;
+	}
+	for ( ; i<n ; i++ ) s0 += (x[i]-mean)*(x[i]-mean);
+	return (s0+s1)+(s2+s3);
+}
+
+static double reduce_prod(double *x, unsigned int n)
+{
+	double p0=1, p1=1, p2=1, p3=1;
+	unsigned int i;
+	for ( i=0 ; i+4<=n ; i+=4 )
+	{
+		p0 *= x[i]; p1 *= x[i+1]; p2 *= x[i+2]; p3 *= x[i+3];
+	}
+	for ( ; i<n ; i++ ) p0 *= x[i];
+	return (p0*p1)*(p2*p3);
+}
+
+static double reduce_min(double *x, unsigned int n)
+{
+	double m0=x[0], m1=x[0], m2=x[0], m3=x[0];
+	unsigned int i;
+	for ( i=0 ; i+4<=n ; i+=4 )
+	{
+		m0 = x[i]<m0 ? x[i] : m0; m1 = x[i+1]<m1 ? x[i+1] : m1;
+		m2 = x[i+2]<m2 ? x[i+2] : m2; m3 = x[i+3]<m3 ? x[i+3] : m3;
+	}
+	for ( ; i<n ; i++ ) m0 = x[i]<m0 ? x[i] : m0;
+	m0 = m1<m0 ? m1 : m0; m2 = m3<m2 ? m3 : m2;
+	return m2<m0 ? m2 : m0;
+}
+
+static double reduce_max(double *x, unsigned int n)
+{
+	double m0=x[0], m1=x[0], m2=x[0], m3=x[0];
+	unsigned int i;
+	for ( i=0 ; i+4<=n ; i+=4 )
+	{
+		m0 = x[i]>m0 ? x[i] : m0; m1 = x[i+1]>m1 ? x[i+1] : m1;
+		m2 = x[i+2]>m2 ? x[i+2] : m2; m3 = x[i+3]>m3 ? x[i+3] : m3;
+	}
+	for ( ; i<n ; i++ ) m0 = x[i]>m0 ? x[i] : m0;
+	m0 = m1>m0 ? m1 : m0; m2 = m3>m2 ? m3 : m2;
+	return m2>m0 ? m2 : m0;
+}
+
+/* combine the partial result b into a, in that order */
+static void aggregate_combine(AGGRBLOCK *a, AGGRBLOCK *b)
+{
+	if ( b->n==0 )
+		return;
+	if ( a->n==0 )
+	{
+		a->n = b->n; a->sum = b->sum; a->prod = b->prod;
+		a->min = b->min; a->max = b->max;
+		a->mean = b->mean; a->m2 = b->m2; a->logsum = b->logsum;
+	}
+	else
+	{	/* pairwise update of the mean and sum of squares (Chan et al., 1979) */
+		double n = (double)a->n + (double)b->n;
+		double delta = b->mean - a->mean;
+		a->m2 += b->m2 + delta*delta*((double)a->n*(double)b->n/n);
+		a->mean += delta*((double)b->n/n);
+		a->n += b->n;
+		a->sum += b->sum;
+		a->prod *= b->prod;
+		if ( b->min<a->min ) a->min = b->min;
+		if ( b->max>a->max ) a->max = b->max;
+		a->logsum += b->logsum;
+	}
+}
+
+/* run the reduction kernel over a block of active values */
+static void aggregate_block(unsigned int thread, void *item, void *arg)
+{
+	AGGRBLOCK *block = (AGGRBLOCK*)item;
+	AGGREGATION *aggr = block->aggr;
+	double x[AGGR_BUFSIZE];
+	unsigned int i;
+	block->n = 0;
+	block->sum = block->mean = block->m2 = block->logsum = 0;
+	block->prod = 1;
+	block->min = block->max = 0;
+	for ( i=block->first ; i<block->last ; i+=AGGR_BUFSIZE )
+	{
+		AGGRBLOCK part;
+		unsigned int n = block->last-i<AGGR_BUFSIZE ? block->last-i : AGGR_BUFSIZE;
+		aggregate_gather(aggr,aggr->active+i,n,x);
+		memset(&part,0,sizeof(part));
+		part.n = n;
+		part.prod = 1;
+		switch (aggr->op) {
+		case AGGR_MIN:
+			part.min = reduce_min(x,n);
+			break;
+		case AGGR_MAX:
+			part.max = reduce_max(x,n);
+			break;
+		case AGGR_AVG:
+		case AGGR_MEAN:
+		case AGGR_SUM:
+			part.sum = reduce_sum(x,n);
+			break;
+		case AGGR_PROD:
+			part.prod = reduce_prod(x,n);
+			break;
+		case AGGR_MBE:
+		case AGGR_STD:
+		case AGGR_VAR:
+			part.sum = reduce_sum(x,n);
+			part.mean = part.sum/n;
+			part.m2 = reduce_sumsq(x,n,part.mean);
+			break;
+		case AGGR_GAMMA:
+			{	unsigned int k;
+				part.min = reduce_min(x,n);
+				for ( k=0 ; k<n ; k++ ) x[k] = log(x[k]);
+				part.logsum = reduce_sum(x,n);
 			}
 			break;
 		default:
 			break;
 		}
+		aggregate_combine(block,&part);
+	}
+}
 
-		if (pdouble!=NULL || pcomplex!=NULL) /* valid value */
+/** This function performs an aggregate calculation given by the aggregation.
+
+	The first call builds an array of the addresses of the property of each
+	member of the group.  The array is only rebuilt when the membership of
+	a non-constant group changes.  A second array holds the members that are
+	in service and it is only rebuilt when the clock passes the time at which
+	a member goes in or out of service.  The values are then gathered into a
+	small contiguous buffer and reduced by the kernels above.  Large groups
+	are split into blocks that are reduced in parallel by the core executor,
+	and the partial results are combined in block order so the result does
+	not depend on the number of threads.
+ **/
+double aggregate_value(AGGREGATION *aggr) /**< the aggregation to perform */
+{
+	double numerator=0, denominator=0, secondary=0;
+	AGGRBLOCK total;
+
+	/* non-constant groups need search program rerun */
+	if ((aggr->group->constflags & CF_CONSTANT) != CF_CONSTANT){
+		FINDLIST *list = find_runpgm(NULL,aggr->group); /** @todo use constant part instead of NULL (ticket #3) */
+		if ( list!=NULL && aggr->last!=NULL && list->result_size==aggr->last->result_size 
+			&& list->hit_count==aggr->last->hit_count && memcmp(list->result,aggr->last->result,list->result_size)==0 )
+		{	/* membership has not changed */
+			free(list);
+		}
+		else
+		{
+			free(aggr->last);
+			aggr->last = list;
+			free(aggr->member);
+			aggr->member = NULL;
+		}
+	}
+	if ( aggr->member==NULL && aggr->last!=NULL && !aggregate_compile(aggr) )
+	{
+		aggr->n_members = 0;
+		aggr->valid_to = TS_ZERO;
+		free(aggr->member);
+		aggr->member = NULL;
+		return QNAN;
+	}
+
+	/* add time-sensitivity to verify that we are only aggregating objects that are in-service and not out-service. */
+	if ( global_clock<aggr->valid_from || global_clock>=aggr->valid_to )
+		aggregate_activate(aggr);
+
+	memset(&total,0,sizeof(total));
+	total.prod = 1;
+	if ( aggr->n_active>0 )
+	{
+		EXECUTOR *ex = exec_get_executor();
+		unsigned int n_threads = ex ? executor_get_threadcount(ex) : 1;
+		if ( aggr->n_active>=AGGR_PARALLEL && n_threads>1 )
 		{
-			if ((aggr->flags&AF_ABS)==AF_ABS) value=fabs(value);
-			switch (aggr->op) {
-			case AGGR_MIN:
-				if (value<numerator || denominator==0) numerator=value;
-				denominator = 1;
-				break;
-			case AGGR_MAX:
-				if (value>numerator || denominator==0) numerator=value;
-				denominator = 1;
-				break;
-			case AGGR_COUNT:
-				numerator++;
-				denominator=1;
-				break;
-			case AGGR_MBE:
-				denominator++;
-				numerator += value;
-				secondary += (value-secondary)/denominator;
-				break;
-			case AGGR_AVG:
-			case AGGR_MEAN:
-				numerator+=value;
-				denominator++;
-				break;
-			case AGGR_SUM:
-				numerator+=value;
-				denominator = 1;
-				break;
-			case AGGR_PROD:
-				numerator*=value;
-				denominator = 1;
-				break;
-			case AGGR_GAMMA:
-				denominator+=log(value);
-				if (numerator==0 || secondary>value)
-					secondary = value;
-				numerator++;
-				break;
-			case AGGR_STD:
-			case AGGR_VAR:
-				denominator++;
-				// note this uses a compensated on-line algorithm (see Knuth 1998)
-				// it's better than the obvious method because it doesn't suffer from numerical instability when mean(x)-x is near zero
-				{	double delta = value-secondary;
-					secondary += delta/denominator;
-					numerator += delta*(value-secondary);
+			unsigned int n_blocks = n_threads*AGGR_BLOCKSPERTHREAD, n;
+			unsigned int size = (aggr->n_active+n_blocks-1)/n_blocks;
+			AGGRBLOCK **item;
+			if ( aggr->n_blocks<n_blocks )
+			{	/* the item array used by the executor follows the blocks */
+				AGGRBLOCK *block = (AGGRBLOCK*)realloc(aggr->block,(sizeof(AGGRBLOCK)+sizeof(AGGRBLOCK*))*n_blocks);
+				if ( block==NULL )
+				{
+					output_error("aggregate_value(): memory allocation failed");
+					/* TROUBLESHOOT
+						There was not enough memory to split an aggregation among threads.
+						Try reducing the size of your model, freeing up more memory, or reducing the thread count.
+					 */
+					return QNAN;
 				}
-				break;
-			case AGGR_SKEW:
-			case AGGR_KUR:
-			default:
-				break;
+				aggr->block = block;
+				aggr->n_blocks = n_blocks;
+			}
+			item = (AGGRBLOCK**)(aggr->block+aggr->n_blocks);
+			for ( n=0 ; n<n_blocks ; n++ )
+			{
+				aggr->block[n].aggr = aggr;
+				aggr->block[n].first = n*size<aggr->n_active ? n*size : aggr->n_active;
+				aggr->block[n].last = (n+1)*size<aggr->n_active ? (n+1)*size : aggr->n_active;
+				item[n] = aggr->block+n;
 			}
+			executor_run(ex,(void**)item,n_blocks,1,aggregate_block,NULL);
+			for ( n=0 ; n<n_blocks ; n++ )
+				aggregate_combine(&total,aggr->block+n);
+		}
+		else
+		{
+			total.aggr = aggr;
+			total.first = 0;
+			total.last = aggr->n_active;
+			aggregate_block(0,&total,NULL);
 		}
 	}
+
+	/* convert the totals to the terms used by the final calculation */
+	switch (aggr->op) {
+	case AGGR_MIN:
+		numerator = total.n>0 ? total.min : 0;
+		denominator = total.n>0 ? 1 : 0;
+		break;
+	case AGGR_MAX:
+		numerator = total.n>0 ? total.max : 0;
+		denominator = total.n>0 ? 1 : 0;
+		break;
+	case AGGR_COUNT:
+		numerator = total.n;
+		denominator = total.n>0 ? 1 : 0;
+		break;
+	case AGGR_MBE:
+		numerator = total.sum;
+		denominator = total.n;
+		secondary = total.mean;
+		break;
+	case AGGR_AVG:
+	case AGGR_MEAN:
+		numerator = total.sum;
+		denominator = total.n;
+		break;
+	case AGGR_SUM:
+		numerator = total.sum;
+		denominator = total.n>0 ? 1 : 0;
+		break;
+	case AGGR_PROD:
+		numerator = total.n>0 ? total.prod : 0;
+		denominator = total.n>0 ? 1 : 0;
+		break;
+	case AGGR_GAMMA:
+		numerator = total.n;
+		denominator = total.logsum;
+		secondary = total.n>0 ? total.min : 0;
+		break;
+	case AGGR_STD:
+	case AGGR_VAR:
+		numerator = total.m2;
+		denominator = total.n;
+		secondary = total.mean;
+		break;
+	default:
+		break;
+	}
 	switch (aggr->op) {
-		double v = 0.0, t = 0.0, m = 0.0;
 	case AGGR_GAMMA:
 		return 1 + numerator/(denominator-numerator*log(secondary));
 	case AGGR_STD:
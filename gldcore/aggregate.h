@@ -9,6 +9,7 @@
 #define _AGGREGATE_H
 
 #include "platform.h"
+#include "timestamp.h"
 #include "find.h"
 
 typedef enum {AGGR_NOP, AGGR_MIN, AGGR_MAX, AGGR_AVG, AGGR_STD, AGGR_MBE, AGGR_MEAN, AGGR_VAR, AGGR_SKEW, AGGR_KUR, AGGR_GAMMA, AGGR_COUNT, AGGR_SUM, AGGR_PROD} AGGREGATOR; /**< the aggregation method to use */
@@ -26,6 +27,15 @@ typedef struct s_aggregate {
 	unsigned char flags; /**< aggregation flags (e.g., AF_ABS) */
 	struct s_findlist *last; /**< the result of the last run */
 	struct s_aggregate *next; /**< the next aggregation in the core's list of aggregators */
+	struct s_object_list **member; /**< the members of the group that have the property */
+	void **value; /**< the address of the property of each member */
+	unsigned int n_members; /**< the number of members */
+	void **active; /**< the address of the property of each member that is in service */
+	unsigned int n_active; /**< the number of members in service */
+	TIMESTAMP valid_from; /**< the time at which the active list was built */
+	TIMESTAMP valid_to; /**< the time at which a member next goes in or out of service */
+	struct s_aggrblock *block; /**< the blocks used to split the calculation among threads */
+	unsigned int n_blocks; /**< the number of blocks */
 } AGGREGATION; /**< the aggregation type */
 
 #ifdef __cplusplus
@@ -0,0 +1,260 @@
+/*  $Id$
+ *  Copyright (C) 2008 Battelle Memorial Institute
+ *
+ *  Per-class object arenas.
+ *
+ *  See arena.h for a description of the arena layout.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef WIN32
+#include <malloc.h>
+#else
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "arena.h"
+#include "class.h"
+#include "output.h"
+#include "lock.h"
+
+/* flag for move_pages() to move pages that are used only by this process (see numaif.h) */
+#ifndef MPOL_MF_MOVE
+#define MPOL_MF_MOVE (1<<1)
+#endif
+
+/* maximum number of pages moved by one call to move_pages() */
+#define ARENA_MAXPAGES 16
+
+/** Chunk header, at the start of each chunk **/
+typedef struct s_arenachunk {
+	struct s_arenachunk *next; /**< next chunk of the same arena */
+	unsigned int used; /**< number of slots in use */
+} ARENACHUNK;
+
+/** Size of the chunk header, rounded up so that the first slot starts on a cache line **/
+#define ARENA_HEADER (((sizeof(ARENACHUNK)+ARENA_LINESIZE-1)/ARENA_LINESIZE)*ARENA_LINESIZE)
+
+/** Arena of a class **/
+typedef struct s_arena {
+	size_t slotsize; /**< size of a slot (a multiple of the cache line size) */
+	size_t chunksize; /**< size and alignment of a chunk (a power of 2) */
+	unsigned int capacity; /**< number of slots in a chunk */
+	unsigned int count; /**< number of objects in the arena */
+	ARENACHUNK *first; /**< first chunk */
+	ARENACHUNK *last; /**< last chunk (the one objects are allocated from) */
+	unsigned int lock; /**< lock used while objects are allocated */
+} ARENA;
+
+/* lock used while the arena of a class is created */
+static unsigned int create_lock = 0;
+
+static void *chunk_alloc(size_t size)
+{
+	void *ptr = NULL;
+#ifdef WIN32
+	ptr = _aligned_malloc(size,size);
+#else
+	if ( posix_memalign(&ptr,size,size)!=0 )
+		ptr = NULL;
+#endif
+	return ptr;
+}
+
+static void chunk_free(void *ptr)
+{
+#ifdef WIN32
+	_aligned_free(ptr);
+#else
+	free(ptr);
+#endif
+}
+
+/* slot n of a chunk */
+static OBJECT *chunk_slot(ARENA *arena, ARENACHUNK *chunk, unsigned int n)
+{
+	return (OBJECT*)((char*)chunk + ARENA_HEADER + n*arena->slotsize);
+}
+
+static ARENA *arena_create(CLASS *oclass)
+{
+	ARENA *arena = (ARENA*)malloc(sizeof(ARENA));
+	if ( arena==NULL )
+		return NULL;
+	memset(arena,0,sizeof(ARENA));
+	arena->slotsize = ((sizeof(OBJECT)+oclass->size+ARENA_LINESIZE-1)/ARENA_LINESIZE)*ARENA_LINESIZE;
+	arena->chunksize = ARENA_MINCHUNK;
+	while ( arena->chunksize < ARENA_HEADER + ARENA_MINSLOTS*arena->slotsize )
+		arena->chunksize *= 2;
+	arena->capacity = (unsigned int)((arena->chunksize - ARENA_HEADER) / arena->slotsize);
+	return arena;
+}
+
+/** Allocate an object from the arena of its class.
+	@return a pointer to the zeroed object header, or \p NULL if memory allocation failed
+ **/
+OBJECT *arena_alloc(CLASS *oclass) /**< the class of the object */
+{
+	ARENA *arena;
+	OBJECT *obj = NULL;
+
+	wlock(&create_lock);
+	if ( oclass->arena==NULL )
+		oclass->arena = arena_create(oclass);
+	wunlock(&create_lock);
+	arena = oclass->arena;
+	if ( arena==NULL )
+		return NULL;
+
+	wlock(&arena->lock);
+	if ( arena->last==NULL || arena->last->used==arena->capacity )
+	{
+		ARENACHUNK *chunk = (ARENACHUNK*)chunk_alloc(arena->chunksize);
+		if ( chunk!=NULL )
+		{
+			chunk->next = NULL;
+			chunk->used = 0;
+			if ( arena->last==NULL )
+				arena->first = chunk;
+			else
+				arena->last->next = chunk;
+			arena->last = chunk;
+		}
+	}
+	if ( arena->last!=NULL && arena->last->used<arena->capacity )
+	{
+		obj = chunk_slot(arena,arena->last,arena->last->used++);
+		memset(obj,0,arena->slotsize);
+		arena->count++;
+	}
+	wunlock(&arena->lock);
+	return obj;
+}
+
+/** Check whether an object was allocated from an arena
+	@return non-zero if the object is in the arena of its class
+ **/
+int arena_contains(OBJECT *obj) /**< the object */
+{
+	ARENA *arena = obj->oclass ? obj->oclass->arena : NULL;
+	ARENACHUNK *chunk;
+	if ( arena==NULL )
+		return 0;
+	for ( chunk=arena->first ; chunk!=NULL ; chunk=chunk->next )
+	{
+		if ( (char*)obj>=(char*)chunk_slot(arena,chunk,0) && (char*)obj<(char*)chunk_slot(arena,chunk,chunk->used) )
+			return 1;
+	}
+	return 0;
+}
+
+/** Release the arenas of all the classes.
+	All the objects allocated from the arenas are freed.
+ **/
+void arena_release(void)
+{
+	CLASS *oclass;
+	for ( oclass=class_get_first_class() ; oclass!=NULL ; oclass=oclass->next )
+	{
+		ARENA *arena = oclass->arena;
+		if ( arena!=NULL )
+		{
+			ARENACHUNK *chunk = arena->first;
+			while ( chunk!=NULL )
+			{
+				ARENACHUNK *next = chunk->next;
+				chunk_free(chunk);
+				chunk = next;
+			}
+			free(arena);
+			oclass->arena = NULL;
+		}
+	}
+}
+
+/** Get the first object in the arena of a class
+	@return the first object created in the class, or \p NULL if none
+ **/
+OBJECT *arena_get_first(CLASS *oclass) /**< the class */
+{
+	ARENA *arena = oclass->arena;
+	if ( arena==NULL || arena->first==NULL || arena->first->used==0 )
+		return NULL;
+	return chunk_slot(arena,arena->first,0);
+}
+
+/** Get the next object in the arena of a class
+	@return the object created after \p obj in the same class, or \p NULL if none
+ **/
+OBJECT *arena_get_next(OBJECT *obj) /**< an object returned by #arena_get_first() or #arena_get_next() */
+{
+	ARENA *arena = obj->oclass->arena;
+	ARENACHUNK *chunk = (ARENACHUNK*)((size_t)obj & ~(arena->chunksize-1));
+	OBJECT *next = (OBJECT*)((char*)obj + arena->slotsize);
+	if ( (char*)next < (char*)chunk_slot(arena,chunk,chunk->used) )
+		return next;
+	else if ( chunk->next!=NULL && chunk->next->used>0 )
+		return chunk_slot(arena,chunk->next,0);
+	else
+		return NULL;
+}
+
+/** Get the number of objects in the arena of a class
+ **/
+unsigned int arena_get_count(CLASS *oclass) /**< the class */
+{
+	return oclass->arena ? oclass->arena->count : 0;
+}
+
+/** Move the pages of an object to the NUMA node of the calling thread.
+	This is only supported on Linux and does nothing elsewhere, or when
+	the kernel does not support NUMA.
+ **/
+void arena_place(OBJECT *obj) /**< the object */
+{
+#if defined(__linux__) && defined(SYS_move_pages) && defined(SYS_getcpu)
+	static int unsupported = 0;
+	static size_t pagesize = 0;
+	unsigned int cpu, node;
+	char *begin, *end;
+	if ( unsupported )
+		return;
+	if ( pagesize==0 )
+		pagesize = (size_t)sysconf(_SC_PAGESIZE);
+	if ( syscall(SYS_getcpu,&cpu,&node,NULL)!=0 )
+	{
+		unsupported = 1;
+		return;
+	}
+	begin = (char*)((size_t)obj & ~(pagesize-1));
+	end = (char*)(obj+1) + obj->oclass->size;
+	while ( begin<end )
+	{
+		void *page[ARENA_MAXPAGES];
+		int nodes[ARENA_MAXPAGES], status[ARENA_MAXPAGES];
+		unsigned long n;
+		for ( n=0 ; n<ARENA_MAXPAGES && begin<end ; n++, begin+=pagesize )
+		{
+			page[n] = begin;
+			nodes[n] = (int)node;
+		}
+		if ( syscall(SYS_move_pages,0,n,page,nodes,status,MPOL_MF_MOVE)!=0 && (errno==ENOSYS || errno==EPERM) )
+		{
+			output_verbose("NUMA placement of objects is not supported by this system");
+			unsupported = 1;
+			return;
+		}
+	}
+#endif
+}
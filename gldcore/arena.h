@@ -0,0 +1,63 @@
+/** $Id$
+    Copyright (C) 2008 Battelle Memorial Institute
+
+@file arena.h
+@addtogroup arena Object arenas
+@ingroup core
+
+Objects are allocated from a separate arena for each class so that the
+objects of a class are stored contiguously in memory.  Each arena is a
+list of chunks, and each chunk holds a fixed number of slots.  A slot
+holds the OBJECT header followed by the class data, and is rounded up to
+a whole number of cache lines so that no two objects share a cache line.
+
+A chunk is aligned on its own size (always a power of 2), so the chunk
+that holds an object is found from the object's address alone.  This
+makes it possible to iterate over the objects of a class in the order
+they were created without keeping a separate list (see #arena_get_first()
+and #arena_get_next()).
+
+Objects are never freed individually; all the arenas are released
+together when the objects are removed.  Foreign objects and objects
+allocated while #global_object_arena is \p FALSE are not in any arena and
+are not visited by the arena iterators.
+
+When #global_numa_placement is \p TRUE the main loop asks each sync worker
+to move the pages of the objects it will sync to its own NUMA node before
+the first iteration (see #arena_place()).  The objects are initialized by
+the loader long before the workers exist, so this is done by migrating the
+pages rather than by having the workers touch them first.
+
+@{**/
+
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include "object.h"
+
+/** Size of a cache line, used to align chunks and object slots **/
+#define ARENA_LINESIZE 64
+
+/** Minimum chunk size **/
+#define ARENA_MINCHUNK 16384
+
+/** Minimum number of slots in a chunk **/
+#define ARENA_MINSLOTS 16
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+OBJECT *arena_alloc(CLASS *oclass);
+int arena_contains(OBJECT *obj);
+void arena_release(void);
+OBJECT *arena_get_first(CLASS *oclass);
+OBJECT *arena_get_next(OBJECT *obj);
+unsigned int arena_get_count(CLASS *oclass);
+void arena_place(OBJECT *obj);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /**@} _ARENA_H */
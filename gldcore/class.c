@@ -17,6 +17,7 @@
 #include "enduse.h"
 #include "stream.h"
 #include "random.h"
+#include "lock.h"
 
 SET_MYCONTEXT(DMC_CLASS)
 
@@ -51,6 +52,10 @@ extern struct s_property_specs property_type[_PT_LAST];
 static CLASS *first_class = NULL; /**< first class in class list */
 static CLASS *last_class = NULL; /**< last class in class list */
 
+/* property generation is changed whenever a property is added to a class or a class
+   inherits from another; property indexes built for an older generation are rebuilt */
+static unsigned int property_generation = 1;
+
 /** Get the first property in a class's property list.
 	All subsequent properties that have the same class
 	can be scanned.  Be careful not to scan off the end
@@ -182,8 +187,90 @@ static PROPERTY *find_header_property(CLASS *oclass,
 	return prop;
 }
 
+/* FNV-1a hash of a property name */
+static unsigned int property_hash(const char *name)
+{
+	unsigned int h = 2166136261u;
+	while ( *name!='\0' )
+	{
+		h ^= (unsigned char)(*name++);
+		h *= 16777619u;
+	}
+	return h;
+}
+
+/** Build the property name index of a class
+
+	The index includes the properties inherited from the parent classes.
+	Properties of a class hide properties with the same name in its parents,
+	so the index gives the same result as a search up the class hierarchy.
+
+	@return 1 on success, 0 on failure
+ **/
+static int class_build_property_index(CLASS *oclass)
+{
+	CLASS *pclass;
+	PROPERTY *prop, **slot;
+	unsigned int count=0, size=8, depth=0;
+
+	/* count the properties in the class hierarchy */
+	for ( pclass=oclass ; pclass!=NULL ; pclass=pclass->parent )
+	{
+		if ( depth++>class_count )
+			return 0; /* inheritance loop, reported by the hierarchy search */
+		for ( prop=pclass->pmap ; prop!=NULL && prop->oclass==pclass ; prop=prop->next )
+			count++;
+	}
+
+	/* keep the table at most half full */
+	while ( size<2*count )
+		size *= 2;
+	slot = (PROPERTY**)malloc(sizeof(PROPERTY*)*size);
+	if ( slot==NULL )
+		return 0;
+	memset(slot,0,sizeof(PROPERTY*)*size);
+
+	/* insert the class's own properties before those of its parents */
+	for ( pclass=oclass ; pclass!=NULL ; pclass=pclass->parent )
+	{
+		for ( prop=pclass->pmap ; prop!=NULL && prop->oclass==pclass ; prop=prop->next )
+		{
+			unsigned int h = property_hash(prop->name)&(size-1);
+			while ( slot[h]!=NULL && strcmp(slot[h]->name,prop->name)!=0 )
+				h = (h+1)&(size-1);
+			if ( slot[h]==NULL )
+				slot[h] = prop;
+		}
+	}
+
+	if ( oclass->pindex.slot!=NULL )
+		free(oclass->pindex.slot);
+	oclass->pindex.slot = slot;
+	oclass->pindex.size = size;
+	oclass->pindex.generation = property_generation;
+	return 1;
+}
+
+/* issue the deprecation warning for a property found in a class */
+static void check_deprecated(CLASS *oclass, PROPERTYNAME name, PROPERTY *prop)
+{
+	if (prop->flags&PF_DEPRECATED && !(prop->flags&PF_DEPRECATED_NONOTICE) && !global_suppress_deprecated_messages)
+	{
+		output_warning("class_find_property(CLASS *oclass='%s', PROPERTYNAME name='%s': property is deprecated", oclass->name, name);
+		/* TROUBLESHOOT
+			You have done a search on a property that has been flagged as deprecated and will most likely not be supported soon.
+			Correct the usage of this property to get rid of this message.
+		 */
+		if (global_suppress_repeat_messages)
+			prop->flags |= ~PF_DEPRECATED_NONOTICE;
+	}
+}
+
 /** Find the named property in the class
 
+	The search uses the class's property name index, which is rebuilt
+	as needed when properties are added to the class or its parents.
+
 	@return a pointer to the PROPERTY, or \p NULL if the property is not found.
  **/
 PROPERTY *class_find_property(CLASS *oclass,     /**< the object class */
@@ -195,20 +282,39 @@ PROPERTY *class_find_property(CLASS *oclass,     /**< the object class */
 	if(oclass == NULL)
 		return NULL;
 
-	for (prop=oclass->pmap; prop!=NULL && prop->oclass==oclass; prop=prop->next)
+	/* update the property index if the class hierarchy has changed */
+	if ( oclass->pindex.generation!=property_generation )
 	{
-		if (strcmp(name,prop->name)==0)
+		wlock(&oclass->pindex.lock);
+		if ( oclass->pindex.generation!=property_generation )
+			class_build_property_index(oclass);
+		wunlock(&oclass->pindex.lock);
+	}
+
+	/* search the property index */
+	if ( oclass->pindex.generation==property_generation )
+	{
+		unsigned int mask = oclass->pindex.size-1;
+		unsigned int h = property_hash(name)&mask;
+		while ( (prop=oclass->pindex.slot[h])!=NULL )
 		{
-			if (prop->flags&PF_DEPRECATED && !(prop->flags&PF_DEPRECATED_NONOTICE) && !global_suppress_deprecated_messages)
+			if ( strcmp(name,prop->name)==0 )
 			{
-				output_warning("class_find_property(CLASS *oclass='%s', PROPERTYNAME name='%s': property is deprecated", oclass->name, name);
-				/* TROUBLESHOOT
-					You have done a search on a property that has been flagged as deprecated and will most likely not be supported soon.
-					Correct the usage of this property to get rid of this message.
-				 */
-				if (global_suppress_repeat_messages)
-					prop->flags |= ~PF_DEPRECATED_NONOTICE;
+				if ( prop->oclass==oclass )
+					check_deprecated(oclass,name,prop);
+				return prop;
 			}
+			h = (h+1)&mask;
+		}
+		return NULL;
+	}
+
+	/* index is not available, search the class hierarchy */
+	for (prop=oclass->pmap; prop!=NULL && prop->oclass==oclass; prop=prop->next)
+	{
+		if (strcmp(name,prop->name)==0)
+		{
+			check_deprecated(oclass,name,prop);
 			return prop;
 		}
 	}
@@ -239,6 +345,7 @@ void class_add_property(CLASS *oclass,  /**< the class to which the property is
 		oclass->pmap = prop;
 	else
 		last->next = prop;
+	property_generation++;
 }
 
 /** Add an extended property to a class 
@@ -667,6 +774,7 @@ int class_define_map(CLASS *oclass, /**< the object class */
 					char *classname = va_arg(arg,char*);
 					PASSCONFIG no_override;
 					oclass->parent = class_get_class_from_classname_in_module(classname,oclass->module);
+					property_generation++;
 					if (oclass->parent==NULL)
 					{
 						errno = EINVAL;
@@ -975,6 +1083,7 @@ int class_define_map(CLASS *oclass, /**< the object class */
 		}
 	}
 	va_end(arg);
+	class_build_property_index(oclass);
 	return count;
 Error:
 	if (prop!=NULL)
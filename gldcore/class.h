@@ -117,6 +117,13 @@ struct s_class_list {
 		int32 count;
 	} profiler;
 	TECHNOLOGYREADINESSLEVEL trl; // technology readiness level (1-9, 0=unknown)
+	struct {
+		PROPERTY **slot; /**< open-addressing table of properties by name, including inherited properties */
+		unsigned int size; /**< number of slots (a power of 2) */
+		unsigned int generation; /**< property generation the index was built for */
+		unsigned int lock; /**< lock used while the index is rebuilt */
+	} pindex; /**< property name index (see class_find_property) */
+	struct s_arena *arena; /**< arena the objects of this class are allocated from (see arena.h) */
 	bool has_runtime;	///< flag indicating that a runtime dll, so, or dylib is in use
 	char runtime[1024]; ///< name of file containing runtime dll, so, or dylib
 	struct s_class_list *next;
@@ -17,6 +17,7 @@
 #include "deltamode.h"
 #include "output.h"
 #include "realtime.h"
+#include "exec.h"
 
 SET_MYCONTEXT(DMC_DELTAMODE)
 
@@ -24,6 +25,24 @@ static OBJECT **delta_objectlist = NULL; /* qualified object list */
 static int delta_objectcount = 0; /* qualified object count */
 static MODULE **delta_modulelist = NULL; /* qualified module list */
 static int delta_modulecount = 0; /* qualified module count */
+static OBJECT **delta_updatelist = NULL; /* qualified objects having an update function, in rank order */
+static int *delta_rankstart = NULL; /* index of the first object of each rank in the update list (plus end of list) */
+static int delta_rankcount = 0; /* number of ranks in the update list */
+
+/* per-worker results of a parallel object update */
+typedef struct s_deltaworker {
+	SIMULATIONMODE mode; /* most demanding mode returned to this worker */
+	OBJECT *failed; /* object whose update failed */
+	char pad[64]; /* padding to prevent false sharing */
+} DELTAWORKER;
+static DELTAWORKER *delta_worker = NULL;
+static unsigned int delta_workercount = 0;
+
+/* arguments of a parallel object update */
+struct delta_updatedata {
+	DT timestep;
+	unsigned int iteration_count;
+};
 
 /* profile data structure */
 static DELTAPROFILE profile;
@@ -203,6 +222,34 @@ STATUS delta_init(void)
 	rankcount = NULL;
 	free(ranklist);
 	ranklist = NULL;
+
+	/* build the update list and rank index used by parallel updates */
+	if ( global_deltamode_updatemode==DMU_PARALLEL )
+	{
+		int m, n_update = 0;
+		delta_updatelist = (OBJECT**)malloc(sizeof(OBJECT*)*delta_objectcount);
+		delta_rankstart = (int*)malloc(sizeof(int)*(delta_objectcount+1));
+		if ( delta_updatelist==NULL || delta_rankstart==NULL )
+		{
+			output_error("unable to allocate memory for deltamode update list");
+			/* TROUBLESHOOT
+			  Deltamode operation requires more memory than is available.
+			  Try freeing up memory by making more heap available or making the model smaller. 
+			 */
+			return FAILED;
+		}
+		for ( m=0 ; m<delta_objectcount ; m++ )
+		{
+			obj = delta_objectlist[m];
+			if ( !obj->oclass->update )
+				continue;
+			if ( n_update==0 || delta_updatelist[n_update-1]->rank!=obj->rank )
+				delta_rankstart[delta_rankcount++] = n_update;
+			delta_updatelist[n_update++] = obj;
+		}
+		delta_rankstart[delta_rankcount] = n_update;
+		IN_MYCONTEXT output_debug("deltamode parallel update list has %d objects in %d ranks", n_update, delta_rankcount);
+	}
 Success:
 	profile.t_init += clock() - t;
 	return SUCCESS;
@@ -241,6 +288,105 @@ DT delta_modedesired(DELTAMODEFLAGS *flags)
 	return dt_desired;
 }
 
+/* update one object on behalf of delta_objectupdate() */
+static void delta_objectproc(unsigned int thread, void *item, void *arg)
+{
+	OBJECT *obj = (OBJECT*)item;
+	DELTAWORKER *worker = &delta_worker[thread];
+	struct delta_updatedata *data = (struct delta_updatedata*)arg;
+	if ( obj->in_svc_double<=global_delta_curr_clock && obj->out_svc_double>=global_delta_curr_clock )
+	{
+		switch ( obj->oclass->update(obj,global_clock,global_deltaclock,data->timestep,data->iteration_count) ) {
+		case SM_DELTA_ITER:
+			if ( worker->mode!=SM_ERROR )
+				worker->mode = SM_DELTA_ITER;
+			break;
+		case SM_DELTA:
+			if ( worker->mode==SM_EVENT )
+				worker->mode = SM_DELTA;
+			break;
+		case SM_ERROR:
+			if ( worker->failed==NULL )
+				worker->failed = obj;
+			worker->mode = SM_ERROR;
+			break;
+		case SM_EVENT:
+		default: /* mode remains untouched */
+			break;
+		}
+	}
+}
+
+/** Update the deltamode objects concurrently (deltamode_updatemode PARALLEL)
+
+	The ranks are updated in the same order as the serial update, but the
+	objects within a rank are divided among the threads of the main loop
+	executor.  Objects of the same rank have no parent/child relationship
+	among them, but their update functions must otherwise be safe to call
+	concurrently.
+
+	@return the most demanding mode requested by the objects, or SM_ERROR
+	with the object that failed in \p failed
+ **/
+static SIMULATIONMODE delta_objectupdate(DT timestep, unsigned int iteration_count_val, OBJECT **failed)
+{
+	EXECUTOR *ex = exec_get_executor();
+	unsigned int n_workers = ex ? executor_get_threadcount(ex) : 1;
+	SIMULATIONMODE mode = SM_EVENT;
+	struct delta_updatedata data;
+	unsigned int n;
+	int r;
+
+	if ( delta_workercount<n_workers )
+	{
+		DELTAWORKER *worker = (DELTAWORKER*)realloc(delta_worker,sizeof(DELTAWORKER)*n_workers);
+		if ( worker==NULL )
+		{
+			output_error("unable to allocate memory for deltamode workers");
+			/* TROUBLESHOOT
+			  Deltamode operation requires more memory than is available.
+			  Try freeing up memory by making more heap available or making the model smaller. 
+			 */
+			*failed = NULL;
+			return SM_ERROR;
+		}
+		delta_worker = worker;
+		delta_workercount = n_workers;
+	}
+	for ( n=0 ; n<n_workers ; n++ )
+	{
+		delta_worker[n].mode = SM_EVENT;
+		delta_worker[n].failed = NULL;
+	}
+
+	data.timestep = timestep;
+	data.iteration_count = iteration_count_val;
+	for ( r=0 ; r<delta_rankcount ; r++ )
+	{
+		executor_run(ex,(void**)(delta_updatelist+delta_rankstart[r]),delta_rankstart[r+1]-delta_rankstart[r],0,delta_objectproc,&data);
+
+		/* stop at the first rank that failed */
+		for ( n=0 ; n<n_workers ; n++ )
+		{
+			if ( delta_worker[n].mode==SM_ERROR )
+			{
+				*failed = delta_worker[n].failed;
+				return SM_ERROR;
+			}
+		}
+	}
+
+	/* reduce the modes of the workers */
+	for ( n=0 ; n<n_workers ; n++ )
+	{
+		if ( delta_worker[n].mode==SM_DELTA_ITER )
+			mode = SM_DELTA_ITER;
+		else if ( delta_worker[n].mode==SM_DELTA && mode!=SM_DELTA_ITER )
+			mode = SM_DELTA;
+	}
+	return mode;
+}
+
 /** Run a series of delta mode updates until mode changes back to event mode
 	@return number of seconds to advance clock
  **/
@@ -305,44 +451,62 @@ DT delta_update(void)
 			/* Assume we are ready to go on, initially */
 			interupdate_mode = SM_EVENT;
 
-			/* Loop through objects with their individual updates */
-			for ( n=0 ; n<delta_objectcount ; n++ )
+			/* Update objects concurrently within each rank */
+			if ( delta_updatelist!=NULL )
 			{
-				d_obj = delta_objectlist[n];	/* Shouldn't need NULL checks, since they were done above */
-				d_oclass = d_obj->oclass;
-
-				/* See if the object is in service or not */
-				if ((d_obj->in_svc_double <= global_delta_curr_clock) && (d_obj->out_svc_double >= global_delta_curr_clock))
+				interupdate_mode = delta_objectupdate(timestep,delta_iteration_count,&d_obj);
+				if ( interupdate_mode==SM_ERROR )
 				{
-					if ( d_oclass->update )	/* Make sure it exists - init should handle this */
+					if ( d_obj!=NULL )
+						output_error("delta_update(): update failed for object \'%s\'", object_name(d_obj, temp_name_buff, 63));
+					/* TROUBLESHOOT
+					   An object failed to update correctly while operating in deltamode.
+					   Generally, this is an internal error and should be reported to the GridLAB-D developers.
+					 */
+					return DT_INVALID;
+				}
+			}
+			else
+			{
+				/* Loop through objects with their individual updates */
+				for ( n=0 ; n<delta_objectcount ; n++ )
+				{
+					d_obj = delta_objectlist[n];	/* Shouldn't need NULL checks, since they were done above */
+					d_oclass = d_obj->oclass;
+
+					/* See if the object is in service or not */
+					if ((d_obj->in_svc_double <= global_delta_curr_clock) && (d_obj->out_svc_double >= global_delta_curr_clock))
 					{
-						/* Call the object-level interupdate */
-						interupdate_mode_result = d_oclass->update(d_obj,global_clock,global_deltaclock,timestep,delta_iteration_count);
-
-						/* Check the status and handle appropriately */
-						switch ( interupdate_mode_result ) {
-							case SM_DELTA_ITER:
-								interupdate_mode = SM_DELTA_ITER;
-								break;
-							case SM_DELTA:
-								if (interupdate_mode != SM_DELTA_ITER)
-									interupdate_mode = SM_DELTA;
-								/* default else - leave it as is (SM_DELTA_ITER) */
-								break;
-							case SM_ERROR:
-								output_error("delta_update(): update failed for object \'%s\'", object_name(d_obj, temp_name_buff, 63));
-								/* TROUBLESHOOT
-								   An object failed to update correctly while operating in deltamode.
-								   Generally, this is an internal error and should be reported to the GridLAB-D developers.
-								 */
-								return DT_INVALID;
-							case SM_EVENT:
-							default: /* mode remains untouched */
-								break;
-						}
-					} /*End update exists */
-				}/* End in service */
-				/* Defaulted else, skip over it (not in service) */
+						if ( d_oclass->update )	/* Make sure it exists - init should handle this */
+						{
+							/* Call the object-level interupdate */
+							interupdate_mode_result = d_oclass->update(d_obj,global_clock,global_deltaclock,timestep,delta_iteration_count);
+
+							/* Check the status and handle appropriately */
+							switch ( interupdate_mode_result ) {
+								case SM_DELTA_ITER:
+									interupdate_mode = SM_DELTA_ITER;
+									break;
+								case SM_DELTA:
+									if (interupdate_mode != SM_DELTA_ITER)
+										interupdate_mode = SM_DELTA;
+									/* default else - leave it as is (SM_DELTA_ITER) */
+									break;
+								case SM_ERROR:
+									output_error("delta_update(): update failed for object \'%s\'", object_name(d_obj, temp_name_buff, 63));
+									/* TROUBLESHOOT
+									   An object failed to update correctly while operating in deltamode.
+									   Generally, this is an internal error and should be reported to the GridLAB-D developers.
+									 */
+									return DT_INVALID;
+								case SM_EVENT:
+								default: /* mode remains untouched */
+									break;
+							}
+						} /*End update exists */
+					}/* End in service */
+					/* Defaulted else, skip over it (not in service) */
+				}
 			}
 
 			/* send interupdate messages */
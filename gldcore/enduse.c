@@ -8,7 +8,6 @@
 #include <stdarg.h>
 #include <ctype.h>
 #include <math.h>
-#include <pthread.h>
 
 #include "platform.h"
 #include "output.h"
@@ -194,189 +193,40 @@ TIMESTAMP enduse_sync(enduse *e, PASSCONFIG pass, TIMESTAMP t1)
 	return (e->shape && e->shape->type != MT_UNKNOWN) ? e->shape->t2 : TS_NEVER;
 }
 
-typedef struct s_endusesyncdata {
-	unsigned int n;
-	pthread_t pt;
-	bool ok;
-	enduse *e;
-	unsigned int ne;
-	TIMESTAMP t0;
-	unsigned int ran;
-} ENDUSESYNCDATA;
-
-static pthread_cond_t start_ed = PTHREAD_COND_INITIALIZER;
-static pthread_mutex_t startlock_ed = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t done_ed = PTHREAD_COND_INITIALIZER;
-static pthread_mutex_t donelock_ed = PTHREAD_MUTEX_INITIALIZER;
-static TIMESTAMP next_t1_ed, next_t2_ed;
-static unsigned int donecount_ed;
-static unsigned int run = 0;
+static enduse **enduse_array = NULL;
+static unsigned int n_enduse_array = 0;
 
 clock_t enduse_synctime = 0;
 
-void *enduse_syncproc(void *ptr)
+static TIMESTAMP enduse_syncproc(unsigned int thread, void *item, void *arg)
 {
-	ENDUSESYNCDATA *data = (ENDUSESYNCDATA*)ptr;
-	enduse *e;
-	unsigned int n;
-	TIMESTAMP t2;
-
-	// begin processing loop
-	while (data->ok) 
-	{
-		// lock access to start condition
-		pthread_mutex_lock(&startlock_ed);
-
-		// wait for thread start condition
-		while (data->t0==next_t1_ed && data->ran==run) 
-			pthread_cond_wait(&start_ed,&startlock_ed);
-		
-		// unlock access to start count
-		pthread_mutex_unlock(&startlock_ed);
-
-		// process the list for this thread
-		t2 = TS_NEVER;
-		for ( e=data->e, n=0 ; e!=NULL, n<data->ne ; e=e->next, n++ )
-		{
-			TIMESTAMP t = enduse_sync(e, PC_PRETOPDOWN, next_t1_ed);
-			if (t<t2) t2 = t;
-		}
-
-		// signal completed condition
-		data->t0 = next_t1_ed;
-		data->ran++;
-
-		// lock access to done condition
-		pthread_mutex_lock(&donelock_ed);
-
-		// signal thread is done for now
-		donecount_ed--;
-		if ( t2<next_t2_ed ) next_t2_ed = t2;
-
-		// signal change in done condition
-		pthread_cond_broadcast(&done_ed);
-
-		// unlock access to done count
-		pthread_mutex_unlock(&donelock_ed);
-	}
-	pthread_exit((void*)0);
-	return (void*)0;
+	return enduse_sync((enduse*)item,PC_PRETOPDOWN,*(TIMESTAMP*)arg);
 }
 
 TIMESTAMP enduse_syncall(TIMESTAMP t1)
 {
-	static unsigned int n_threads_ed=0;
-	static ENDUSESYNCDATA *thread_ed = NULL;
-	TIMESTAMP t2 = TS_NEVER;
+	TIMESTAMP t2;
 	clock_t ts = (clock_t)exec_clock();
 	
 	// skip enduse_syncall if there's no enduse in the glm
 	if (n_enduses == 0)
 		return TS_NEVER;
 
-	// number of threads desired
-	if (n_threads_ed==0)
+	// build the enduse array used by the executor
+	if (n_enduse_array!=n_enduses)
 	{
 		enduse *e;
-		int n_items, en = 0;
-
+		unsigned int n = 0;
 		IN_MYCONTEXT output_debug("enduse_syncall setting up for %d enduses", n_enduses);
-
-		// determine needed threads
-		n_threads_ed = global_threadcount;
-		if (n_threads_ed>1)
-		{
-			unsigned int n;
-			if (n_enduses<n_threads_ed*4)
-				n_threads_ed = n_enduses/4;
-
-			// only need 1 thread if n_enduses is less than 4
-			if (n_threads_ed == 0)
-				n_threads_ed = 1;
-
-			// determine enduses per thread
-			n_items = n_enduses/n_threads_ed;
-			n_threads_ed = n_enduses/n_items;
-			if (n_threads_ed*n_items<n_enduses) // not enough slots yet
-				n_threads_ed++; // add one underused thread
-
-			IN_MYCONTEXT output_debug("enduse_syncall is using %d of %d available threads", n_threads_ed,global_threadcount);
-			IN_MYCONTEXT output_debug("enduse_syncall is assigning %d enduses per thread", n_items);
-
-			// allocate thread list
-			thread_ed = (ENDUSESYNCDATA*)malloc(sizeof(ENDUSESYNCDATA)*n_threads_ed);
-			memset(thread_ed,0,sizeof(ENDUSESYNCDATA)*n_threads_ed);
-
-			// assign starting enduse for each thread
-			for (e=enduse_list; e!=NULL; e=e->next)
-			{
-				if (thread_ed[en].ne==n_items)
-					en++;
-				if (thread_ed[en].ne==0)
-					thread_ed[en].e = e;
-				thread_ed[en].ne++;
-			}
-
-			// create threads
-			for (n=0; n<n_threads_ed; n++)
-			{
-				thread_ed[n].ok = true;
-				if (pthread_create(&(thread_ed[n].pt),NULL,enduse_syncproc,&(thread_ed[n]))!=0)
-				{
-					output_fatal("enduse_sync thread creation failed");
-					thread_ed[n].ok = false;
-				}
-				else 
-					thread_ed[n].n = n;
-			}
-		}
+		enduse_array = (enduse**)realloc(enduse_array,sizeof(enduse*)*n_enduses);
+		if (enduse_array==NULL)
+			throw_exception("enduse_syncall memory allocation failure");
+		for (e=enduse_list; e!=NULL && n<n_enduses; e=e->next)
+			enduse_array[n++] = e;
+		n_enduse_array = n;
 	}
 
-	// no threading required
-	if (n_threads_ed<2)
-	{
-		// process list directly
-		enduse *e;
-		for (e=enduse_list; e!=NULL; e=e->next)
-		{
-			TIMESTAMP t3 = enduse_sync(e, PC_PRETOPDOWN, t1);
-			if (t3<t2) t2 = t3;
-		}
-		next_t2_ed = t2;
-	}
-	else 
-	{
-		// lock access to done count
-		pthread_mutex_lock(&donelock_ed);
-
-		// initialize wait count
-		donecount_ed = n_threads_ed;
-
-		// lock access to start condition
-		pthread_mutex_lock(&startlock_ed);
-
-		// update start condition
-		next_t1_ed = t1;
-		next_t2_ed = TS_NEVER;
-		run++;
-
-		// signal all the threads
-		pthread_cond_broadcast(&start_ed);
-
-		// unlock access to start count
-		pthread_mutex_unlock(&startlock_ed);
-
-		// begin wait 
-		while (donecount_ed>0)
-			pthread_cond_wait(&done_ed,&donelock_ed);
-		IN_MYCONTEXT output_debug("passed donecount==0 condition");
-
-		// unclock done count
-		pthread_mutex_unlock(&donelock_ed);
-
-		// process results from all threads
-		if (next_t2_ed<t2) t2=next_t2_ed;
-	}
+	t2 = executor_run_min(exec_get_executor(),(void**)enduse_array,n_enduse_array,0,enduse_syncproc,&t1);
 
 	enduse_synctime += (clock_t)exec_clock() - ts;
 	return t2;
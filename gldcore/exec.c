@@ -87,6 +87,7 @@
 #include <signal.h>
 #include <ctype.h>
 #include <string.h>
+#include <errno.h>
 #include <sys/timeb.h>
 #ifdef WIN32
 #include <windows.h>
@@ -95,6 +96,7 @@
 #else
 #include <unistd.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -114,6 +116,9 @@
 #include "realtime.h"
 #include "module.h"
 #include "threadpool.h"
+#include "executor.h"
+#include "arena.h"
+#include "watchdog.h"
 #include "debug.h"
 #include "exception.h"
 #include "random.h"	
@@ -345,10 +350,67 @@ static STATUS show_progress(void)
 /***********************************************************************/
 /* CHECKPOINTS (DPC Apr 2011) */
 
+/* write a checkpoint file */
+static int checkpoint_write(char *fn, int opts)
+{
+	size_t len;
+	FILE *fp = fopen(fn,"w");
+	if ( fp==NULL )
+	{
+		output_error("unable to open checkpoint file '%s' for writing", fn);
+		return 0;
+	}
+	len = stream(fp,opts);
+	if ( fclose(fp)!=0 || len==0 || len==(size_t)-1 )
+	{
+		output_error("checkpoint failure (stream context is %s)",stream_context());
+		return 0;
+	}
+	return 1;
+}
+
+#ifndef WIN32
+static pid_t checkpoint_pid = 0; /* background checkpoint process, if any */
+static char checkpoint_name[1024] = ""; /* file written by the background checkpoint process */
+
+/* collect the background checkpoint process; returns 0 if it is still running and block is 0 */
+static int checkpoint_reap(int block)
+{
+	int status = 0;
+	pid_t pid;
+	if ( checkpoint_pid==0 )
+		return 1;
+	pid = waitpid(checkpoint_pid,&status,block?0:WNOHANG);
+	if ( pid==0 )
+		return 0;
+	if ( pid<0 || !WIFEXITED(status) || WEXITSTATUS(status)!=0 )
+	{
+		output_error("background checkpoint of '%s' failed", checkpoint_name);
+		/* TROUBLESHOOT
+			The process that writes checkpoints while the simulation continues did not
+			complete successfully.  Check that the checkpoint file can be written and that
+			there is enough disk space, or disable checkpoint_background to see the
+			error reported by the stream.
+		 */
+	}
+	checkpoint_pid = 0;
+	return 1;
+}
+#endif
+
+/* wait for a background checkpoint to be completed */
+static void checkpoint_finish(void)
+{
+#ifndef WIN32
+	checkpoint_reap(1);
+#endif
+}
+
 void do_checkpoint(void)
 {
 	/* last checkpoint value */
 	static TIMESTAMP last_checkpoint = 0;
+	static int have_base = 0;
 	TIMESTAMP now = 0;
 
 	/* check point type selection */
@@ -395,7 +457,30 @@ void do_checkpoint(void)
 		if ( last_checkpoint + global_checkpoint_interval <= now )
 		{
 			static char fn[1024] = "";
-			FILE *fp = NULL;
+			int opts = SF_OUT;
+
+#ifndef WIN32
+			/* wait until the previous background checkpoint is done */
+			if ( !checkpoint_reap(0) )
+				return;
+#endif
+
+			/* incremental checkpoints save only the objects changed since the last one */
+			if ( global_checkpoint_incremental )
+			{
+				if ( stream_delta_init() )
+					opts |= have_base ? SF_DELTA : SF_BASE;
+				else
+				{
+					output_warning("unable to allocate incremental checkpoint data, saving full checkpoints");
+					/* TROUBLESHOOT
+						Incremental checkpoints need memory to hold a checksum of every object.
+						Full checkpoints will be saved instead.  Free up memory or disable
+						checkpoint_incremental.
+					 */
+					global_checkpoint_incremental = 0;
+				}
+			}
 
 			/* default checkpoint filename */
 			if ( strcmp(global_checkpoint_file,"")==0 )
@@ -411,22 +496,49 @@ void do_checkpoint(void)
 					*ext = '\0';
 			}
 
-			/* delete old checkpoint file if not desired */
-			if ( global_checkpoint_keepall==0 && strcmp(fn,"")!=0 )
+			/* delete old checkpoint file if not desired (incremental checkpoints need all the files) */
+			if ( global_checkpoint_keepall==0 && global_checkpoint_incremental==0 && strcmp(fn,"")!=0 )
 				unlink(fn);
 
 			/* create current checkpoint save filename */
 			sprintf(fn,"%s.%d",global_checkpoint_file,global_checkpoint_seqnum++);
-			fp = fopen(fn,"w");
-			if ( fp==NULL )
-				output_error("unable to open checkpoint file '%s' for writing");
-			else
+
+			/* background checkpoints are written by a child process from its copy-on-write image of the model */
+			if ( global_checkpoint_background )
 			{
-				if ( stream(fp,SF_OUT)<=0 )
-					output_error("checkpoint failure (stream context is %s)",stream_context());
-				fclose(fp);
-				last_checkpoint = now;
+#ifdef WIN32
+				static int warned = 0;
+				if ( !warned )
+				{
+					output_warning("background checkpoints are not supported on this platform, checkpoints will stop the simulation");
+					warned = 1;
+				}
+#else
+				pid_t pid;
+				fflush(NULL);
+				pid = fork();
+				if ( pid==0 )
+					_exit(checkpoint_write(fn,opts)?0:1);
+				else if ( pid>0 )
+				{
+					checkpoint_pid = pid;
+					strcpy(checkpoint_name,fn);
+					last_checkpoint = now;
+					have_base = 1;
+					return;
+				}
+				output_warning("unable to start background checkpoint process (%s), checkpoint will stop the simulation", strerror(errno));
+				/* TROUBLESHOOT
+					The system could not create the process that writes the checkpoint while
+					the simulation continues, so the checkpoint is written before the simulation
+					continues.  This is usually caused by a process limit or insufficient memory.
+				 */
+#endif
 			}
+
+			if ( checkpoint_write(fn,opts) )
+				have_base = 1;
+			last_checkpoint = now;
 		}
 	}
 
@@ -958,74 +1070,51 @@ static int commit_init(void)
 	}
 	return n_commits;
 }
-/* commit_list iterator */
-static MTIITEM commit_get0(MTIITEM item)
+/* commit_list arrays used by the executor */
+static OBJECT **commit_objects[2] = {NULL, NULL};
+static unsigned int commit_count[2] = {0, 0};
+static int commit_arrays(void)
 {
-	if ( item==NULL )
-		return (MTIITEM)commit_list[0];
-	else
-		return (MTIITEM)(((SIMPLELINKLIST*)item)->next);
-}
-static MTIITEM commit_get1(MTIITEM item)
-{
-	if ( item==NULL )
-		return (MTIITEM)commit_list[1];
-	else
-		return (MTIITEM)(((SIMPLELINKLIST*)item)->next);
+	unsigned int pc;
+	for ( pc=0 ; pc<2 ; pc++ )
+	{
+		SIMPLELINKLIST *item;
+		unsigned int n = 0;
+		for ( item=commit_list[pc] ; item!=NULL ; item=item->next )
+			n++;
+		commit_objects[pc] = (OBJECT**)malloc(sizeof(OBJECT*)*(n>0?n:1));
+		if ( commit_objects[pc]==NULL )
+			return 0;
+		for ( item=commit_list[pc], n=0 ; item!=NULL ; item=item->next )
+			commit_objects[pc][n++] = (OBJECT*)item->data;
+		commit_count[pc] = n;
+	}
+	return 1;
 }
+/* commit arguments shared by the workers */
+struct commit_data {
+	TIMESTAMP t0, t2;
+	OBJECT *failed; /**< an object whose commit failed */
+};
 /* commit function call */
-static void commit_call(MTIDATA output, MTIITEM item, MTIDATA input)
-{
-	OBJECT *obj = (OBJECT*)(((SIMPLELINKLIST*)item)->data);
-	TIMESTAMP *t2 = (TIMESTAMP*)output;
-	TIMESTAMP *t0 = (TIMESTAMP*)input;
-	if ( *t0<obj->in_svc )
-		*t2 = obj->in_svc;
-	else if ((*t0 == obj->in_svc) && (obj->in_svc_micro != 0))
-		*t2 = obj->in_svc + 1;
-	else if ( obj->out_svc>=*t0 )
-		*t2 = obj->oclass->commit(obj,*t0);
+static TIMESTAMP commit_call(unsigned int thread, void *item, void *arg)
+{
+	OBJECT *obj = (OBJECT*)item;
+	struct commit_data *data = (struct commit_data*)arg;
+	TIMESTAMP next;
+	if ( data->t0<obj->in_svc )
+		return obj->in_svc;
+	else if ( data->t0==obj->in_svc && obj->in_svc_micro!=0 )
+		return obj->in_svc + 1;
+	else if ( obj->out_svc>=data->t0 )
+	{
+		next = object_commit(obj,data->t0,data->t2);
+		if ( next==TS_INVALID )
+			data->failed = obj;
+		return next;
+	}
 	else
-		*t2 = TS_NEVER;
-}
-/* commit data set accessor */
-static MTIDATA commit_set(MTIDATA to, MTIDATA from)
-{
-	/* allocation request */
-	if ( to==NULL ) to = (MTIDATA)malloc(sizeof(TIMESTAMP));
-
-	/* clear request (may follow allocation request) */
-	if ( from==NULL ) *(TIMESTAMP*)to = TS_NEVER;
-	
-	/* copy request */ 
-	else memcpy(to,from,sizeof(TIMESTAMP));	
-
-	return to;
-}
-/* commit data compare accessor */
-static int commit_compare(MTIDATA a, MTIDATA b)
-{
-	TIMESTAMP t0 = (a?*(TIMESTAMP*)a:TS_NEVER);
-	TIMESTAMP t1 = (b?*(TIMESTAMP*)b:TS_NEVER);
-	if ( t0>t1  ) return 1;
-	if ( t0<t1 ) return -1;
-	return 0;
-}
-/* commit data gather accessor */
-static void commit_gather(MTIDATA a, MTIDATA b)
-{
-	TIMESTAMP *t0 = (TIMESTAMP*)a;
-	TIMESTAMP *t1 = (TIMESTAMP*)b;
-	if ( a==NULL || b==NULL ) return;
-	if ( *t1<*t0 ) *t0 = *t1;
-}
-/* commit iterator reject test */
-static int commit_reject(MTI *mti, MTIDATA value)
-{
-	TIMESTAMP *t1 = (TIMESTAMP*)value;
-	TIMESTAMP *t2 = (TIMESTAMP*)mti->output;
-	if ( value==NULL ) return 0;
-	return ( *t2>*t1 && *t2<TS_NEVER ) ? 1 : 0;
+		return TS_NEVER;
 }
 /* single threaded version of commit_all */
 static TIMESTAMP commit_all_st(TIMESTAMP t0, TIMESTAMP t2)
@@ -1069,50 +1158,48 @@ static TIMESTAMP commit_all_st(TIMESTAMP t0, TIMESTAMP t2)
 static TIMESTAMP commit_all(TIMESTAMP t0, TIMESTAMP t2)
 {
 	static int n_commits = -1;
-	static MTI *mti[] = {NULL,NULL};
-	static int init_tried = FALSE;
-	MTIDATA input = (MTIDATA)&t0;
-	MTIDATA output = (MTIDATA)&t2;
 	TIMESTAMP result = TS_NEVER;
+	EXECUTOR *ex = exec_get_executor();
 
 	TRY {
-		unsigned int pc;
-
 		/* build commit list */
-		if ( n_commits==-1 ) n_commits = commit_init();
+		if ( n_commits==-1 )
+		{
+			n_commits = commit_init();
+			if ( !commit_arrays() )
+				throw_exception("commit_init memory allocation failure");
+		}
 
 		/* if no commits found, stop here */
 		if ( n_commits==0 )
 		{
 			result = TS_NEVER;
 		}
+
+		/* single threaded iterator */
+		else if ( ex==NULL )
+		{
+			result = commit_all_st(t0,t2);
+		}
+
+		/* commit the non-observers, then the observers */
 		else
 		{
-			/* initialize MTI */
-			for ( pc=0 ; pc<2 ; pc++ )
+			struct commit_data data = {t0,t2,NULL};
+			unsigned int pc;
+			for ( pc=0 ; pc<2 && data.failed==NULL ; pc++ )
 			{
-				if ( mti[pc]==NULL && global_threadcount!=1 && !init_tried )
-				{
-					/* build mti */
-					static MTIFUNCTIONS fns[] = {
-						{commit_get0, commit_call, commit_set,commit_compare, commit_gather, commit_reject},
-						{commit_get1, commit_call, commit_set,commit_compare, commit_gather, commit_reject},
-					};
-					mti[pc] = mti_init("commit",&fns[pc],8);
-					if ( mti[pc]==NULL )
-					{
-						output_warning("commit_all multi-threaded iterator initialization failed - using single-threaded iterator as fallback");
-						init_tried = TRUE;
-					}
-				}
-
-				/* attempt to run multithreaded iterator */
-				if ( mti[pc]!=NULL && mti_run(output,mti[pc],input) )
-					result = *(TIMESTAMP*)output;
-
-				/* resort to single threaded iterator (which handles both passes) */
-				else if ( pc==0 )
-					result = commit_all_st(t0,t2);
+				TIMESTAMP next = executor_run_min(ex,(void**)commit_objects[pc],commit_count[pc],0,commit_call,&data);
+				if ( next<result ) result = next;
+			}
+			if ( data.failed!=NULL )
+			{
+				char name[64];
+				throw_exception("object %s commit failed", object_name(data.failed,name,sizeof(name)-1));
+				/* TROUBLESHOOT
+					The commit function of the named object has failed.  Make sure that the object's
+					requirements for committing are satisfied and try again.  (likely internal state aberations)
+				 */
 			}
 		}
 	}
@@ -1299,68 +1386,89 @@ void exec_sleep(unsigned int usec)
 #endif
 }
 
-typedef struct s_objsyncdata {
-	unsigned int n; // thread id 0~n_threads for this object rank list
-	pthread_t pt;
-	bool ok;
-	//void *item;
-	LISTITEM *ls;
-	unsigned int nObj; // number of obj in this object rank list
-	unsigned int t0;
-	int i; // index of mutex or cond this object rank list uses 
-} OBJSYNCDATA;
+/* work-stealing executor used for all the core parallel loops when multithreading */
+static EXECUTOR *core_executor = NULL;
 
-static pthread_mutex_t *startlock;
-static pthread_mutex_t *donelock;
-static pthread_cond_t *start;
-static pthread_cond_t *done;
+/** Get the executor used by the main loop
+    @returns the executor, or NULL when the main loop is single-threaded
+ **/
+EXECUTOR *exec_get_executor(void)
+{
+	return core_executor;
+}
 
-static unsigned int *next_t1;
-static unsigned int *donecount;
-static unsigned int *n_threads; //number of thread used in the threadpool of an object rank list
+/* object arrays of each rank list, in the order they are processed in an iteration */
+static OBJECT ***rank_objects = NULL;
+static unsigned int *rank_count = NULL;
 
-static void *obj_syncproc(void *ptr)
+static void obj_syncproc(unsigned int thread, void *item, void *arg)
 {
-	OBJSYNCDATA *data = (OBJSYNCDATA*)ptr;
-	LISTITEM *s;
-	unsigned int n;
-	int i = data->i;
-
-	// begin processing loop
-	while (data->ok)
-	{
-		// lock access to start condition
-		pthread_mutex_lock(&startlock[i]);
+	ss_do_object_sync(thread, item);
+}
 
-		// wait for thread start condition)
-		while (data->t0 == next_t1[i]) 
-			pthread_cond_wait(&start[i], &startlock[i]);
-		// unlock access to start count
-		pthread_mutex_unlock(&startlock[i]);
+static void obj_placeproc(unsigned int thread, void *item, void *arg)
+{
+	arena_place((OBJECT*)item);
+}
 
-		// process the list for this thread
-		for (s=data->ls, n=0; s!=NULL, n<data->nObj; s=s->next,n++) {
-			OBJECT *obj = s->data;
-			ss_do_object_sync(data->n, s->data);
-		}
+/** MAIN LOOP SNAPSHOTS ****************************************************************/
 
-		// signal completed condition
-		data->t0 = next_t1[i];
+/* The main loop holds the snapshot gate while it syncs and commits a timestep.
+   Server requests that must see (or change) the model as a whole take the gate
+   between timesteps.  Requests that are waiting get the gate before the main
+   loop starts its next timestep, so they are never starved by a fast model.
+ */
+static pthread_mutex_t snapshot_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t snapshot_signal = PTHREAD_COND_INITIALIZER;
+static unsigned int snapshot_readers = 0; /* requests holding the gate */
+static unsigned int snapshot_waiting = 0; /* requests waiting for the gate */
+static int snapshot_syncing = 0; /* main loop holds the gate */
 
-		// lock access to done condition
-		pthread_mutex_lock(&donelock[i]);
+/* main loop takes the gate before syncing a timestep */
+static void snapshot_sync_begin(void)
+{
+	if ( snapshot_syncing )
+		return;
+	pthread_mutex_lock(&snapshot_mutex);
+	while ( snapshot_readers>0 || snapshot_waiting>0 )
+		pthread_cond_wait(&snapshot_signal,&snapshot_mutex);
+	snapshot_syncing = 1;
+	pthread_mutex_unlock(&snapshot_mutex);
+}
 
-		// signal thread is done for now
-		donecount[i] --; 
+/* main loop releases the gate between timesteps */
+static void snapshot_sync_end(void)
+{
+	if ( !snapshot_syncing )
+		return;
+	pthread_mutex_lock(&snapshot_mutex);
+	snapshot_syncing = 0;
+	pthread_cond_broadcast(&snapshot_signal);
+	pthread_mutex_unlock(&snapshot_mutex);
+}
 
-		// signal change in done condition
-		pthread_cond_broadcast(&done[i]);
+/** Wait until the main loop is between timesteps and keep it from starting the next one
+    until exec_snapshot_unlock() is called.  Several threads can hold the snapshot at once.
+ **/
+void exec_snapshot_lock(void)
+{
+	pthread_mutex_lock(&snapshot_mutex);
+	snapshot_waiting++;
+	while ( snapshot_syncing )
+		pthread_cond_wait(&snapshot_signal,&snapshot_mutex);
+	snapshot_waiting--;
+	snapshot_readers++;
+	pthread_mutex_unlock(&snapshot_mutex);
+}
 
-		//unlock access to done count
-		pthread_mutex_unlock(&donelock[i]);
-	}
-	pthread_exit((void*)0);
-	return (void*)0;
+/** Release a snapshot taken with exec_snapshot_lock()
+ **/
+void exec_snapshot_unlock(void)
+{
+	pthread_mutex_lock(&snapshot_mutex);
+	snapshot_readers--;
+	pthread_cond_broadcast(&snapshot_signal);
+	pthread_mutex_unlock(&snapshot_mutex);
 }
 
 /** MAIN LOOP CONTROL ******************************************************************/
@@ -1676,15 +1784,8 @@ STATUS exec_start(void)
 	time_t started_at = realtime_now(); // for profiler
 	int j, k;
 	LISTITEM *ptr;
-	int incr;
 	struct arg_data *arg_data_array;
 
-	// Only setup threadpool for each object rank list at the first iteration;
-	// After the first iteration, setTP = false;
-	bool setTP = true; 
-	//int n_threads; //number of thread used in the threadpool of an object rank list
-	OBJSYNCDATA *thread = NULL;
-
 	int nObjRankList, iObjRankList;
 
 	/* run create scripts, if any */
@@ -1721,6 +1822,9 @@ STATUS exec_start(void)
 		return FAILED;
 	}
 
+	/* object headers are settled so searches may use all the header indexes */
+	find_index_start();
+
 	/* run checks */
 	if (global_runchecks)
 		return module_checkall();
@@ -1845,31 +1949,56 @@ STATUS exec_start(void)
 		}
 	}
 
-	/* allocate and initialize thread data */
+	/* allocate and initialize the object arrays of the rank lists */
 	IN_MYCONTEXT output_debug("nObjRankList=%d ",nObjRankList);
 
-	next_t1 = malloc(sizeof(next_t1[0])*nObjRankList);
-	memset(next_t1,0,sizeof(next_t1[0])*nObjRankList);
+	rank_objects = malloc(sizeof(rank_objects[0])*nObjRankList);
+	rank_count = malloc(sizeof(rank_count[0])*nObjRankList);
+	k = 0;
+	for (pass = 0; ranks[pass] != NULL; pass++)
+	{
+		int i;
+		for (i = PASSINIT(pass); PASSCMP(i, pass); i += PASSINC(pass))
+		{
+			unsigned int n = 0;
+			if (ranks[pass]->ordinal[i] == NULL) 
+				continue;
+			rank_objects[k] = malloc(sizeof(OBJECT*)*ranks[pass]->ordinal[i]->size);
+			for (ptr = ranks[pass]->ordinal[i]->first; ptr != NULL; ptr=ptr->next)
+				rank_objects[k][n++] = ptr->data;
+			rank_count[k++] = n;
+		}
+	}
 
-	donecount = malloc(sizeof(donecount[0])*nObjRankList);
-	memset(donecount,0,sizeof(donecount[0])*nObjRankList);
+	/* start the core executor */
+	if (!global_debug_mode && global_threadcount > 1)
+	{
+		core_executor = executor_create("core",global_threadcount);
+		if (core_executor == NULL)
+		{
+			output_error("sync executor creation failed");
+			/* TROUBLESHOOT
+				The threads used to synchronize objects could not be created.
+				Reduce the threadcount or free up system resources and try again.
+			 */
+			return FAILED;
+		}
 
-	n_threads = malloc(sizeof(n_threads[0])*nObjRankList);
-	memset(n_threads,0,sizeof(n_threads[0])*nObjRankList);
+		/* random seed requires each object to be synced by the same thread in the same order */
+		executor_set_stealing(core_executor, global_randomseed==0);
 
-	// allocation and nitialize mutex and cond for object rank lists
-	startlock = malloc(sizeof(startlock[0])*nObjRankList);
-	donelock = malloc(sizeof(donelock[0])*nObjRankList);
-	start = malloc(sizeof(start[0])*nObjRankList);
-	done = malloc(sizeof(done[0])*nObjRankList);
-	for(k=0;k<nObjRankList;k++) 
-	{
-		pthread_mutex_init(&startlock[k], NULL);
-		pthread_mutex_init(&donelock[k], NULL);
-		pthread_cond_init(&start[k], NULL);
-		pthread_cond_init(&done[k], NULL);
+		/* the rank lists are divided among the workers the same way they are synced */
+		if (global_numa_placement)
+		{
+			for (k = 0; k < nObjRankList; k++)
+				executor_run(core_executor, (void**)rank_objects[k], rank_count[k], 0, obj_placeproc, NULL);
+		}
 	}
 
+	/* start the sync lockup watchdog (the debugger may legitimately stop a sync) */
+	if (!global_debug_mode && !watchdog_start())
+		return FAILED;
+
 	// global test mode
 	if ( global_test_mode==TRUE )
 		return test_exec();
@@ -1895,6 +2024,9 @@ STATUS exec_start(void)
 			/* update the process table info */
 			sched_update(global_clock,MLS_RUNNING);
 
+			/* allow snapshots between timesteps */
+			snapshot_sync_end();
+
 			/* main loop control */
 			if ( global_clock>=global_mainlooppauseat && global_mainlooppauseat<TS_NEVER )
 				exec_mls_suspend();
@@ -1944,6 +2076,9 @@ STATUS exec_start(void)
 			else
 				global_clock = exec_sync_get(NULL);
 
+			/* no snapshots while the timestep is being synced */
+			snapshot_sync_begin();
+
 			/* operate delta mode if necessary (but only when event mode is active, e.g., not right after init) */
 			/* note that delta mode cannot be supported for realtime simulation */
 			global_deltaclock = 0;
@@ -2098,77 +2233,8 @@ STATUS exec_start(void)
 							//printf("\n");
 						} 
 						else 
-						{ //sjin: implement pthreads
-							unsigned int n_items,objn=0,n;
-							unsigned int n_obj = ranks[pass]->ordinal[i]->size;
-
-							// Only create threadpool for each object rank list at the first iteration. 
-							// Reuse the threadppol of each object rank list at all other iterations.
-							if (setTP == true) { 
-								incr = (int)ceil((float) n_obj / global_threadcount);
-								// if the number of objects is less than or equal to the number of threads, each thread process one object 
-								if (incr <= 1) {
-									n_threads[iObjRankList] = n_obj;
-									n_items = 1;
-								// if the number of objects is greater than the number of threads, each thread process the same number of 
-								// objects (incr), except that the last thread may process less objects 
-								} else {
-									n_threads[iObjRankList] = (int)ceil((float) n_obj / incr);
-									n_items = incr;
-								}
-								if ((int)n_threads[iObjRankList] > global_threadcount) {
-									output_error("Running threads > global_threadcount");
-									exit(0);
-								}
-
-								// allocate thread list
-								thread = (OBJSYNCDATA*)malloc(sizeof(OBJSYNCDATA)*n_threads[iObjRankList]);
-								memset(thread,0,sizeof(OBJSYNCDATA)*n_threads[iObjRankList]);
-								// assign starting obj for each thread
-								for (ptr=ranks[pass]->ordinal[i]->first;ptr!=NULL;ptr=ptr->next)
-								{
-									if (thread[objn].nObj==n_items)
-										objn++;
-									if (thread[objn].nObj==0) {
-										thread[objn].ls=ptr;
-									}
-									thread[objn].nObj++;
-								}
-								// create threads
-								for (n=0; n<n_threads[iObjRankList]; n++) {
-									thread[n].ok = true;
-									thread[n].i = iObjRankList;
-									if (pthread_create(&(thread[n].pt),NULL,obj_syncproc,&(thread[n]))!=0) {
-										output_fatal("obj_sync thread creation failed");
-										thread[n].ok = false;
-									} else
-										thread[n].n = n;
-								}
-
-							}
-														
-							// lock access to done count
-							pthread_mutex_lock(&donelock[iObjRankList]);
-							
-							// initialize wait count
-							donecount[iObjRankList] = n_threads[iObjRankList];
-
-							// lock access to start condition
-							pthread_mutex_lock(&startlock[iObjRankList]);
-
-							// update start condition
-							next_t1[iObjRankList] ++;
-
-							// signal all the threads
-							pthread_cond_broadcast(&start[iObjRankList]);
-							// unlock access to start count
-							pthread_mutex_unlock(&startlock[iObjRankList]);
-
-							// begin wait
-							while (donecount[iObjRankList]>0)
-								pthread_cond_wait(&done[iObjRankList],&donelock[iObjRankList]);
-							// unlock done count
-							pthread_mutex_unlock(&donelock[iObjRankList]);
+						{
+							executor_run(core_executor, (void**)rank_objects[iObjRankList], rank_count[iObjRankList], 0, obj_syncproc, NULL);
 						}
 
 						for (j = 0; j < thread_data->count; j++) {
@@ -2187,7 +2253,6 @@ STATUS exec_start(void)
 					exec_sync_set(NULL,st);
 				}
 			}
-			setTP = false;
 
 			if (!global_debug_mode)
 			{
@@ -2303,10 +2368,12 @@ STATUS exec_start(void)
 		}
 
 		/* terminate main loop state control */
+		snapshot_sync_end();
 		exec_mls_done();
 	}
 	CATCH(char *msg)
 	{
+		snapshot_sync_end();
 		output_error("exec halted: %s", msg);
 		exec_sync_set(NULL,TS_INVALID);
 		/* TROUBLESHOOT
@@ -2351,13 +2418,17 @@ STATUS exec_start(void)
 #endif
 	}
 
-	// Destroy mutex and cond
-	for(k=0;k<nObjRankList;k++) {
-		pthread_mutex_destroy(&startlock[k]);
-		pthread_mutex_destroy(&donelock[k]);
-		pthread_cond_destroy(&start[k]);
-		pthread_cond_destroy(&done[k]);
-	}
+	/* stop the watchdog and sync executor and release the rank list arrays */
+	checkpoint_finish();
+	watchdog_stop();
+	executor_destroy(core_executor);
+	core_executor = NULL;
+	for(k=0;k<nObjRankList;k++)
+		free(rank_objects[k]);
+	free(rank_objects);
+	free(rank_count);
+	rank_objects = NULL;
+	rank_count = NULL;
 
 	/* report performance */
 	if (global_profiler && !exec_sync_isinvalid(NULL) )
@@ -2439,6 +2510,10 @@ STATUS exec_start(void)
 		output_profile("\n");
 	}
 
+	/* report lock contention */
+	if (global_lock_profile)
+		lock_report();
+
 	sched_update(global_clock,MLS_DONE);
 
 	/* terminate links */
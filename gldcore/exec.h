@@ -13,6 +13,7 @@
 #include <setjmp.h>
 #include "globals.h"
 #include "index.h"
+#include "executor.h"
 
 struct sync_data {
 	TIMESTAMP step_to; /**< time to advance to */
@@ -42,6 +43,8 @@ void exec_mls_suspend(void);
 void exec_mls_resume(TIMESTAMP next_pause);
 void exec_mls_done(void);
 void exec_mls_statewait(unsigned states);
+void exec_snapshot_lock(void);
+void exec_snapshot_unlock(void);
 void exec_slave_node();
 int exec_run_createscripts(void);
 
@@ -70,6 +73,8 @@ EXITCODE exec_run_termscripts(void);
 
 int64 exec_clock(void);
 
+EXECUTOR *exec_get_executor(void);
+
 #ifdef __cplusplus
 }
 #endif
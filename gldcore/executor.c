@@ -0,0 +1,393 @@
+/*  $Id$
+ *  Copyright (C) 2008 Battelle Memorial Institute
+ *
+ *  Work-stealing executor implementation.
+ *
+ *  See executor.h for a description of the scheduling scheme.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef WIN32
+#define _WIN32_WINNT 0x0400
+#include <windows.h>
+#include <intrin.h>
+#pragma intrinsic(_InterlockedCompareExchange)
+#pragma intrinsic(_InterlockedCompareExchange64)
+#pragma intrinsic(_InterlockedDecrement)
+#define atomic_cas(dest,comp,xchg) (_InterlockedCompareExchange((volatile long*)(dest),(xchg),(comp))==(comp))
+#define atomic_cas64(dest,comp,xchg) (_InterlockedCompareExchange64((volatile __int64*)(dest),(xchg),(comp))==(comp))
+#define atomic_decrement(ptr) _InterlockedDecrement((volatile long*)(ptr))
+#define memory_barrier() MemoryBarrier()
+#else
+#define atomic_cas(dest,comp,xchg) __sync_bool_compare_and_swap((dest),(comp),(xchg))
+#define atomic_cas64(dest,comp,xchg) __sync_bool_compare_and_swap((dest),(comp),(xchg))
+#define atomic_decrement(ptr) __sync_sub_and_fetch((ptr),1)
+#define memory_barrier() __sync_synchronize()
+#endif
+
+#include "globals.h"
+#include "executor.h"
+
+// should include output.h, but this causes a conflict with int64
+int output_error(const char *format,...);
+int output_debug(const char *format,...);
+
+/* number of polls an idle worker makes before sleeping */
+#define EXECUTOR_SPINCOUNT 4096
+
+/* number of chunks per worker when no chunk size is given */
+#define EXECUTOR_CHUNKSPERTHREAD 4
+
+/* packing of a [begin,end) chunk range into one atomically updated word */
+#define RANGE(B,E) ((((unsigned int64)(E))<<32)|((unsigned int64)(B)))
+#define RANGE_BEGIN(R) ((unsigned int)((R)&0xffffffff))
+#define RANGE_END(R) ((unsigned int)((R)>>32))
+
+/** Worker state, padded so that workers do not share cache lines **/
+typedef struct s_executorworker {
+	volatile unsigned int64 range; /**< chunks [begin,end) remaining for this worker */
+	unsigned int id; /**< worker id */
+	unsigned int seen; /**< last generation processed */
+	TIMESTAMP t2; /**< earliest time returned to this worker by a reduction */
+	pthread_t thread_id; /**< pthread handle/id */
+	EXECUTOR *ex; /**< executor that owns this worker */
+	char pad[64]; /**< padding to prevent false sharing */
+} EXECUTORWORKER;
+
+/** Executor control block **/
+struct s_executor {
+	const char *name; /**< name given to executor */
+	unsigned int n_threads; /**< number of workers, including the calling thread */
+	int stealing; /**< flag to enable work-stealing */
+	volatile int enabled; /**< flag to keep helper threads alive */
+	volatile unsigned int generation; /**< job generation counter */
+	volatile unsigned int pending; /**< helper threads still busy with the current job */
+	volatile unsigned int busy; /**< flag indicating a job is running */
+	unsigned int sleepers; /**< helper threads waiting on the wake condition */
+	int main_waiting; /**< flag indicating the calling thread waits on the done condition */
+	pthread_mutex_t lock; /**< lock for wake/done conditions */
+	pthread_cond_t wake; /**< signals a new job */
+	pthread_cond_t done; /**< signals job completion */
+	struct {
+		void **item; /**< item array */
+		size_t n_items; /**< number of items */
+		size_t chunksize; /**< number of items per chunk */
+		unsigned int n_chunks; /**< number of chunks */
+		EXECUTORCALL call; /**< task function */
+		EXECUTORMINCALL reduce; /**< reduction function (used instead of call when not NULL) */
+		void *arg; /**< task argument */
+	} job; /**< current job */
+	EXECUTORWORKER *worker; /**< worker list */
+};
+
+/* take the next chunk from the front of the worker's own range */
+static int pop_chunk(EXECUTORWORKER *w)
+{
+	for (;;)
+	{
+		unsigned int64 r = w->range;
+		unsigned int b = RANGE_BEGIN(r), e = RANGE_END(r);
+		if ( b>=e )
+			return -1;
+		if ( atomic_cas64(&w->range,r,RANGE(b+1,e)) )
+			return (int)b;
+	}
+}
+
+/* take a chunk from the back of another worker's range */
+static int steal_chunk(EXECUTORWORKER *w)
+{
+	for (;;)
+	{
+		unsigned int64 r = w->range;
+		unsigned int b = RANGE_BEGIN(r), e = RANGE_END(r);
+		if ( b>=e )
+			return -1;
+		if ( atomic_cas64(&w->range,r,RANGE(b,e-1)) )
+			return (int)(e-1);
+	}
+}
+
+static void run_chunk(EXECUTOR *ex, unsigned int thread, int chunk)
+{
+	size_t n = (size_t)chunk*ex->job.chunksize;
+	size_t last = n+ex->job.chunksize;
+	if ( last>ex->job.n_items )
+		last = ex->job.n_items;
+	if ( ex->job.reduce!=NULL )
+	{
+		TIMESTAMP t2 = ex->worker[thread].t2;
+		for ( ; n<last ; n++ )
+		{
+			TIMESTAMP t = ex->job.reduce(thread,ex->job.item[n],ex->job.arg);
+			if ( t<t2 ) t2 = t;
+		}
+		ex->worker[thread].t2 = t2;
+	}
+	else
+	{
+		for ( ; n<last ; n++ )
+			ex->job.call(thread,ex->job.item[n],ex->job.arg);
+	}
+}
+
+/* process own chunks, then steal from the others until no work is left */
+static void run_worker(EXECUTOR *ex, EXECUTORWORKER *w)
+{
+	int chunk;
+	while ( (chunk=pop_chunk(w))>=0 )
+		run_chunk(ex,w->id,chunk);
+	if ( ex->stealing )
+	{
+		unsigned int k;
+		for ( k=1 ; k<ex->n_threads ; k++ )
+		{
+			EXECUTORWORKER *victim = &ex->worker[(w->id+k)%ex->n_threads];
+			while ( (chunk=steal_chunk(victim))>=0 )
+				run_chunk(ex,w->id,chunk);
+		}
+	}
+}
+
+static void *helper_proc(void *ptr)
+{
+	EXECUTORWORKER *w = (EXECUTORWORKER*)ptr;
+	EXECUTOR *ex = w->ex;
+	for (;;)
+	{
+		/* wait for a new job, spinning briefly before sleeping */
+		unsigned int spin = EXECUTOR_SPINCOUNT;
+		while ( ex->generation==w->seen && ex->enabled && spin-->0 )
+			;
+		if ( ex->generation==w->seen && ex->enabled )
+		{
+			pthread_mutex_lock(&ex->lock);
+			while ( ex->generation==w->seen && ex->enabled )
+			{
+				ex->sleepers++;
+				pthread_cond_wait(&ex->wake,&ex->lock);
+				ex->sleepers--;
+			}
+			pthread_mutex_unlock(&ex->lock);
+		}
+		if ( !ex->enabled )
+			break;
+		w->seen = ex->generation;
+		memory_barrier();
+
+		run_worker(ex,w);
+
+		/* last helper to finish notifies the calling thread */
+		if ( atomic_decrement(&ex->pending)==0 )
+		{
+			pthread_mutex_lock(&ex->lock);
+			if ( ex->main_waiting )
+				pthread_cond_signal(&ex->done);
+			pthread_mutex_unlock(&ex->lock);
+		}
+	}
+	return NULL;
+}
+
+/** Create an executor with \p n_threads workers (including the calling thread)
+    @returns a pointer to the executor, or NULL on failure
+ **/
+EXECUTOR *executor_create(const char *name, unsigned int n_threads)
+{
+	unsigned int n;
+	EXECUTOR *ex = (EXECUTOR*)malloc(sizeof(EXECUTOR));
+	if ( ex==NULL )
+	{
+		output_error("executor_create(name='%s', n_threads=%d): memory allocation failed", name, n_threads);
+		return NULL;
+	}
+	memset(ex,0,sizeof(EXECUTOR));
+	ex->name = name;
+	ex->n_threads = n_threads>0 ? n_threads : 1;
+	ex->stealing = 1;
+	ex->enabled = 1;
+	pthread_mutex_init(&ex->lock,NULL);
+	pthread_cond_init(&ex->wake,NULL);
+	pthread_cond_init(&ex->done,NULL);
+	ex->worker = (EXECUTORWORKER*)malloc(sizeof(EXECUTORWORKER)*ex->n_threads);
+	if ( ex->worker==NULL )
+	{
+		output_error("executor_create(name='%s', n_threads=%d): memory allocation failed", name, n_threads);
+		free(ex);
+		return NULL;
+	}
+	memset(ex->worker,0,sizeof(EXECUTORWORKER)*ex->n_threads);
+	for ( n=0 ; n<ex->n_threads ; n++ )
+	{
+		EXECUTORWORKER *w = &ex->worker[n];
+		w->id = n;
+		w->ex = ex;
+		if ( n>0 && pthread_create(&w->thread_id,NULL,helper_proc,w)!=0 )
+		{
+			output_error("executor_create(name='%s', n_threads=%d): thread creation failed", name, n_threads);
+			ex->n_threads = n;
+			break;
+		}
+	}
+	output_debug("executor '%s' started with %d thread(s)", name, ex->n_threads);
+	return ex;
+}
+
+/** Stop the helper threads and release the executor
+ **/
+void executor_destroy(EXECUTOR *ex)
+{
+	unsigned int n;
+	if ( ex==NULL )
+		return;
+
+	/* wait for any job still in progress (e.g., after an exception) */
+	while ( ex->pending>0 )
+		;
+
+	pthread_mutex_lock(&ex->lock);
+	ex->enabled = 0;
+	pthread_cond_broadcast(&ex->wake);
+	pthread_mutex_unlock(&ex->lock);
+	for ( n=1 ; n<ex->n_threads ; n++ )
+		pthread_join(ex->worker[n].thread_id,NULL);
+	pthread_mutex_destroy(&ex->lock);
+	pthread_cond_destroy(&ex->wake);
+	pthread_cond_destroy(&ex->done);
+	free(ex->worker);
+	free(ex);
+}
+
+/** Get the number of workers, including the calling thread
+ **/
+unsigned int executor_get_threadcount(EXECUTOR *ex)
+{
+	return ex->n_threads;
+}
+
+/** Enable or disable work-stealing
+
+    When stealing is disabled the assignment of items to workers
+    depends only on the number of items and the chunk size.
+ **/
+void executor_set_stealing(EXECUTOR *ex, int enable)
+{
+	ex->stealing = enable;
+}
+
+/* run a job on all the workers, or return 0 if it must be run inline */
+static int run_job(EXECUTOR *ex, void **item, size_t n_items, size_t chunksize, EXECUTORCALL call, EXECUTORMINCALL reduce, void *arg)
+{
+	unsigned int n, n_chunks;
+	if ( ex==NULL || ex->n_threads==1 )
+		return 0;
+	if ( chunksize==0 )
+		chunksize = (n_items+ex->n_threads*EXECUTOR_CHUNKSPERTHREAD-1)/(ex->n_threads*EXECUTOR_CHUNKSPERTHREAD);
+	n_chunks = (unsigned int)((n_items+chunksize-1)/chunksize);
+
+	/* single chunk runs inline, as does a call made while a job is running */
+	if ( n_chunks==1 || !atomic_cas(&ex->busy,0,1) )
+		return 0;
+
+	/* setup job and assign contiguous blocks of chunks to each worker */
+	ex->job.item = item;
+	ex->job.n_items = n_items;
+	ex->job.chunksize = chunksize;
+	ex->job.n_chunks = n_chunks;
+	ex->job.call = call;
+	ex->job.reduce = reduce;
+	ex->job.arg = arg;
+	for ( n=0 ; n<ex->n_threads ; n++ )
+	{
+		unsigned int b = (unsigned int)((unsigned int64)n_chunks*n/ex->n_threads);
+		unsigned int e = (unsigned int)((unsigned int64)n_chunks*(n+1)/ex->n_threads);
+		ex->worker[n].range = RANGE(b,e);
+		ex->worker[n].t2 = TS_NEVER;
+	}
+	ex->pending = ex->n_threads-1;
+
+	/* start the helpers */
+	pthread_mutex_lock(&ex->lock);
+	ex->generation++;
+	if ( ex->sleepers>0 )
+		pthread_cond_broadcast(&ex->wake);
+	pthread_mutex_unlock(&ex->lock);
+
+	/* calling thread does its share */
+	run_worker(ex,&ex->worker[0]);
+
+	/* wait for the helpers to finish */
+	for ( n=EXECUTOR_SPINCOUNT ; ex->pending>0 && n>0 ; n-- )
+		;
+	if ( ex->pending>0 )
+	{
+		pthread_mutex_lock(&ex->lock);
+		ex->main_waiting = 1;
+		while ( ex->pending>0 )
+			pthread_cond_wait(&ex->done,&ex->lock);
+		ex->main_waiting = 0;
+		pthread_mutex_unlock(&ex->lock);
+	}
+	memory_barrier();
+	ex->busy = 0;
+	return 1;
+}
+
+/** Run a task over an array of items
+
+    The chunk size is the number of consecutive items a worker processes
+    before taking another chunk. If the chunk size is zero, one is chosen
+    so that each worker initially gets a few chunks.
+
+    @returns 1 when all items have been processed
+ **/
+int executor_run(EXECUTOR *ex, void **item, size_t n_items, size_t chunksize, EXECUTORCALL call, void *arg)
+{
+	if ( n_items>0 && !run_job(ex,item,n_items,chunksize,call,NULL,arg) )
+	{
+		size_t i;
+		for ( i=0 ; i<n_items ; i++ )
+			call(0,item[i],arg);
+	}
+	return 1;
+}
+
+/** Run a reduction over an array of items
+
+    This works like #executor_run() except that the call returns a time
+    for each item.  Each worker keeps the earliest of the times it gets,
+    and the earliest of the workers' times is returned.
+
+    @returns the earliest time returned by the calls, or TS_NEVER if there are no items
+ **/
+TIMESTAMP executor_run_min(EXECUTOR *ex, void **item, size_t n_items, size_t chunksize, EXECUTORMINCALL call, void *arg)
+{
+	TIMESTAMP t2 = TS_NEVER;
+	if ( n_items==0 )
+		return t2;
+	if ( run_job(ex,item,n_items,chunksize,NULL,call,arg) )
+	{
+		unsigned int n;
+		for ( n=0 ; n<ex->n_threads ; n++ )
+		{
+			if ( ex->worker[n].t2<t2 ) t2 = ex->worker[n].t2;
+		}
+	}
+	else
+	{
+		size_t i;
+		for ( i=0 ; i<n_items ; i++ )
+		{
+			TIMESTAMP t = call(0,item[i],arg);
+			if ( t<t2 ) t2 = t;
+		}
+	}
+	return t2;
+}
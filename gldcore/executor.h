@@ -0,0 +1,80 @@
+/** $Id$
+    Copyright (C) 2008 Battelle Memorial Institute
+
+@file executor.h
+@addtogroup executor Work-stealing executor
+@ingroup core
+
+The executor is a persistent pool of worker threads used by the main
+loop to process the objects of a rank list in parallel.  The calling
+thread always participates as worker 0, so an executor created for
+\p n threads starts only \p n-1 helper threads.
+
+Each call to #executor_run() divides the item array into chunks.  The
+chunks are initially assigned to the workers in contiguous blocks, and
+each worker keeps its share in a private double-ended range.  A worker
+takes chunks from the front of its own range and, when it runs out of
+work, steals chunks from the back of another worker's range.  The call
+returns only after all the items have been processed, so there is only
+one barrier per call.
+
+When stealing is disabled (e.g., when #global_randomseed is set) each
+item is always processed by the same worker in the same order, which
+is the same guarantee provided by the static partitioning the main loop
+used previously.
+
+Idle helper threads spin briefly before sleeping on a condition variable,
+so a sequence of short calls (e.g., consecutive small rank lists) does not
+incur a sleep/wake cycle for each call.
+
+The main loop creates a single executor with #global_threadcount workers
+and all the core parallel loops (rank lists, commits, schedules, loadshapes
+and enduses) run on it, so the number of threads never exceeds the thread
+count (see #exec_get_executor).  Loops that compute the next event time use
+#executor_run_min(), which keeps a separate minimum for each worker and
+combines them after the call.  A NULL executor, or a call made while the
+executor is already running a job (e.g., from inside a task), runs the items
+inline on the calling thread as worker 0.
+
+@{**/
+
+#ifndef _EXECUTOR_H
+#define _EXECUTOR_H
+
+#include "platform.h"
+#include "timestamp.h"
+#include <pthread.h>
+
+/** Executor task function
+    This function is called once for each item in the item array.
+ **/
+typedef void (*EXECUTORCALL)(unsigned int thread, /**< the id of the worker calling (0 is the calling thread) */
+							 void *item, /**< the item to process */
+							 void *arg); /**< the argument given to #executor_run */
+
+/** Executor reduction function
+    This function is called once for each item in the item array and
+    returns the time of the next event for that item.
+ **/
+typedef TIMESTAMP (*EXECUTORMINCALL)(unsigned int thread, /**< the id of the worker calling (0 is the calling thread) */
+									 void *item, /**< the item to process */
+									 void *arg); /**< the argument given to #executor_run_min */
+
+typedef struct s_executor EXECUTOR;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+EXECUTOR *executor_create(const char *name, unsigned int n_threads);
+void executor_destroy(EXECUTOR *ex);
+unsigned int executor_get_threadcount(EXECUTOR *ex);
+void executor_set_stealing(EXECUTOR *ex, int enable);
+int executor_run(EXECUTOR *ex, void **item, size_t n_items, size_t chunksize, EXECUTORCALL call, void *arg);
+TIMESTAMP executor_run_min(EXECUTOR *ex, void **item, size_t n_items, size_t chunksize, EXECUTORMINCALL call, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /**@} _EXECUTOR_H */
@@ -9,6 +9,7 @@
  **/
 
 #include <stdlib.h>
+#include <stddef.h>
 #include <ctype.h>
 #include <stdio.h>
 #ifdef WIN32 && !(__MINGW__)
@@ -21,6 +22,7 @@
 #include "aggregate.h"
 #include "module.h"
 #include "timestamp.h"
+#include "lock.h"
 
 SET_MYCONTEXT(DMC_FIND)
 
@@ -301,6 +303,9 @@ FINDLIST *new_list(unsigned int n)
 
 FINDLIST *find_runpgm(FINDLIST *list, FINDPGM *pgm);
 FINDPGM *find_mkpgm(char *expression);
+static FINDLIST *find_group(char *expression);
+static char *find_objects_class(va_list ptr);
+static int find_index_class(FINDLIST *list, char *classname);
 
 /** Search for objects that match criteria
 	\p start may be a previous search result, or \p FT_NEW.
@@ -366,28 +371,36 @@ FINDLIST *find_objects(FINDLIST *start, ...)
 	double rval;
 	OBJECT *obj;
 	FINDLIST *result = start;
-	if (start==FL_NEW || start==FL_GROUP)
-	{
-		result=new_list(object_get_count());
-		ADDALL(*result);
-	}
+	char *classname = NULL;
 	/* FL_GROUP is something of an interrupt option that constructs a program by parsing string input. */
 	if (start==FL_GROUP)
 	{
-		FINDPGM *pgm;
+		char *expression;
 		va_list(ptr);
 		va_start(ptr,start);
-		pgm = find_mkpgm(va_arg(ptr,char*));
-		if (pgm!=NULL){
-			return find_runpgm(result,pgm);
-		} else {
+		expression = va_arg(ptr,char*);
+		va_end(ptr);
+		return find_group(expression);
+	}
+	if (start==FL_NEW)
+	{
+		result=new_list(object_get_count());
+		/* a search that must match a class only needs to look at the objects of that class */
+		if (global_find_index)
+		{
+			va_list(ptr);
+			va_start(ptr,start);
+			classname = find_objects_class(ptr);
 			va_end(ptr);
-			DELALL(*result); /* pgm == NULL */
-			return result;
+		}
+		if (classname==NULL || !find_index_class(result,classname))
+		{
+			classname = NULL;
+			ADDALL(*result);
 		}
 	}
 	/* if we're not using FL_GROUP, we break apart the va_arg list, taking data inputs in the "correct" type. */
-	for (obj=object_get_first(); obj!=NULL; obj=obj->next)
+	for (obj=(classname ? find_first(result) : object_get_first()); obj!=NULL; obj=(classname ? find_next(result,obj) : obj->next))
 	{
 		FINDTYPE ftype;
 		va_list(ptr);
@@ -532,14 +545,25 @@ OBJECT *find_first(FINDLIST *list) /**< the search list to scan */
 OBJECT *find_next(FINDLIST *list, /**< the search list to scan */
 				  OBJECT *obj) /**< the current object */
 {
-	if (obj==NULL)
-		obj = object_get_first();
-	else
-		obj = obj->next;
-	while (obj!=NULL && !FOUND(*list,obj->id))
-		obj=obj->next;
-
-	return obj;
+	/* objects are listed in the order of their ids, so scan the result bits and skip empty bytes */
+	OBJECTNUM id = (obj==NULL) ? 0 : obj->id+1;
+	OBJECTNUM limit = list->result_size<<3;
+	while (id<limit)
+	{
+		unsigned char bits = (unsigned char)list->result[id>>3]>>(id&0x7);
+		if (bits==0)
+			id = (id|0x7)+1;
+		else if (bits&0x1)
+		{
+			OBJECT *next = object_find_by_id(id);
+			if (next!=NULL)
+				return next;
+			id++;
+		}
+		else
+			id++;
+	}
+	return NULL;
 }
 
 /**************************************************************
@@ -693,7 +717,7 @@ int compare_integer64_nl(void *a, FINDVALUE b) {
  **/
 FINDLIST *findlist_copy(FINDLIST *list)
 {
-	unsigned int size = sizeof(FINDLIST)+(list->result_size>>3);
+	unsigned int size = sizeof(FINDLIST)+list->result_size-1;
 	FINDLIST *new_list = module_malloc(size);
 	memcpy(new_list,list,size);
 	return new_list;
@@ -716,6 +740,503 @@ static void findlist_nop(FINDLIST *list, OBJECT *obj)
 {
 }
 
+/**************************************************************
+ * FIND INDEXES
+ **************************************************************/
+
+/* Searches on the class, group, parent and rank of objects use an index of the
+   objects that have each value of these header fields.  The index of a field is
+   built the first time it is needed and is extended as objects are created.  It
+   is rebuilt when the object header serial number changes (see
+   object_get_header_serial()), i.e., when objects are removed or headers are
+   changed through the core.  Modules may change the group, parent and rank of
+   their objects directly while the model is loaded and initialized, so these
+   indexes are only used once the main loop starts (see find_index_start()).
+   The class of an object never changes, so the class index is always used. */
+
+#define FI_END ((OBJECTNUM)-1) /* end of an index chain */
+#define FI_MINSIZE 64 /* minimum size of the key table of an index */
+
+typedef enum {FI_CLASS=0, FI_GROUPID=1, FI_PARENT=2, FI_RANK=3, FI_COUNT=4} FINDINDEXTYPE;
+
+/** Objects that have the same key **/
+typedef struct s_findkey {
+	size_t key; /**< the key */
+	OBJECTNUM first; /**< the first object with the key */
+	OBJECTNUM last; /**< the last object with the key */
+	unsigned int count; /**< the number of objects with the key (0 if the entry is not used) */
+} FINDKEY;
+
+/** Index of a header field **/
+typedef struct s_findindex {
+	FINDKEY *key; /**< hash table of keys */
+	unsigned int size; /**< size of the key table (a power of 2) */
+	unsigned int n_keys; /**< number of keys in the table */
+	OBJECTNUM *next; /**< the next object with the same key, by object id */
+	OBJECTNUM n_next; /**< size of the next array */
+	OBJECTNUM limit; /**< objects with lower ids have been indexed */
+	unsigned int serial; /**< header serial number when the index was built */
+} FINDINDEX;
+
+static FINDINDEX find_index[FI_COUNT];
+static unsigned int find_index_lock = 0;
+static int find_index_started = 0;
+
+static size_t findindex_hash(char *string)
+{
+	size_t hash = 2166136261u;
+	while (*string!='\0')
+		hash = (hash ^ (unsigned char)*string++) * 16777619u;
+	return hash;
+}
+
+static size_t findindex_getkey(FINDINDEXTYPE type, OBJECT *obj)
+{
+	switch (type) {
+	case FI_CLASS: return (size_t)obj->oclass;
+	case FI_GROUPID: return findindex_hash(obj->groupid);
+	case FI_PARENT: return (size_t)obj->parent;
+	case FI_RANK: return (size_t)obj->rank;
+	default: return 0;
+	}
+}
+
+static unsigned int findindex_slot(FINDINDEX *index, size_t key)
+{
+	key ^= key>>16;
+	key *= 0x45d9f3b;
+	key ^= key>>16;
+	return (unsigned int)(key&(index->size-1));
+}
+
+static FINDKEY *findindex_lookup(FINDINDEX *index, size_t key)
+{
+	unsigned int n;
+	if (index->key==NULL)
+		return NULL;
+	for (n=findindex_slot(index,key); index->key[n].count>0; n=(n+1)&(index->size-1))
+	{
+		if (index->key[n].key==key)
+			return index->key+n;
+	}
+	return NULL;
+}
+
+/* get the entry of a key, adding it if it is not found (its count is 0 if it was added) */
+static FINDKEY *findindex_insert(FINDINDEX *index, size_t key)
+{
+	unsigned int n;
+	if ((index->n_keys+1)*2>index->size)
+	{
+		FINDKEY *old = index->key;
+		unsigned int oldsize = index->size;
+		unsigned int size = oldsize ? oldsize*2 : FI_MINSIZE;
+		FINDKEY *table = (FINDKEY*)malloc(sizeof(FINDKEY)*size);
+		if (table==NULL)
+			return NULL;
+		memset(table,0,sizeof(FINDKEY)*size);
+		index->key = table;
+		index->size = size;
+		for (n=0; n<oldsize; n++)
+		{
+			if (old[n].count>0)
+			{
+				unsigned int m;
+				for (m=findindex_slot(index,old[n].key); table[m].count>0; m=(m+1)&(size-1));
+				table[m] = old[n];
+			}
+		}
+		free(old);
+	}
+	for (n=findindex_slot(index,key); index->key[n].count>0; n=(n+1)&(index->size-1))
+	{
+		if (index->key[n].key==key)
+			return index->key+n;
+	}
+	index->key[n].key = key;
+	index->n_keys++;
+	return index->key+n;
+}
+
+/* bring an index up to date with the objects and their headers */
+static int findindex_update(FINDINDEXTYPE type)
+{
+	FINDINDEX *index = find_index+type;
+	OBJECTNUM limit = object_get_id_limit(), id;
+	if (index->serial!=object_get_header_serial() || index->limit>limit)
+	{	/* start over */
+		if (index->key!=NULL)
+			memset(index->key,0,sizeof(FINDKEY)*index->size);
+		index->n_keys = 0;
+		index->limit = 0;
+		index->serial = object_get_header_serial();
+	}
+	if (index->n_next<limit)
+	{
+		OBJECTNUM size = index->n_next*2>limit ? index->n_next*2 : limit;
+		OBJECTNUM *next = (OBJECTNUM*)realloc(index->next,sizeof(OBJECTNUM)*size);
+		if (next==NULL)
+		{
+			output_error("find index update failed: not enough memory for %d objects", limit);
+			/* TROUBLESHOOT
+				There was not enough memory to index the objects for a search.  The search
+				will be done without the index, which is slower.  Try reducing the size of
+				the model or freeing up more memory.
+			 */
+			return 0;
+		}
+		index->next = next;
+		index->n_next = size;
+	}
+	for (id=index->limit; id<limit; id++)
+	{
+		OBJECT *obj = object_find_by_id(id);
+		FINDKEY *key;
+		if (obj==NULL)
+			continue;
+		key = findindex_insert(index,findindex_getkey(type,obj));
+		if (key==NULL)
+		{
+			output_error("find index update failed: not enough memory for keys");
+			/* TROUBLESHOOT
+				There was not enough memory to index the objects for a search.  The search
+				will be done without the index, which is slower.  Try reducing the size of
+				the model or freeing up more memory.
+			 */
+			index->serial = object_get_header_serial()-1; /* force a rebuild next time */
+			return 0;
+		}
+		index->next[id] = FI_END;
+		if (key->count==0)
+			key->first = id;
+		else
+			index->next[key->last] = id;
+		key->last = id;
+		key->count++;
+	}
+	index->limit = limit;
+	return 1;
+}
+
+/* add the objects in a key chain to a list */
+static void findindex_addchain(FINDINDEX *index, FINDKEY *key, FINDLIST *list)
+{
+	OBJECTNUM id;
+	for (id=key->first; id!=FI_END; id=index->next[id])
+	{
+		if (id<(list->result_size<<3))
+			ADDOBJ(*list,id);
+	}
+}
+
+/** Enable the indexes of the group, parent and rank of objects.
+	This is called by the main loop once all the objects are initialized.
+	Modules must change these header fields through the core from then on
+	(e.g., using object_set_parent() and object_set_rank()).
+ **/
+void find_index_start(void)
+{
+	find_index_started = 1;
+}
+
+/* get the index and key of a program term, if the term can be done using an index */
+static int find_index_term(FINDPGM *pgm, FINDINDEXTYPE *type, size_t *key)
+{
+	if (pgm->pos!=NULL || pgm->neg!=findlist_del)
+		return 0;
+	if (pgm->op==compare_pointer_eq && pgm->target==offsetof(OBJECT,oclass))
+	{
+		*type = FI_CLASS;
+		*key = (size_t)pgm->value.pointer;
+		return 1;
+	}
+	if (!find_index_started)
+		return 0;
+	if (pgm->op==compare_string_eq && pgm->target==offsetof(OBJECT,groupid))
+	{
+		*type = FI_GROUPID;
+		*key = findindex_hash(pgm->value.string);
+		return 1;
+	}
+	if (pgm->op==compare_pointer_eq && pgm->target==offsetof(OBJECT,parent))
+	{
+		*type = FI_PARENT;
+		*key = (size_t)pgm->value.pointer;
+		return 1;
+	}
+	if (pgm->op==compare_integer_eq && pgm->target==offsetof(OBJECT,rank))
+	{
+		*type = FI_RANK;
+		*key = (size_t)(OBJECTRANK)(int32)pgm->value.integer;
+		return 1;
+	}
+	return 0;
+}
+
+/* Seed a new search list with the objects that satisfy the most selective
+   indexed term of a program.  The program is still run on the seeded list,
+   which checks the term itself (e.g., for group hash collisions). 
+   Returns 0 if no term of the program can use an index. */
+static int find_index_seed(FINDLIST *list, FINDPGM *pgm)
+{
+	FINDKEY *best = NULL;
+	FINDINDEXTYPE best_type = FI_CLASS;
+	int seeded = 0;
+	if (!global_find_index || list==NULL)
+		return 0;
+	wlock(&find_index_lock);
+	for ( ; pgm!=NULL; pgm=pgm->next)
+	{
+		FINDINDEXTYPE type;
+		size_t value;
+		FINDKEY *key;
+		if (!find_index_term(pgm,&type,&value) || !findindex_update(type))
+			continue;
+		seeded = 1;
+		key = findindex_lookup(find_index+type,value);
+		if (key==NULL)
+		{	/* no object can satisfy the program */
+			best = NULL;
+			break;
+		}
+		if (best==NULL || key->count<best->count)
+		{
+			best = key;
+			best_type = type;
+		}
+	}
+	if (best!=NULL)
+		findindex_addchain(find_index+best_type,best,list);
+	wunlock(&find_index_lock);
+	return seeded;
+}
+
+/* Add the objects of the named class to a new search list.
+   Returns 0 if the class index cannot be used. */
+static int find_index_class(FINDLIST *list, char *classname)
+{
+	CLASS *oclass;
+	if (list==NULL)
+		return 0;
+	wlock(&find_index_lock);
+	if (!findindex_update(FI_CLASS))
+	{
+		wunlock(&find_index_lock);
+		return 0;
+	}
+	for (oclass=class_get_first_class(); oclass!=NULL; oclass=oclass->next)
+	{
+		/* see compare() for FT_CLASS */
+		if (oclass->module!=NULL && strcmp(oclass->name,classname)==0)
+		{
+			FINDKEY *key = findindex_lookup(find_index+FI_CLASS,(size_t)oclass);
+			if (key!=NULL)
+				findindex_addchain(find_index+FI_CLASS,key,list);
+		}
+	}
+	wunlock(&find_index_lock);
+	return 1;
+}
+
+/* Check whether a find_objects() criteria list can only match objects of one
+   class, i.e., it begins with an FT_CLASS SAME criterion and has no OR
+   conjunctions.  The arguments are read exactly as find_objects() reads them.
+   Returns the class name, or NULL if the criteria can match other objects. */
+static char *find_objects_class(va_list ptr)
+{
+	FINDTYPE ftype;
+	char *classname = NULL;
+	int first = 1;
+	while ((ftype=va_arg(ptr,FINDTYPE)) != FT_END)
+	{
+		int parent=0, invert=0;
+		char *sval = NULL;
+		FINDOP op;
+		if (ftype==AND || ftype==OR)
+		{
+			if (ftype==OR)
+				return NULL;
+			ftype = va_arg(ptr,FINDTYPE);
+		}
+		while (ftype==FT_PARENT)
+		{
+			ftype = va_arg(ptr,FINDTYPE);
+			parent++;
+		}
+		if (ftype==FT_PROPERTY)
+			va_arg(ptr,char*);
+		op = va_arg(ptr,FINDOP);
+		if (op==NOT)
+		{
+			invert = 1;
+			op = va_arg(ptr,FINDOP);
+		}
+		switch (ftype) {
+		case FT_PARENT:
+		case FT_ID:
+			va_arg(ptr,OBJECTNUM);
+			break;
+		case FT_SIZE:
+		case FT_RANK:
+			va_arg(ptr,int);
+			break;
+		case FT_INSVC:
+		case FT_OUTSVC:
+		case FT_CLOCK:
+			va_arg(ptr,TIMESTAMP);
+			break;
+		case FT_LAT:
+		case FT_LONG:
+			va_arg(ptr,double);
+			break;
+		case FT_CLASS:
+		case FT_NAME:
+		case FT_PROPERTY:
+		case FT_MODULE:
+		case FT_GROUPID:
+		case FT_ISA:
+			sval = va_arg(ptr,char*);
+			break;
+		default:
+			return NULL;
+		}
+		if (first)
+		{	/* note that EQ compares strings as numbers so only SAME selects a class */
+			if (ftype!=FT_CLASS || parent>0 || invert || op!=SAME || sval==NULL)
+				return NULL;
+			classname = sval;
+			first = 0;
+		}
+	}
+	return classname;
+}
+
+/**************************************************************
+ * FIND RESULT CACHE
+ **************************************************************/
+
+/* The programs and results of group expressions (see find_group()) are cached.
+   A cached result is used again if no objects were created or removed and no
+   headers were changed since it was found.  Results of expressions that use
+   the clock are never cached, and results of expressions that use any header
+   field other than the class or id are only cached once the find indexes of
+   the mutable header fields are enabled (see find_index_start()). */
+
+#define FIND_CACHESIZE 64 /* number of group expressions cached */
+
+typedef struct s_findcache {
+	char *expression; /**< the group expression */
+	FINDPGM *pgm; /**< the program of the expression */
+	FINDLIST *result; /**< the last result, or NULL if it cannot be used again */
+	OBJECTNUM limit; /**< object id limit when the result was found */
+	unsigned int serial; /**< header serial number when the result was found */
+} FINDCACHE;
+
+static FINDCACHE find_cache[FIND_CACHESIZE];
+static unsigned int find_cache_next = 0;
+static unsigned int find_cache_lock = 0;
+
+static void find_freepgm(FINDPGM *pgm)
+{
+	while (pgm!=NULL)
+	{
+		FINDPGM *next = pgm->next;
+		free(pgm);
+		pgm = next;
+	}
+}
+
+/* check whether the result of a program stays valid while the headers don't change */
+static int find_cacheable(FINDPGM *pgm)
+{
+	for ( ; pgm!=NULL; pgm=pgm->next)
+	{
+		if (pgm->target==offsetof(OBJECT,clock))
+			return 0;
+		if (pgm->target!=offsetof(OBJECT,oclass) && pgm->target!=offsetof(OBJECT,id) && !find_index_started)
+			return 0;
+	}
+	return 1;
+}
+
+/* run a group expression (see find_objects() with FL_GROUP) */
+static FINDLIST *find_group(char *expression)
+{
+	FINDCACHE *entry = NULL;
+	FINDPGM *pgm = NULL;
+	FINDLIST *result;
+	unsigned int n;
+	if (!global_find_index || expression==NULL)
+	{
+		pgm = find_mkpgm(expression);
+		if (pgm==NULL)
+		{
+			result=new_list(object_get_count());
+			DELALL(*result); /* pgm == NULL */
+			return result;
+		}
+		return find_runpgm(NULL,pgm);
+	}
+
+	/* the lock is held while the program runs because a cached program may be replaced */
+	wlock(&find_cache_lock);
+	for (n=0; n<FIND_CACHESIZE; n++)
+	{
+		if (find_cache[n].expression!=NULL && strcmp(find_cache[n].expression,expression)==0)
+		{
+			entry = find_cache+n;
+			break;
+		}
+	}
+	if (entry!=NULL && entry->result!=NULL && entry->limit==object_get_id_limit() && entry->serial==object_get_header_serial())
+	{
+		result = findlist_copy(entry->result);
+		wunlock(&find_cache_lock);
+		return result;
+	}
+	if (entry!=NULL)
+		pgm = entry->pgm;
+	else
+		pgm = find_mkpgm(expression);
+	if (pgm==NULL)
+	{
+		wunlock(&find_cache_lock);
+		result=new_list(object_get_count());
+		DELALL(*result); /* pgm == NULL */
+		return result;
+	}
+	if (entry==NULL)
+	{	/* replace the oldest entry */
+		char *copy = (char*)malloc(strlen(expression)+1);
+		if (copy!=NULL)
+		{
+			entry = find_cache+find_cache_next;
+			find_cache_next = (find_cache_next+1)%FIND_CACHESIZE;
+			free(entry->expression);
+			find_freepgm(entry->pgm);
+			free(entry->result);
+			strcpy(copy,expression);
+			entry->expression = copy;
+			entry->pgm = pgm;
+			entry->result = NULL;
+		}
+	}
+	result = find_runpgm(NULL,pgm);
+	if (entry!=NULL)
+	{
+		free(entry->result);
+		entry->result = NULL;
+		if (result!=NULL && find_cacheable(pgm))
+		{
+			entry->result = findlist_copy(result);
+			entry->limit = object_get_id_limit();
+			entry->serial = object_get_header_serial();
+		}
+	}
+	wunlock(&find_cache_lock);
+	return result;
+}
+
 PGMCONSTFLAGS find_pgmconstants(FINDPGM *pgm)
 {
 	if (pgm==NULL)
@@ -767,7 +1288,8 @@ FINDLIST *find_runpgm(FINDLIST *list, FINDPGM *pgm)
 	if (list==NULL)
 	{
 		list=new_list(object_get_count());
-		ADDALL(*list);
+		if (!find_index_seed(list,pgm))
+			ADDALL(*list);
 	}
 	if (pgm!=NULL)
 	{
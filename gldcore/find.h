@@ -77,6 +77,7 @@ struct s_object_list *find_first(FINDLIST *list);
 struct s_object_list *find_next(FINDLIST *list, struct s_object_list *obj);
 int find_makearray(FINDLIST *list, struct s_object_list ***objs);
 FINDLIST *find_runpgm(FINDLIST *list, FINDPGM *pgm);
+void find_index_start(void);
 FINDPGM *find_mkpgm(char *search);
 PGMCONSTFLAGS find_pgmconstants(FINDPGM *pgm);
 char *find_file(char *name, char *path, int mode, char *buffer, int len);
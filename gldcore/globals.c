@@ -107,6 +107,10 @@ static KEYWORD sm_keys[] = {
 	{"DELTA_ITER", SM_DELTA_ITER, sm_keys+4},
 	{"ERROR", SM_ERROR, NULL},
 };
+static KEYWORD dmu_keys[] = {
+	{"SERIAL", DMU_SERIAL, dmu_keys+1},
+	{"PARALLEL", DMU_PARALLEL, NULL},
+};
 static KEYWORD dmc_keys[] = {
 		{"NONE", 		DMC_NONE, 			dmc_keys+1},
 		{"ALL", 		DMC_ALL, 			dmc_keys+2},
@@ -191,10 +195,12 @@ static struct s_varmap {
 	{"workdir", PT_char1024, &global_workdir, PA_REFERENCE, "working directory"},
 	{"dumpfile", PT_char1024, &global_dumpfile, PA_PUBLIC, "dump filename"},
 	{"savefile", PT_char1024, &global_savefile, PA_PUBLIC, "save filename"},
+	{"model_cache", PT_char1024, &global_model_cache, PA_PUBLIC, "model cache filename"},
 	{"dumpall", PT_bool, &global_dumpall, PA_PUBLIC, "dumpall enable flag"},
 	{"runchecks", PT_bool, &global_runchecks, PA_PUBLIC, "runchecks enable flag"},
 	{"threadcount", PT_int32, &global_threadcount, PA_PUBLIC, "number of threads to use while using multicore"},
 	{"profiler", PT_bool, &global_profiler, PA_PUBLIC, "profiler enable flag"},
+	{"lock_profile", PT_bool, &global_lock_profile, PA_PUBLIC, "lock contention profiler enable flag"},
 	{"pauseatexit", PT_bool, &global_pauseatexit, PA_PUBLIC, "pause at exit flag"},
 	{"testoutputfile", PT_char1024, &global_testoutputfile, PA_PUBLIC, "filename for test output"},
 	{"xml_encoding", PT_int32, &global_xml_encoding, PA_PUBLIC, "XML data encoding"},
@@ -205,6 +211,9 @@ static struct s_varmap {
 	{"complex_format", PT_char256, &global_complex_format, PA_PUBLIC, "format for writing complex values"},
 	{"object_format", PT_char32, &global_object_format, PA_PUBLIC, "format for writing anonymous object names"},
 	{"object_scan", PT_char32, &global_object_scan, PA_PUBLIC, "format for reading anonymous object names"},
+	{"object_arena", PT_bool, &global_object_arena, PA_PUBLIC, "allocate objects from per-class arenas"},
+	{"numa_placement", PT_bool, &global_numa_placement, PA_PUBLIC, "move objects to the NUMA node of the thread that syncs them"},
+	{"find_index", PT_bool, &global_find_index, PA_PUBLIC, "use header indexes and cached results in object searches"},
 	{"object_tree_balance", PT_bool, &global_no_balance, PA_PUBLIC, "object index tree balancing enable flag"},
 	{"kmlfile", PT_char1024, &global_kmlfile, PA_PUBLIC, "KML output file name"},
 	{"modelname", PT_char1024, &global_modelname, PA_REFERENCE, "model name"},
@@ -239,6 +248,7 @@ static struct s_varmap {
 	{"browser", PT_char1024, &global_browser, PA_PUBLIC, "browser selection"},
 	{"server_portnum",PT_int32,&global_server_portnum, PA_PUBLIC, "server port number (default is find first open starting at 6267)"},
 	{"server_quit_on_close",PT_bool,&global_server_quit_on_close, PA_PUBLIC, "server quit on connection closed enable flag"},
+	{"server_threads",PT_int32,&global_server_threads, PA_PUBLIC, "number of server worker threads (0 uses the number of processors)"},
 	{"client_allowed",PT_char1024,&global_client_allowed, PA_PUBLIC,"clients from which to accept connecdtions"},
 	{"autoclean",PT_bool,&global_autoclean, PA_PUBLIC, "autoclean enable flag"},
 	{"technology_readiness_level", PT_enumeration, &technology_readiness_level, PA_PUBLIC, "technology readiness level", trl_keys},
@@ -248,6 +258,8 @@ static struct s_varmap {
 	{"checkpoint_seqnum", PT_int32, &global_checkpoint_seqnum, PA_PUBLIC, "checkpoint sequence number"},
 	{"checkpoint_interval", PT_int32, &global_checkpoint_interval, PA_PUBLIC, "checkpoint interval"},
 	{"checkpoint_keepall", PT_bool, &global_checkpoint_keepall, PA_PUBLIC, "checkpoint file keep enable flag"},
+	{"checkpoint_background", PT_bool, &global_checkpoint_background, PA_PUBLIC, "checkpoint background write enable flag"},
+	{"checkpoint_incremental", PT_bool, &global_checkpoint_incremental, PA_PUBLIC, "incremental checkpoint enable flag"},
 	{"check_version", PT_bool, &global_check_version, PA_PUBLIC, "check version enable flag"},
 	{"random_number_generator", PT_enumeration, &global_randomnumbergenerator, PA_PUBLIC, "random number generator version control flag", rng_keys},
 	{"mainloop_state", PT_enumeration, &global_mainloopstate, PA_PUBLIC, "main sync loop state flag", mls_keys},
@@ -281,6 +293,7 @@ static struct s_varmap {
 	{"delta_current_clock", PT_double, &global_delta_curr_clock, PA_PUBLIC, "Absolute delta time (global clock offset)"},
 	{"deltamode_updateorder", PT_char1024, &global_deltamode_updateorder, PA_REFERENCE, "order in which modules are update in deltamode"},
 	{"deltamode_iteration_limit", PT_int32, &global_deltamode_iteration_limit, PA_PUBLIC, "iteration limit for each delta timestep (object and interupdate)"},
+	{"deltamode_updatemode", PT_enumeration, &global_deltamode_updatemode, PA_PUBLIC, "deltamode object update mode (SERIAL or PARALLEL)", dmu_keys},
 	{"run_powerworld", PT_bool, &global_run_powerworld, PA_PUBLIC, "boolean that that says your system is set up correctly to run with PowerWorld"},
 	{"bigranks", PT_bool, &global_bigranks, PA_PUBLIC, "enable fast/blind set_rank operations"},
 	{"exename", PT_char1024, &global_execname, PA_REFERENCE, "argv[0] value"},
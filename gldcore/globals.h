@@ -87,11 +87,13 @@ GLOBAL unsigned global_iteration_limit INIT(100); /**< The global iteration limi
 GLOBAL char global_workdir[1024] INIT("."); /**< The current working directory */
 GLOBAL char global_dumpfile[1024] INIT("gridlabd.xml"); /**< The dump file name */
 GLOBAL char global_savefile[1024] INIT(""); /**< The save file name */
+GLOBAL char global_model_cache[1024] INIT(""); /**< The model cache file name, used to load GLM models without parsing them */
 GLOBAL int global_dumpall INIT(FALSE);	/**< Flags all modules to dump data after run complete */
 GLOBAL int global_runchecks INIT(FALSE); /**< Flags module check code to be called after initialization */
 /** @todo Set the threadcount to zero to automatically use the maximum system resources (tickets 180) */
 GLOBAL int global_threadcount INIT(1); /**< the maximum thread limit, zero means automagically determine best thread count */
 GLOBAL int global_profiler INIT(0); /**< Flags the profiler to process class performance data */
+GLOBAL bool global_lock_profile INIT(false); /**< Flags the lock profiler to count the waits of each lock (see lock_report) */
 GLOBAL int global_pauseatexit INIT(0); /**< Enable a pause for user input after exit */
 GLOBAL char global_testoutputfile[1024] INIT("test.txt"); /**< Specifies the test output file */
 GLOBAL int global_xml_encoding INIT(8);  /**< Specifies XML encoding (default is 8) */
@@ -148,6 +150,9 @@ GLOBAL char global_complex_format[256] INIT("%+lg%+lg%c"); /**< the format to us
 //GLOBAL char global_complex_format[256] INIT("%+8.4f%+8.4f%c"); /**< the format to use when processing complex numbers */
 GLOBAL char global_object_format[32] INIT("%s:%d"); 
 GLOBAL char global_object_scan[32] INIT("%[^:]:%d"); /**< the format to use when scanning for object ids */
+GLOBAL bool global_object_arena INIT(true); /**< flag to allocate objects from per-class arenas (see arena.h) */
+GLOBAL bool global_numa_placement INIT(false); /**< flag to move objects to the NUMA node of the thread that syncs them */
+GLOBAL bool global_find_index INIT(true); /**< flag to use header indexes and cached results in object searches (see find.c) */
 
 GLOBAL int global_minimum_timestep INIT(1); /**< the minimum timestep allowed */
 GLOBAL int global_maximum_synctime INIT(60); /**< the maximum time allotted to any single sync call */
@@ -190,6 +195,7 @@ GLOBAL char global_browser[1024] /**< default browser to use for GUI */
 	INIT("firefox"); 
 #endif
 GLOBAL int global_server_quit_on_close INIT(0); /** server will quit when connection is closed */
+GLOBAL int global_server_threads INIT(0); /** number of server worker threads (0 uses the number of processors) */
 GLOBAL int global_autoclean INIT(1); /** server will automatically clean up defunct jobs */
 
 GLOBAL int technology_readiness_level INIT(0); /**< the TRL of the model (see http://sourceforge.net/apps/mediawiki/gridlab-d/index.php?title=Technology_Readiness_Levels) */
@@ -207,6 +213,8 @@ GLOBAL char global_checkpoint_file[1024] INIT(""); /**< checkpoint file name is
 GLOBAL int global_checkpoint_seqnum INIT(0); /**< checkpoint sequence file number */
 GLOBAL int global_checkpoint_interval INIT(0); /** checkpoint interval (default is 3600 for CPT_WALL and 86400 for CPT_SIM */
 GLOBAL int global_checkpoint_keepall INIT(0); /** determines whether all checkpoint files are kept, non-zero keeps files, zero delete all but last */
+GLOBAL int global_checkpoint_background INIT(0); /** checkpoints are written by a copy-on-write child process while the simulation continues */
+GLOBAL int global_checkpoint_incremental INIT(0); /** checkpoints after the first contain only objects whose data changed since the previous checkpoint */
 
 /* version check */
 GLOBAL int global_check_version INIT(0); /**< check version flag */
@@ -254,6 +262,11 @@ GLOBAL DELTAT global_deltaclock INIT(0); /**< the cumulative delta runtime with
 GLOBAL double global_delta_curr_clock INIT(0.0);	/**< Deltamode clock offset by main clock (not just delta offset) */
 GLOBAL char global_deltamode_updateorder[1025] INIT(""); /**< the order in which modules are updated */
 GLOBAL unsigned int global_deltamode_iteration_limit INIT(10);	/**< Global iteration limit for each delta timestep (object and interupdate calls) */
+typedef enum {
+	DMU_SERIAL=0,	/**< deltamode objects are updated one at a time in rank order */
+	DMU_PARALLEL=1,	/**< deltamode objects of the same rank are updated concurrently */
+} DELTAMODEUPDATEMODE; /**< deltamode object update mode */
+GLOBAL int global_deltamode_updatemode INIT(DMU_SERIAL); /**< deltamode object update mode */
 
 /* master/slave */
 GLOBAL char global_master[1024] INIT(""); /**< master hostname */
@@ -498,6 +498,8 @@ inline int gl_set_rank(OBJECT *obj, /**< object to change rank */
 #endif
 
 #define gl_object_get_first (*callback->object.get_first)
+#define gl_object_get_first_in_class (*callback->object.get_first_in_class) /**< first object allocated in a class (see arena.h) */
+#define gl_object_get_next_in_class (*callback->object.get_next_in_class) /**< next object allocated in the same class (see arena.h) */
 #define gl_object_find_by_id (*callback->object_find_by_id)
 /** @} **/
 
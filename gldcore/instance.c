@@ -650,9 +650,6 @@ STATUS instance_initall(void)
 		global_multirun_mode = MRM_MASTER;
 		IN_MYCONTEXT output_verbose("entering multirun mode");
 		output_prefix_enable();
-		pthread_mutex_lock(&mls_inst_lock);
-		pthread_cond_wait(&mls_inst_signal, &mls_inst_lock);
-		
 	} else {
 		return SUCCESS;
 	}
@@ -192,6 +192,9 @@ static unsigned int linenum=1;
 static int include_fail = 0;
 static char filename[1024];
 static time_t modtime = 0;
+static const char *model_nocache = NULL; /* reason the model cannot be saved to the model cache */
+static unsigned int model_objects = 0; /* number of objects created by object blocks */
+#define NOCACHE(X) (model_nocache = (model_nocache ? model_nocache : (X)))
 static int last_good_depth = -1;
 static int current_depth = -1;
 
@@ -4020,6 +4023,7 @@ static int object_properties(PARSER, CLASS *oclass, OBJECT *obj)
 		LOADMETHOD *method = class_get_loadmethod(obj->oclass,propname);
 		if ( method!=NULL )
 		{
+			NOCACHE("load methods");
 			if ( TERM(value(HERE,propval,sizeof(propval))) )
 			{
 				if ( method->call(obj,propval)==1 )
@@ -4045,6 +4049,8 @@ static int object_properties(PARSER, CLASS *oclass, OBJECT *obj)
 			current_module = obj->oclass->module; /* module context */
 			char targetprop[1024];
 			char targetvalue[1024];
+			if ( prop!=NULL && prop->ptype==PT_method )
+				NOCACHE("method properties");
 			if (prop!=NULL && prop->ptype==PT_object && TERM(object_block(HERE,NULL,&subobj)))
 			{
 				char objname[64];
@@ -4645,6 +4651,7 @@ static int object_block(PARSER, OBJECT *parent, OBJECT **subobj)
 			}
 			object_set_parent(obj,parent);
 		}
+		model_objects++;
 		if (id!=-1 && load_set_index(obj,(OBJECTNUM)id)==FAILED)
 		{
 			output_error_raw("%s(%d): unable to index object id number for %s:%d", filename, linenum, classname, id);
@@ -5859,20 +5866,20 @@ static int gridlabd_file(PARSER)
 	OR if LITERAL(";") {ACCEPT; DONE;}
 	OR if TERM(line_spec(HERE)) { ACCEPT; DONE; }
 	OR if TERM(object_block(HERE,NULL,NULL)) {ACCEPT; DONE;}
-	OR if TERM(class_block(HERE)) {ACCEPT; DONE;}
+	OR if TERM(class_block(HERE)) { NOCACHE("class blocks"); ACCEPT; DONE; }
 	OR if TERM(module_block(HERE)) {ACCEPT; DONE;}
 	OR if TERM(clock_block(HERE)) {ACCEPT; DONE;}
-	OR if TERM(import(HERE)) {ACCEPT; DONE; }
-	OR if TERM(export(HERE)) {ACCEPT; DONE; }
-	OR if TERM(library(HERE)) {ACCEPT; DONE; }
+	OR if TERM(import(HERE)) { NOCACHE("import statements"); ACCEPT; DONE; }
+	OR if TERM(export(HERE)) { NOCACHE("export statements"); ACCEPT; DONE; }
+	OR if TERM(library(HERE)) { NOCACHE("library statements"); ACCEPT; DONE; }
 	OR if TERM(schedule(HERE)) {ACCEPT; DONE; }
-	OR if TERM(instance_block(HERE)) {ACCEPT; DONE; }
-	OR if TERM(gui(HERE)) {ACCEPT; DONE;}
-	OR if TERM(extern_block(HERE)) {ACCEPT; DONE; }
-	OR if TERM(filter_block(HERE)) {ACCEPT; DONE; }
-	OR if TERM(global_declaration(HERE)) {ACCEPT; DONE; }
-	OR if TERM(link_declaration(HERE)) { ACCEPT; DONE; }
-	OR if TERM(script_directive(HERE)) { ACCEPT; DONE; }
+	OR if TERM(instance_block(HERE)) { NOCACHE("instance blocks"); ACCEPT; DONE; }
+	OR if TERM(gui(HERE)) { NOCACHE("gui blocks"); ACCEPT; DONE; }
+	OR if TERM(extern_block(HERE)) { NOCACHE("extern blocks"); ACCEPT; DONE; }
+	OR if TERM(filter_block(HERE)) { NOCACHE("filter blocks"); ACCEPT; DONE; }
+	OR if TERM(global_declaration(HERE)) { NOCACHE("global declarations"); ACCEPT; DONE; }
+	OR if TERM(link_declaration(HERE)) { NOCACHE("link declarations"); ACCEPT; DONE; }
+	OR if TERM(script_directive(HERE)) { NOCACHE("script directives"); ACCEPT; DONE; }
 	OR if TERM(modify_directive(HERE)) { ACCEPT; DONE; }
 	OR if (*(HERE)=='\0') {ACCEPT; DONE;}
 	else REJECT;
@@ -5898,6 +5905,7 @@ int replace_variables(char *to,char *from,int len,int warn)
 				n+=(int)strlen(var);
 			else if (env!=NULL)
 			{
+				NOCACHE("environment variables");
 				strncpy(to+n,env,len-n);
 				n+=(int)strlen(env);
 			}
@@ -6192,6 +6200,7 @@ static int include_file(char *incname, char *buffer, int size, int _linenum)
 	}
 	else
 	{
+		stream_model_source(ff);
 		IN_MYCONTEXT output_verbose("include_file(char *incname='%s', char *buffer=0x%p, int size=%d): search of GLPATH='%s' result is '%s'",
 			incname, buffer, size, getenv("GLPATH") ? getenv("GLPATH") : "NULL", ff ? ff : "NULL");
 	}
@@ -6437,6 +6446,7 @@ static int process_macro(char *line, int size, char *_filename, int linenum)
 	}
 	else if (strncmp(line,MACRO "ifexist",8)==0)
 	{
+		NOCACHE("#ifexist");
 		char *term = strchr(line+8,' ');
 		char value[1024];
 		char path[1024];
@@ -6583,6 +6593,7 @@ static int process_macro(char *line, int size, char *_filename, int linenum)
 		else if (sscanf(term, "<%[^>]>", value) == 1)
 		{
 			/* C include file */
+			NOCACHE("C include files");
 			IN_MYCONTEXT output_verbose("added C include for \"%s\"", value);
 			append_code("#include <%s>\n",value);
 			strcpy(line,"\n");
@@ -6596,6 +6607,7 @@ static int process_macro(char *line, int size, char *_filename, int linenum)
 			FILE *fp;
 			HTTPRESULT *http = http_read(value,0x40000);
 			char tmpname[1024];
+			NOCACHE("HTTP include files");
 			if ( http==NULL )
 			{
 				output_error("%s(%d): unable to include [%s]", filename, linenum, value);
@@ -6652,6 +6664,7 @@ static int process_macro(char *line, int size, char *_filename, int linenum)
 	}
 	else if (strncmp(line,MACRO "setenv",7)==0)
 	{
+		NOCACHE("#setenv");
 		char *term = strchr(line+7,' ');
 		char value[65536];
 		if (term==NULL)
@@ -6864,6 +6877,7 @@ static int process_macro(char *line, int size, char *_filename, int linenum)
 	}
 	else if (strncmp(line,MACRO "system",7)==0)
 	{
+		NOCACHE("#system");
 		char *term = strchr(line+7,' ');
 		char value[1024];
 		if (term==NULL)
@@ -6889,6 +6903,7 @@ static int process_macro(char *line, int size, char *_filename, int linenum)
 	}
 	else if (strncmp(line,MACRO "start",6)==0)
 	{
+		NOCACHE("#start");
 		char *term = strchr(line+6,' ');
 		char value[1024];
 		if (term==NULL)
@@ -6913,6 +6928,7 @@ static int process_macro(char *line, int size, char *_filename, int linenum)
 	}
 	else if ( strncmp(line,MACRO "option",7)==0 )
 	{
+		NOCACHE("#option");
 		char *term = strchr(line+7,' ');
 		char value[1024];
 		if (term==NULL)
@@ -6927,6 +6943,7 @@ static int process_macro(char *line, int size, char *_filename, int linenum)
 	}
 	else if ( strncmp(line,MACRO "wget",5)==0 )
 	{
+		NOCACHE("#wget");
 		char url[1024], file[1024];
 		size_t n = sscanf(line+5,"%s %[^\n\r]",url,file);
 		HTTPRESULT *http;
@@ -7197,6 +7214,7 @@ STATUS loadall(char *file){
 	char conf[1024];
 	static int loaded_files = 0;
 	STATUS load_status = FAILED;
+	int model_save = FALSE;
 
 	if ( !inline_code_init() ) return FAILED;
 
@@ -7264,6 +7282,30 @@ STATUS loadall(char *file){
 		else
 			load_status = SUCCESS;
 	}
+	else if ( (ext==NULL || strcmp(ext, ".glm")==0) && global_model_cache[0]!='\0' )
+	{
+		/* use the model cache when it is current, otherwise load the GLM and cache it */
+		int cached;
+		stream_model_begin();
+		cached = stream_model_load(global_model_cache);
+		if ( cached<0 )
+			return FAILED;
+		else if ( cached>0 )
+			load_status = SUCCESS;
+		else
+		{
+			unsigned int old_count = object_get_count();
+			model_nocache = NULL;
+			model_objects = 0;
+			stream_model_source(filename);
+			load_status = loadall_glm_roll(filename);
+			if ( old_count>0 )
+				NOCACHE("objects loaded before the model");
+			else if ( object_get_count()!=model_objects )
+				NOCACHE("objects created by modules");
+			model_save = (load_status==SUCCESS);
+		}
+	}
 	else if (ext==NULL || strcmp(ext, ".glm")==0)
 		load_status = loadall_glm_roll(filename);
 #ifdef HAVE_XERCES
@@ -7283,6 +7325,20 @@ STATUS loadall(char *file){
 		}
 	}
 
+	/* the model is cached once it is completely loaded */
+	if ( model_save )
+	{
+		if ( model_nocache!=NULL )
+			output_warning("model cache '%s' not saved because the model uses %s", global_model_cache, model_nocache);
+			/* TROUBLESHOOT
+				The model uses a GLM feature whose effect the model cache cannot reproduce, so the model
+				will be loaded from GLM each time it is run.  Remove the <b>model_cache</b> global to
+				suppress this warning.
+			 */
+		else
+			stream_model_save(global_model_cache);
+	}
+
 	/* handle new objects */
 //	new_obj_count = object_get_count();
 //	if((load_status == FAILED) && (old_obj_count < new_obj_count)){
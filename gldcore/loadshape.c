@@ -30,7 +30,6 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <ctype.h>
-#include <pthread.h>
 
 #include "platform.h"
 #include "output.h"
@@ -867,196 +866,46 @@ TIMESTAMP loadshape_sync(loadshape *ls, TIMESTAMP t1)
 	return ls->t2>0?ls->t2:TS_NEVER;
 }
 
-typedef struct s_loadshapesyncdata {
-	unsigned int n;
-	pthread_t pt;
-	bool ok;
-	loadshape *ls;
-	unsigned int ns;
-	TIMESTAMP t0;
-	unsigned int ran;
-} LOADSHAPESYNCDATA;
-
-static pthread_cond_t start_ls = PTHREAD_COND_INITIALIZER;
-static pthread_mutex_t startlock_ls = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t done_ls = PTHREAD_COND_INITIALIZER;
-static pthread_mutex_t donelock_ls = PTHREAD_MUTEX_INITIALIZER;
-static TIMESTAMP next_t1_ls, next_t2_ls;
-static unsigned int run = 0;
-static unsigned int donecount_ls;
+static loadshape **loadshape_array = NULL;
+static unsigned int n_loadshape_array = 0;
+static TIMESTAMP next_t2_ls;
 
 clock_t loadshape_synctime = 0;
 
-void *loadshape_syncproc(void *ptr)
+static TIMESTAMP loadshape_syncproc(unsigned int thread, void *item, void *arg)
 {
-	LOADSHAPESYNCDATA *data = (LOADSHAPESYNCDATA*)ptr;
-	loadshape *s;
-	unsigned int n;
-	TIMESTAMP t2;
-
-	// begin processing loop
-	while ( data->ok )
-	{
-		// lock access to start condition
-		pthread_mutex_lock(&startlock_ls);
-
-		// wait for thread start condition
-		while ( data->t0==next_t1_ls && data->ran==run ) 
-			pthread_cond_wait(&start_ls,&startlock_ls);
-		
-		// unlock access to start count
-		pthread_mutex_unlock(&startlock_ls);
-
-		// process the list for this thread
-		t2 = TS_NEVER;
-		for ( s=data->ls, n=0 ; s!=NULL, n<data->ns ; s=s->next, n++ )
-		{
-			TIMESTAMP t = loadshape_sync(s,next_t1_ls);
-			if (t<t2) t2 = t;
-		}
-
-		// signal completed condition
-		data->t0 = next_t1_ls;
-		data->ran++;
-
-		// lock access to done condition
-		pthread_mutex_lock(&donelock_ls);
-
-		// signal thread is done for now
-		donecount_ls--;
-		///printf("action: donecount_ls-- = %d\n", donecount_ls);
-		if ( t2<next_t2_ls ) next_t2_ls = t2;
-
-		// signal change in done condition
-		pthread_cond_broadcast(&done_ls);
-
-		// unlock access to done count
-		pthread_mutex_unlock(&donelock_ls);
-	}
-	pthread_exit((void*)0);
-	return (void*)0;
+	return loadshape_sync((loadshape*)item,*(TIMESTAMP*)arg);
 }
+
 TIMESTAMP loadshape_syncall(TIMESTAMP t1)
 {
-	static unsigned int n_threads_ls=0;
-	static LOADSHAPESYNCDATA *thread_ls = NULL;
-	TIMESTAMP t2 = TS_NEVER;
+	TIMESTAMP t2;
 	clock_t ts = (clock_t)exec_clock();
 
 	// skip loadshape_syncall if there's no loadshape in the glm
 	if (n_shapes == 0)
 		return TS_NEVER;
 
-	// number of threads desired
-	if (n_threads_ls==0) 
+	// build the shape array used by the executor
+	if (n_loadshape_array!=n_shapes)
 	{
 		loadshape *s;
-		int n_items, ln=0;
-
+		unsigned int n = 0;
 		IN_MYCONTEXT output_debug("loadshape_syncall setting up for %d shapes", n_shapes);
-
-		// determine needed threads
-		n_threads_ls = global_threadcount;
-		if (n_threads_ls>1)
-		{
-			unsigned int n;
-			if (n_shapes<n_threads_ls*4)
-				n_threads_ls = n_shapes/4;
-
-			// only need 1 thread if n_shapes is less than 4
-			if (n_threads_ls == 0)
-				n_threads_ls = 1;
-
-			// determine shapes per thread
-			n_items = n_shapes/n_threads_ls;
-			n_threads_ls = n_shapes/n_items;
-			if (n_threads_ls*n_items<n_shapes) // not enough slots yet
-				n_threads_ls++; // add one underused threads
-
-			IN_MYCONTEXT output_debug("loadshape_syncall is using %d of %d available threads", n_threads_ls, global_threadcount);
-			IN_MYCONTEXT output_debug("loadshape_syncall is assigning %d shapes per thread", n_items);
-
-			// allocate thread list
-			thread_ls = (LOADSHAPESYNCDATA*)malloc(sizeof(LOADSHAPESYNCDATA)*n_threads_ls);
-			memset(thread_ls,0,sizeof(LOADSHAPESYNCDATA)*n_threads_ls);
-
-			// assign starting shape for each thread
-			for (s=loadshape_list; s!=NULL; s=s->next)
-			{
-				if (thread_ls[ln].ns==n_items)
-					ln++;
-				if (thread_ls[ln].ns==0)
-					thread_ls[ln].ls = s;
-				thread_ls[ln].ns++;
-			}
-
-			// create threads
-			for (n=0; n<n_threads_ls; n++)
-			{
-				thread_ls[n].ok = true;
-				if ( pthread_create(&(thread_ls[n].pt),NULL,loadshape_syncproc,&(thread_ls[n]))!=0 )
-				{
-					output_fatal("loadshape_sync thread creation failed");
-					thread_ls[n].ok = false;
-				}
-				else
-					thread_ls[n].n = n;
-			}
-		}
+		loadshape_array = (loadshape**)realloc(loadshape_array,sizeof(loadshape*)*n_shapes);
+		if (loadshape_array==NULL)
+			throw_exception("loadshape_syncall memory allocation failure");
+		for (s=loadshape_list; s!=NULL && n<n_shapes; s=s->next)
+			loadshape_array[n++] = s;
+		n_loadshape_array = n;
 	}
 
 	// don't update if next_t2 < next_t1
 	if ( next_t2_ls>t1 && next_t2_ls<TS_NEVER )
 		return next_t2_ls;
 
-	// no threading required
-	if (n_threads_ls<2) 
-	{
-		// process list directly
-		loadshape *s;
-		for (s=loadshape_list; s!=NULL; s=s->next)
-		{
-			TIMESTAMP t3 = loadshape_sync(s,t1);
-			if (t3<t2) t2 = t3;
-		}
-		next_t2_ls = t2;
-	}
-	else
-	{
-		// lock access to done count
-		pthread_mutex_lock(&donelock_ls);
-
-		// initialize wait count
-		donecount_ls = n_threads_ls;
-
-		// lock access to start condition
-		pthread_mutex_lock(&startlock_ls);
-
-		// update start condition
-		next_t1_ls = t1;
-		next_t2_ls = TS_NEVER;
-		run++;
-
-		// signal all the threads
-		pthread_cond_broadcast(&start_ls);
-
-		// unlock access to start count
-		pthread_mutex_unlock(&startlock_ls);
-
-		// begin wait
-		while (donecount_ls>0) {
-			///printf("status: donecount_ls-- = %d\n", donecount_ls);
-			///printf("thread_ls.ok=%d\n",thread_ls->ok);
-			pthread_cond_wait(&done_ls,&donelock_ls);
-		}
-		IN_MYCONTEXT output_debug("passed donecount==0 condition");
-
-		// unlock done count
-		pthread_mutex_unlock(&donelock_ls);
-
-		// process results from all threads
-		if (next_t2_ls<t2) t2=next_t2_ls;
-	}
+	t2 = executor_run_min(exec_get_executor(),(void**)loadshape_array,n_loadshape_array,0,loadshape_syncproc,&t1);
+	next_t2_ls = t2;
 
 	loadshape_synctime += exec_clock() - ts;
 	return t2;
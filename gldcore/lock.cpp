@@ -13,7 +13,16 @@
 
 #include "lock.h"
 #include "exception.h"
+#include "globals.h"
+#include "output.h"
+#include "object.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#ifndef WIN32
+#include <sched.h>
+#endif
 
 //#define LOCKTRACE // enable this to trace locking events back to variables
 #define MAXSPIN 1000000000
@@ -35,17 +44,23 @@
 	#include <libkern/OSAtomic.h>
 	#define atomic_compare_and_swap(dest, comp, xchg) OSAtomicCompareAndSwap32Barrier(comp, xchg, (volatile int32_t *) dest)
 	#define atomic_increment(ptr) OSAtomicIncrement32Barrier((volatile int32_t *) ptr)
+	#define atomic_add64(ptr, value) OSAtomicAdd64Barrier((int64_t)(value), (volatile int64_t *) ptr)
 #elif defined(WIN32) && !defined __MINGW32__
+	#include <windows.h>
 	#include <intrin.h>
 	#pragma intrinsic(_InterlockedCompareExchange)
 	#pragma intrinsic(_InterlockedIncrement)
+	#pragma intrinsic(_InterlockedExchangeAdd64)
+	#pragma intrinsic(__rdtsc)
 	#define atomic_compare_and_swap(dest, comp, xchg) (_InterlockedCompareExchange((volatile long *) dest, xchg, comp) == comp)
 	#define atomic_increment(ptr) _InterlockedIncrement((volatile long *) ptr)
+	#define atomic_add64(ptr, value) _InterlockedExchangeAdd64((volatile __int64 *) ptr, (__int64)(value))
 	#ifndef inline
 		#define inline __inline
 	#endif
 #elif defined HAVE___SYNC_BOOL_COMPARE_AND_SWAP
 	#define atomic_compare_and_swap __sync_bool_compare_and_swap
+	#define atomic_add64(ptr, value) __sync_fetch_and_add((volatile int64 *)ptr, (int64)(value))
 	#ifdef HAVE___SYNC_ADD_AND_FETCH
 		#define atomic_increment(ptr) __sync_add_and_fetch((volatile long *)ptr, 1)
 	#else
@@ -62,6 +77,10 @@
 	#error "Locking is not supported on this system"
 #endif
 
+/* global lock counters reported by the profiler (see exec.c) */
+extern int64 rlock_count, rlock_spin;
+extern int64 wlock_count, wlock_spin;
+
 /** Enable lock trace 
  **/
 #ifdef LOCKTRACE // this code should only be used in care is mystery lock timeouts
@@ -72,9 +91,9 @@ typedef struct s_locklist {
 	struct s_locklist *next;
 } LOCKLIST;
 LOCKLIST *locklist = NULL;
-/** Register a lock trave
+/** Register a lock trace
  **/
-void register_lock(const char *name, unsigned int *lock)
+static void register_lock_trace(const char *name, unsigned int *lock)
 {
 	LOCKLIST *item = (LOCKLIST*)malloc(sizeof(LOCKLIST));
 	item->name = name;
@@ -113,7 +132,7 @@ void check_lock(unsigned int *lock, bool write, bool unlock)
 			unlock?"un":"  ",
 			lock,
 			*lock);
-		register_lock("unregistered",lock);
+		register_lock_trace("unregistered",lock);
 	}
 	else 
 	{
@@ -131,11 +150,235 @@ void check_lock(unsigned int *lock, bool write, bool unlock)
 }
 #else
 #define check_lock(X,Y,Z)
-void register_lock(unsigned int *lock)
+#endif
+
+/** Lock contention profile
+
+	When #global_lock_profile is set, each lock acquisition that has to wait
+	is counted against the lock it waited for.  The counters are kept in a
+	fixed size table indexed by the address of the lock, so the fast path
+	(an uncontended lock) is never slowed down.  Locks named with
+	register_lock() are reported by name, object locks are reported by
+	object and class, and any other lock by address (see lock_report()).
+ **/
+#define LOCK_TABLESIZE 65536 /* must be a power of 2 */
+#define LOCK_REPORTSIZE 10 /* number of locks and classes listed in the report */
+typedef struct s_lockprofile {
+	unsigned int *lock; /**< the lock (NULL for an unused entry) */
+	const char *name; /**< the name given by register_lock(), if any */
+	int64 contended; /**< number of acquisitions that had to wait */
+	int64 spins; /**< number of failed attempts */
+	int64 cycles; /**< cycles spent waiting */
+} LOCKPROFILE;
+static LOCKPROFILE *lock_table = NULL;
+static int64 lock_untracked = 0; /* waits that could not be counted because the table is full */
+static pthread_mutex_t lock_table_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* cycle counter used to measure waits */
+static inline int64 lock_cycles(void)
 {
-	// do nothing
+#if defined(WIN32) && !defined(__MINGW32__)
+	return (int64)__rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+	unsigned int lo, hi;
+	__asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((int64)hi<<32)|lo;
+#else
+	return (int64)clock();
+#endif
 }
+
+/* find the profile entry of a lock, creating it if necessary */
+static LOCKPROFILE *lock_profile(unsigned int *lock, const char *name)
+{
+	size_t hash = ((size_t)lock>>2)*2654435761u;
+	size_t n;
+	if ( lock_table==NULL )
+	{
+		pthread_mutex_lock(&lock_table_mutex);
+		if ( lock_table==NULL )
+			lock_table = (LOCKPROFILE*)calloc(LOCK_TABLESIZE,sizeof(LOCKPROFILE));
+		pthread_mutex_unlock(&lock_table_mutex);
+		if ( lock_table==NULL )
+			return NULL;
+	}
+	for ( n=0 ; n<LOCK_TABLESIZE ; n++ )
+	{
+		LOCKPROFILE *item = lock_table + ((hash+n)&(LOCK_TABLESIZE-1));
+		if ( item->lock==lock )
+			return item;
+		if ( item->lock==NULL )
+		{
+			// entries are only added under the mutex so the probe sequence never has holes
+			pthread_mutex_lock(&lock_table_mutex);
+			if ( item->lock==NULL )
+			{
+				item->name = name;
+				item->lock = lock;
+			}
+			pthread_mutex_unlock(&lock_table_mutex);
+			if ( item->lock==lock )
+				return item;
+		}
+	}
+	return NULL;
+}
+
+/* find the profile entry of a lock without creating it */
+static LOCKPROFILE *lock_find(unsigned int *lock)
+{
+	size_t hash = ((size_t)lock>>2)*2654435761u;
+	size_t n;
+	for ( n=0 ; lock_table!=NULL && n<LOCK_TABLESIZE ; n++ )
+	{
+		LOCKPROFILE *item = lock_table + ((hash+n)&(LOCK_TABLESIZE-1));
+		if ( item->lock==lock )
+			return item;
+		if ( item->lock==NULL )
+			break;
+	}
+	return NULL;
+}
+
+/** Register a lock name for the contention profile
+ **/
+void register_lock(const char *name, unsigned int *lock)
+{
+	LOCKPROFILE *item;
+#ifdef LOCKTRACE
+	register_lock_trace(name,lock);
 #endif
+	if ( (item=lock_profile(lock,name))!=NULL )
+		item->name = name;
+}
+
+/** Print the lock contention report
+ **/
+void lock_report(void)
+{
+	typedef struct { const char *name; CLASS *oclass; OBJECT *obj; LOCKPROFILE *item; } LOCKREPORT;
+	LOCKREPORT top[LOCK_REPORTSIZE];
+	struct { CLASS *oclass; int64 contended, spins, cycles; } classes[LOCK_REPORTSIZE];
+	size_t n_top = 0, n_classes = 0, n;
+	int64 total_contended = 0, total_cycles = 0;
+	OBJECT *obj;
+	CLASS *oclass;
+	GLOBALVAR *var;
+
+	output_profile("\nLock contention profile");
+	output_profile("=======================\n");
+	if ( lock_table==NULL )
+	{
+		output_profile("No lock contention was observed\n");
+		return;
+	}
+
+	// named and anonymous locks
+	for ( n=0 ; n<LOCK_TABLESIZE ; n++ )
+	{
+		LOCKPROFILE *item = lock_table+n;
+		size_t m;
+		if ( item->lock==NULL )
+			continue;
+		total_contended += item->contended;
+		total_cycles += item->cycles;
+		for ( m=n_top ; m>0 && top[m-1].item->cycles<item->cycles ; m-- )
+			if ( m<LOCK_REPORTSIZE ) top[m] = top[m-1];
+		if ( m<LOCK_REPORTSIZE )
+		{
+			top[m].name = item->name;
+			top[m].oclass = NULL;
+			top[m].obj = NULL;
+			top[m].item = item;
+			if ( n_top<LOCK_REPORTSIZE ) n_top++;
+		}
+	}
+
+	// class and global variable locks
+	for ( oclass=class_get_first_class() ; oclass!=NULL ; oclass=oclass->next )
+	{
+		LOCKPROFILE *item = lock_find(&oclass->profiler.lock);
+		for ( n=0 ; item!=NULL && n<n_top ; n++ )
+		{
+			if ( top[n].item==item && top[n].name==NULL )
+				top[n].oclass = oclass;
+		}
+	}
+	for ( var=global_getnext(NULL) ; var!=NULL ; var=global_getnext(var) )
+	{
+		LOCKPROFILE *item = lock_find(&var->lock);
+		for ( n=0 ; item!=NULL && n<n_top ; n++ )
+		{
+			if ( top[n].item==item && top[n].name==NULL )
+				top[n].name = var->prop->name;
+		}
+	}
+
+	// object locks and their classes
+	for ( obj=object_get_first() ; obj!=NULL ; obj=obj->next )
+	{
+		LOCKPROFILE *item = lock_find(&obj->lock);
+		if ( item==NULL )
+			continue;
+		for ( n=0 ; n<n_top ; n++ )
+		{
+			if ( top[n].item==item )
+			{
+				top[n].obj = obj;
+				top[n].oclass = obj->oclass;
+			}
+		}
+		for ( n=0 ; n<n_classes && classes[n].oclass!=obj->oclass ; n++ ) {}
+		if ( n==n_classes )
+		{
+			if ( n_classes<LOCK_REPORTSIZE )
+			{
+				n_classes++;
+				classes[n].oclass = obj->oclass;
+				classes[n].contended = classes[n].spins = classes[n].cycles = 0;
+			}
+			else
+				continue;
+		}
+		classes[n].contended += item->contended;
+		classes[n].spins += item->spins;
+		classes[n].cycles += item->cycles;
+	}
+
+	output_profile("Contended acquisitions  %8" FMT_INT64 "d", total_contended);
+	output_profile("Total wait              %8.3lf Gcycles", (double)total_cycles/1e9);
+	if ( lock_untracked>0 )
+		output_profile("Untracked waits         %8" FMT_INT64 "d (lock table full)", lock_untracked);
+
+	output_profile("\nMost contended locks     Waits    Spins   Mcycles");
+	output_profile("------------------------ -------- -------- --------");
+	for ( n=0 ; n<n_top ; n++ )
+	{
+		char name[64];
+		if ( top[n].obj!=NULL )
+			object_name(top[n].obj,name,sizeof(name));
+		else if ( top[n].oclass!=NULL )
+			snprintf(name,sizeof(name),"%s profiler",top[n].oclass->name);
+		else if ( top[n].name!=NULL )
+			snprintf(name,sizeof(name),"%s",top[n].name);
+		else
+			snprintf(name,sizeof(name),"%p",top[n].item->lock);
+		output_profile("%-24.24s %8" FMT_INT64 "d %8" FMT_INT64 "d %8.3lf", name, top[n].item->contended, top[n].item->spins, (double)top[n].item->cycles/1e6);
+	}
+
+	output_profile("\nObject locks by class    Waits    Spins   Mcycles");
+	output_profile("------------------------ -------- -------- --------");
+	while ( n_classes>0 )
+	{
+		size_t max = 0;
+		for ( n=1 ; n<n_classes ; n++ )
+			if ( classes[n].cycles>classes[max].cycles ) max = n;
+		oclass = classes[max].oclass;
+		output_profile("%-24.24s %8" FMT_INT64 "d %8" FMT_INT64 "d %8.3lf", oclass->name, classes[max].contended, classes[max].spins, (double)classes[max].cycles/1e6);
+		classes[max] = classes[--n_classes];
+	}
+	output_profile("\n");
+}
 
 #if defined METHOD0 
 /**********************************************************************************
@@ -148,38 +391,103 @@ void register_lock(unsigned int *lock)
    (2) an atomic compare-and-swap (CAS) operation is performed to take the lock by setting the low bit to 1
    (3) if the CAS operation fails, the lock process starts over at (1)
    (4) to unlock the lock value is incremented (which clears the low bit and increments the lock count).
+   A lock that is not taken at the first attempt backs off exponentially using the processor's
+   pause instruction, and yields the processor once the spin budget is used up, so that waiting
+   threads do not saturate the lock's cache line (or starve the thread holding the lock).
  */
-/** Read lock
- **/
-extern "C" void rlock(unsigned int *lock)
+
+/* number of failed attempts before a waiting thread starts yielding the processor */
+#define SPINBUDGET 64
+/* maximum number of pauses between attempts */
+#define MAXBACKOFF 1024
+
+static inline void lock_pause(void)
+{
+#if defined(WIN32) && !defined(__MINGW32__)
+	YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+	__asm__ __volatile__ ("pause");
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ __volatile__ ("yield");
+#endif
+}
+
+static inline void lock_yield(void)
+{
+#ifdef WIN32
+	SwitchToThread();
+#else
+	sched_yield();
+#endif
+}
+
+/* wait until the lock is taken, after the first attempt failed */
+static void lock_wait(unsigned int *lock, const char *timeout_message, int64 *spin_counter)
 {
 	unsigned int timeout = MAXSPIN;
+	unsigned int backoff = 1;
+	unsigned int spins = 0;
 	unsigned int value;
-	extern unsigned int rlock_count, rlock_spin;
-	check_lock(lock,false,false);
-	atomic_increment(&rlock_count);
+	int64 started = global_lock_profile ? lock_cycles() : 0;
 	do {
-		value = (*lock);
-		atomic_increment(&rlock_spin);
+		unsigned int n;
+		if ( spins++<SPINBUDGET )
+		{
+			for ( n=0 ; n<backoff ; n++ )
+				lock_pause();
+			if ( backoff<MAXBACKOFF )
+				backoff *= 2;
+		}
+		else
+			lock_yield();
 		if ( timeout--==0 ) 
-			throw_exception("read lock timeout");
+			throw_exception("%s",timeout_message);
+		value = (*lock);
 	} while ((value&1) || !atomic_compare_and_swap(lock, value, value + 1));
+
+	if ( global_profiler )
+		atomic_add64(spin_counter, spins);
+	if ( global_lock_profile )
+	{
+		LOCKPROFILE *item = lock_profile(lock,NULL);
+		if ( item!=NULL )
+		{
+			atomic_add64(&item->contended, 1);
+			atomic_add64(&item->spins, spins);
+			atomic_add64(&item->cycles, lock_cycles()-started);
+		}
+		else
+			atomic_add64(&lock_untracked, 1);
+	}
+}
+
+/** Read lock
+ **/
+extern "C" void rlock(unsigned int *lock)
+{
+	unsigned int value = (*lock);
+	check_lock(lock,false,false);
+	if ( global_profiler )
+	{
+		atomic_add64(&rlock_count, 1);
+		atomic_add64(&rlock_spin, 1);
+	}
+	if ((value&1) || !atomic_compare_and_swap(lock, value, value + 1))
+		lock_wait(lock, "read lock timeout", &rlock_spin);
 }
 /** Write lock 
  **/
 extern "C" void wlock(unsigned int *lock)
 {
-	unsigned int timeout = MAXSPIN;
-	unsigned int value;
-	extern unsigned int wlock_count, wlock_spin;
+	unsigned int value = (*lock);
 	check_lock(lock,true,false);
-	atomic_increment(&wlock_count);
-	do {
-		value = (*lock);
-		atomic_increment(&wlock_spin);
-		if ( timeout--==0 ) 
-			throw_exception("write lock timeout");
-	} while ((value&1) || !atomic_compare_and_swap(lock, value, value + 1));
+	if ( global_profiler )
+	{
+		atomic_add64(&wlock_count, 1);
+		atomic_add64(&wlock_spin, 1);
+	}
+	if ((value&1) || !atomic_compare_and_swap(lock, value, value + 1))
+		lock_wait(lock, "write lock timeout", &wlock_spin);
 }
 /** Read unlock
  **/
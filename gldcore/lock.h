@@ -15,6 +15,7 @@ void runlock(unsigned int *lock);
 void wunlock(unsigned int *lock);
 
 void register_lock(const char *name, unsigned int *lock);
+void lock_report(void);
 
 #ifdef __cplusplus
 }
@@ -82,6 +82,7 @@
 #include "exec.h"
 #include "stream.h"
 #include "transform.h"
+#include "arena.h"
 
 #include "console.h"
 
@@ -189,7 +190,7 @@ static CALLBACKS callbacks = {
 	{class_define_function,class_get_function},
 	class_define_enumeration_member,
 	class_define_set_member,
-	{object_get_first,object_set_dependent,object_set_parent,object_set_rank,},
+	{object_get_first,object_set_dependent,object_set_parent,object_set_rank,arena_get_first,arena_get_next,},
 	{object_get_property, object_set_value_by_addr,object_get_value_by_addr, object_set_value_by_name,object_get_value_by_name,object_get_reference,object_get_unit,object_get_addr,class_string_to_propertytype,property_compare_basic,property_compare_op,property_get_part,property_getspec},
 	{find_objects,find_next,findlist_copy,findlist_add,findlist_del,findlist_clear},
 	class_find_property,
@@ -42,6 +42,8 @@
 #include "lock.h"
 #include "threadpool.h"
 #include "exec.h"
+#include "watchdog.h"
+#include "arena.h"
 
 SET_MYCONTEXT(DMC_OBJECT)
 
@@ -50,8 +52,9 @@ static OBJECTNUM next_object_id = 0;
 static OBJECTNUM deleted_object_count = 0;
 static OBJECT *first_object = NULL;
 static OBJECT *last_object = NULL;
-static OBJECTNUM object_array_size = 0;
-static OBJECT **object_array = NULL;
+static OBJECTNUM object_array_size = 0; /* capacity of the object id table */
+static OBJECT **object_array = NULL; /* objects indexed by id (see object_find_by_id) */
+static unsigned int header_serial = 0; /* changes when a header is changed or an object is removed (see object_get_header_serial) */
 
 /* {name, val, next} */
 KEYWORD oflags[] = {
@@ -107,6 +110,7 @@ PROPERTY *object_access_property(){
 
 /* prototypes */
 void object_tree_delete(OBJECT *obj, OBJECTNAME name);
+static void name_index_remove_object(OBJECT *obj);
 
 /** Get the number of objects defined 
 
@@ -116,6 +120,30 @@ unsigned int object_get_count(){
 	return next_object_id - deleted_object_count;
 }
 
+/** Get the id limit of the objects defined
+
+	@return one more than the largest object id in use (deleted objects included)
+ **/
+OBJECTNUM object_get_id_limit(void)
+{
+	return next_object_id;
+}
+
+/** Get the serial number of the object headers
+
+	The serial number changes whenever the name, parent, rank, group or other
+	header value of an object is changed through the core, and whenever an
+	object is removed.  It is used to check whether information derived from
+	the headers (e.g., the find indexes) is still valid.  Objects created since
+	do not change the serial number.
+
+	@return the current header serial number
+ **/
+unsigned int object_get_header_serial(void)
+{
+	return header_serial;
+}
+
 /** Get a named property of an object.  
 
 	Note that you must use object_get_value_by_name to retrieve the value of
@@ -165,35 +193,30 @@ PROPERTY *object_get_property(OBJECT *obj, /**< a pointer to the object */
 	}
 }
 
-/**	This will build (or rebuild) an array with all the instantiated GridLab-D objects
-	placed at indices that correspond to their internal object ID.
-	
-	@return the number of objects instantiated when the call was made
-*/
-int object_build_object_array(){
-	unsigned int tcount = object_get_count();
-	unsigned int i = 0;
-	OBJECT *optr = object_get_first();
-	
-	if(object_array != NULL){
-		free(object_array);
-		object_array = NULL;
-	}
-	
-	object_array = malloc(sizeof(OBJECT *) * tcount);
-	
-	if(object_array == NULL){
-		return 0;
-	}
-	
-	object_array_size = tcount;
-	
-	for(i = 0; i < tcount; ++i){
-		object_array[i] = optr;
-		optr = optr->next;
+/*	Add an object to the table of objects indexed by id, growing the table as needed.
+	Throws an exception on memory errors.
+ */
+static void object_index_id(OBJECT *obj)
+{
+	if ( obj->id>=object_array_size )
+	{
+		OBJECTNUM size = object_array_size>0 ? object_array_size : 1024;
+		OBJECT **array;
+		while ( size<=obj->id )
+			size *= 2;
+		array = (OBJECT**)realloc(object_array,sizeof(OBJECT*)*size);
+		if ( array==NULL )
+		{
+			throw_exception("object_index_id(obj=%s:%d): memory allocation failed", obj->oclass->name, obj->id);
+			/* TROUBLESHOOT
+				The memory required to index the object by its id is not available.  Try freeing up system memory and try again.
+			 */
+		}
+		memset(array+object_array_size,0,sizeof(OBJECT*)*(size-object_array_size));
+		object_array = array;
+		object_array_size = size;
 	}
-	
-	return object_array_size;
+	object_array[obj->id] = obj;
 }
 
 
@@ -213,27 +236,7 @@ PROPERTY *object_prop_in_class(OBJECT *obj, PROPERTY *prop){
 	@return a pointer the object
  **/
 OBJECT *object_find_by_id(OBJECTNUM id){ /**< object id number */
-	OBJECT *obj;
-	
-	if(object_get_count() == object_array_size){
-		if(id < object_array_size){
-			return object_array[id];
-		} else {
-			return NULL;
-		}
-	} else {
-		/* this either fails or sets object_array_size to object_get_count() */
-		if(object_build_object_array())
-			return object_find_by_id(id);
-	}
-	
-	for(obj = first_object; obj != NULL; obj = obj->next){
-		if(obj->id == id){
-			return obj; /* "break"*/
-		}
-	}
-	
-	return NULL;
+	return id<object_array_size ? object_array[id] : NULL;
 }
 
 
@@ -291,17 +294,10 @@ char *object_get_unit(OBJECT *obj, char *name)
 	- \p ENOMEM memory allocation failed
  **/
 OBJECT *object_create_single(CLASS *oclass){ /**< the class of the object */
-	/* @todo support threadpool during object creation by calling this malloc from the appropriate thread */
 	OBJECT *obj = 0;
-	static int tp_next = 0;
-	static int tp_count = 0;
 	PROPERTY *prop;
 	int sz = sizeof(OBJECT);
 
-	if(tp_count == 0){
-		tp_count = processor_count();
-	}
-
 	if(oclass == NULL){
 		throw_exception("object_create_single(CLASS *oclass=NULL): class is NULL");
 		/* TROUBLESHOOT
@@ -318,7 +314,11 @@ OBJECT *object_create_single(CLASS *oclass){ /**< the class of the object */
 		*/
 	}
 
-	obj = (OBJECT*)malloc(sz + oclass->size);
+	/* objects of the same class are kept together unless arenas are disabled (e.g., for memory debugging) */
+	if ( global_object_arena )
+		obj = arena_alloc(oclass);
+	else
+		obj = (OBJECT*)malloc(sz + oclass->size);
 
 	if(obj == NULL){
 		throw_exception("object_create_single(CLASS *oclass='%s'): memory allocation failed", oclass->name);
@@ -329,8 +329,6 @@ OBJECT *object_create_single(CLASS *oclass){ /**< the class of the object */
 
 	memset(obj, 0, sz + oclass->size);
 
-	tp_next %= tp_count;
-
 	obj->id = next_object_id++;
 	obj->oclass = oclass;
 	obj->next = NULL;
@@ -355,6 +353,7 @@ OBJECT *object_create_single(CLASS *oclass){ /**< the class of the object */
 	for ( prop=obj->oclass->pmap; prop!=NULL; prop=(prop->next?prop->next:(prop->oclass->parent?prop->oclass->parent->pmap:NULL)))
 		property_create(prop,(void*)((char *)(obj+1)+(int64)(prop->addr)));
 	
+	object_index_id(obj);
 	if(first_object == NULL){
 		first_object = obj;
 	} else {
@@ -419,6 +418,7 @@ OBJECT *object_create_foreign(OBJECT *obj) /**< a pointer to the OBJECT data str
 	obj->out_svc_double = (double)obj->out_svc;
 	obj->flags = OF_FOREIGN;
 	
+	object_index_id(obj);
 	if(first_object == NULL){
 		first_object = obj;
 	} else {
@@ -439,6 +439,9 @@ void object_stream_fixup(OBJECT *obj, char *classname, char *objname)
 	obj->name = (char*)malloc(strlen(objname)+1);
 	strcpy(obj->name,objname);
 	obj->next = NULL;
+	if ( obj->id>=next_object_id )
+		next_object_id = obj->id+1;
+	object_index_id(obj);
 	if ( first_object==NULL )
 		first_object = obj;
 	else
@@ -487,10 +490,15 @@ OBJECT *object_remove_by_id(OBJECTNUM id){
 		}
 		
 		object_tree_delete(target, target->name ? target->name : (sprintf(name, "%s:%d", target->oclass->name, target->id), name));
+		name_index_remove_object(target);
+		header_serial++;
+		object_array[target->id] = NULL;
 		next = target->next;
 		prev->next = next;
 		target->oclass->profiler.numobjs--;
-		free(target);
+		if(!arena_contains(target)){
+			free(target); /* arena slots are released with the arena */
+		}
 		target = NULL;
 		deleted_object_count++;
 	}
@@ -819,6 +827,7 @@ static int set_header_value(OBJECT *obj, char *name, char *value)
 	TIMESTAMP tval;
 	double tval_double;
 
+	header_serial++;
 	if(strcmp(name,"name")==0)
 	{
 		if(obj->name!=NULL)
@@ -1321,7 +1330,8 @@ static int _set_rankx(OBJECT *obj, OBJECTRANK rank, OBJECT *first)
 }
 static int set_rank(OBJECT *obj, OBJECTRANK rank, OBJECT *first)
 {
-	global_bigranks==TRUE ? _set_rankx(obj,rank,NULL) : _set_rank(obj,rank,NULL);
+	header_serial++;
+	return global_bigranks==TRUE ? _set_rankx(obj,rank,NULL) : _set_rank(obj,rank,NULL);
 }
 
 /** Set the rank of an object but forcing it's parent
@@ -1358,6 +1368,7 @@ int object_set_parent(OBJECT *obj, /**< the object to set */
 	}
 	obj->parent = parent;
 	obj->child_count++;
+	header_serial++;
 	if(parent!=NULL)
 		return set_rank(parent,obj->rank,NULL);
 	return obj->rank;
@@ -1461,10 +1472,8 @@ TIMESTAMP _object_sync(OBJECT *obj, /**< the object to synchronize */
 		return TS_INVALID;
 	}
 
-#ifndef WIN32
-	/* setup lockup alarm */
-	alarm(global_maximum_synctime);
-#endif
+	/* tell the watchdog which object is syncing */
+	watchdog_enter(obj,pass);
 
 	/* call recalc if recalc bit is set */
 	if( (obj->flags&OF_RECALC) && obj->oclass->recalc!=NULL)
@@ -1496,10 +1505,8 @@ TIMESTAMP _object_sync(OBJECT *obj, /**< the object to synchronize */
 	else
 		obj->valid_to = sync_time; // NOTE, this can be negative
 
-#ifndef WIN32
-	/* clear lockup alarm */
-	alarm(0);
-#endif
+	/* sync is done */
+	watchdog_leave();
 
 	return obj->valid_to;
 }
@@ -2126,11 +2133,146 @@ typedef struct s_objecttree {
 	char name[64];
 	OBJECT *obj;
 	struct s_objecttree *before, *after;
-	int balance; /* unused */
+	int height; /* height of the subtree */
 } OBJECTTREE;
 
 static OBJECTTREE *top=NULL;
 
+/***************************************************************************
+ OBJECT NAME INDEX
+
+ Names are looked up in an open-addressing hash table of the tree items,
+ so finding an object by name does not depend on the shape of the tree.
+ ***************************************************************************/
+
+static OBJECTTREE **name_index = NULL; /* tree items by name hash (linear probing) */
+static size_t name_index_size = 0; /* number of slots (a power of 2) */
+static size_t name_index_count = 0; /* number of slots in use */
+
+static size_t name_hash(const char *name)
+{
+	/* FNV-1a */
+	unsigned int64 hash = 0xcbf29ce484222325LL;
+	while ( *name!='\0' )
+	{
+		hash ^= (unsigned char)*name++;
+		hash *= 0x100000001b3LL;
+	}
+	return (size_t)hash;
+}
+
+static OBJECTTREE *name_index_find(const char *name)
+{
+	size_t n;
+	if ( name_index==NULL )
+		return NULL;
+	for ( n=name_hash(name)&(name_index_size-1) ; name_index[n]!=NULL ; n=(n+1)&(name_index_size-1) )
+	{
+		if ( strcmp(name_index[n]->name,name)==0 )
+			return name_index[n];
+	}
+	return NULL;
+}
+
+static void name_index_insert(OBJECTTREE *item)
+{
+	size_t n;
+	for ( n=name_hash(item->name)&(name_index_size-1) ; name_index[n]!=NULL ; n=(n+1)&(name_index_size-1) )
+	{
+		if ( strcmp(name_index[n]->name,item->name)==0 )
+		{
+			name_index[n] = item;
+			return;
+		}
+	}
+	name_index[n] = item;
+	name_index_count++;
+}
+
+/*	Add a tree item to the name index.  Throws exceptions on memory errors.
+ */
+static void name_index_add(OBJECTTREE *item)
+{
+	/* keep the table at most half full */
+	if ( (name_index_count+1)*2>name_index_size )
+	{
+		OBJECTTREE **old = name_index;
+		size_t old_size = name_index_size, n;
+		size_t size = name_index_size>0 ? name_index_size*2 : 1024;
+		name_index = (OBJECTTREE**)calloc(size,sizeof(OBJECTTREE*));
+		if ( name_index==NULL )
+		{
+			name_index = old;
+			throw_exception("name_index_add(name='%s'): memory allocation failed", item->name);
+			/* TROUBLESHOOT
+				The memory required to index the object names is not available.  Try freeing up system memory and try again.
+			 */
+		}
+		name_index_size = size;
+		name_index_count = 0;
+		for ( n=0 ; n<old_size ; n++ )
+		{
+			if ( old[n]!=NULL )
+				name_index_insert(old[n]);
+		}
+		free(old);
+	}
+	name_index_insert(item);
+}
+
+/*	Remove a tree item from the name index.
+ */
+static void name_index_remove(OBJECTTREE *item)
+{
+	size_t n, m;
+	if ( name_index==NULL )
+		return;
+	for ( n=name_hash(item->name)&(name_index_size-1) ; name_index[n]!=NULL && name_index[n]!=item ; n=(n+1)&(name_index_size-1) ) {}
+	if ( name_index[n]==NULL )
+		return;
+
+	/* shift back the items that follow in the same probe sequence */
+	name_index[n] = NULL;
+	name_index_count--;
+	for ( m=(n+1)&(name_index_size-1) ; name_index[m]!=NULL ; m=(m+1)&(name_index_size-1) )
+	{
+		OBJECTTREE *moved = name_index[m];
+		name_index[m] = NULL;
+		name_index_count--;
+		name_index_insert(moved);
+	}
+}
+
+/*	Remove the current name of an object from the name index.
+ */
+static void name_index_remove_object(OBJECT *obj)
+{
+	OBJECTTREE *item = obj->name ? name_index_find(obj->name) : NULL;
+	if ( item!=NULL && item->obj==obj )
+		name_index_remove(item);
+}
+
+/*	Free a tree and its items.
+ */
+static void object_tree_free(OBJECTTREE *tree)
+{
+	if ( tree!=NULL )
+	{
+		object_tree_free(tree->before);
+		object_tree_free(tree->after);
+		free(tree);
+	}
+}
+
+/*	Remove all the items from the name index.
+ */
+static void name_index_clear(void)
+{
+	free(name_index);
+	name_index = NULL;
+	name_index_size = name_index_count = 0;
+}
+
 void debug_traverse_tree(OBJECTTREE *tree){
 	if(tree == NULL){
 		tree = top;
@@ -2149,15 +2291,19 @@ void debug_traverse_tree(OBJECTTREE *tree){
 
 /* returns the height of the tree */
 int tree_get_height(OBJECTTREE *tree){
-	if(tree == NULL){
-		return 0;
-	} else {
-		int left = tree_get_height(tree->before);
-		int right = tree_get_height(tree->after);
-		if(left > right)
-			return left+1;
-		else return right+1;
-	}
+	return tree==NULL ? 0 : tree->height;
+}
+
+/* updates the height of a node from the heights of its subtrees */
+static void tree_update_height(OBJECTTREE *tree){
+	int left = tree_get_height(tree->before);
+	int right = tree_get_height(tree->after);
+	tree->height = (left > right ? left : right) + 1;
+}
+
+/* returns the balance of a node (positive when the right subtree is taller) */
+static int tree_get_balance(OBJECTTREE *tree){
+	return tree_get_height(tree->after) - tree_get_height(tree->before);
 }
 
 /* returns the node to point to instead of tree */
@@ -2169,8 +2315,8 @@ void rotate_tree_right(OBJECTTREE **tree){ /* move one object from left to right
 	*tree = pivot;
 	pivot->after = root;
 	root->before = child;
-	root->balance += 2;
-	pivot->balance += 1;
+	tree_update_height(root);
+	tree_update_height(pivot);
 }
 
 /* returns the node to point to instead of tree */
@@ -2182,8 +2328,8 @@ void rotate_tree_left(OBJECTTREE **tree){ /* move one object from right to left
 	*tree = pivot;
 	pivot->before = root;
 	root->after = child;
-	root->balance -= 2;
-	pivot->balance -= 1;
+	tree_update_height(root);
+	tree_update_height(pivot);
 }
 
 /*  Rebalance the tree to make searching more efficient
@@ -2196,11 +2342,11 @@ int object_tree_rebalance(OBJECTTREE *tree) /* AVL logic */
 }
 
 /*	Add an item to the tree
-	returns the "correct" root node for the subtree that an object was added to.
+	returns non-zero if the item was added (or the object already has this name), 0 if the name is used by another object
  */
 static int addto_tree(OBJECTTREE **tree, OBJECTTREE *item){
 	int rel = strcmp((*tree)->name, item->name);
-	int right = 0, left = 0, ir = 0, il = 0, rv = 0, height = 0;
+	int rv = 1, balance = 0;
 
 	// find location to insert new object
 	if(rel > 0){
@@ -2208,41 +2354,35 @@ static int addto_tree(OBJECTTREE **tree, OBJECTTREE *item){
 			(*tree)->before = item;
 		} else {
 			rv = addto_tree(&((*tree)->before), item);
-			if(global_no_balance){
-				return rv + 1;
-			}
 		}
 	} else if(rel<0) {
 		if((*tree)->after == NULL) {
 			(*tree)->after = item;
 		} else {
 			rv = addto_tree(&((*tree)->after),item);
-			if(global_no_balance){
-				return rv + 1;
-			}
 		}
 	} else {
 		return (*tree)->obj==item->obj;
 	}
-
-	// check balance
-	right = tree_get_height((*tree)->after);
-	left = tree_get_height((*tree)->before);
-	(*tree)->balance = right - left;
+	tree_update_height(*tree);
+	if(global_no_balance){
+		return rv;
+	}
 
 	// rotations needed?
-	if((*tree)->balance > 1){
-		if((*tree)->after->balance < 0){ /* inner left is heavy */
+	balance = tree_get_balance(*tree);
+	if(balance > 1){
+		if(tree_get_balance((*tree)->after) < 0){ /* inner left is heavy */
 			rotate_tree_right(&((*tree)->after));
 		}
 		rotate_tree_left(tree);	//	was left/right
-	} else if((*tree)->balance < -1){
-		if((*tree)->before->balance > 0){ /* inner right is heavy */
+	} else if(balance < -1){
+		if(tree_get_balance((*tree)->before) > 0){ /* inner right is heavy */
 			rotate_tree_left(&((*tree)->before));
 		}
 		rotate_tree_right(tree);
 	}
-	return tree_get_height(*tree); /* verify after rotations */
+	return rv;
 }
 
 /*	Add an object to the object tree.  Throws exceptions on memory errors.
@@ -2260,20 +2400,19 @@ static OBJECTTREE *object_tree_add(OBJECT *obj, OBJECTNAME name){
 	}
 	
 	item->obj = obj;
-	item->balance = 0;
+	item->height = 1;
 	strncpy(item->name, name, sizeof(item->name));
+	item->name[sizeof(item->name)-1] = '\0';
 	item->before = item->after = NULL;
 
 	if(top == NULL){
 		top = item;
-		return top;
-	} else {
-		if(addto_tree(&top, item) != 0){
-			return item;
-		} else {
-			return NULL;
-		}
+	} else if(addto_tree(&top, item) == 0){
+		free(item);
+		return NULL;
 	}
+	name_index_add(item);
+	return item;
 }
 
 /*	Finds a name in the tree
@@ -2320,6 +2459,7 @@ void object_tree_delete(OBJECT *obj, OBJECTNAME name)
 	OBJECTTREE *temp = NULL, **dtemp = NULL;
 
 	if(item != NULL && strcmp((*item)->name, name)!=0){
+		name_index_remove(*item);
 		if((*item)->after == NULL && (*item)->before == NULL){ /* no children -- nuke */
 			free(*item);
 			*item = NULL;
@@ -2360,16 +2500,27 @@ void object_tree_delete(OBJECT *obj, OBJECTNAME name)
 	@return a pointer to the OBJECT structure
  **/
 OBJECT *object_find_name(OBJECTNAME name){
-	OBJECTTREE **item = NULL;
+	OBJECTTREE *item = name_index_find(name);
+	char *last = NULL, *next;
 
-	item = findin_tree(top, name);
-	
-	if(item != NULL && *item != NULL){
-		return (*item)->obj;
-	} else {
-		/* normal operation, remain silent */
-		return NULL;
+	if(item != NULL){
+		return item->obj;
+	}
+
+	/* a name qualified by the namespace of the object, e.g., "space::name" */
+	for(next = strstr(name, "::"); next != NULL; next = strstr(next+2, "::")){
+		last = next;
 	}
+	if(last != NULL && (item = name_index_find(last+2)) != NULL){
+		char space[1024];
+		size_t len = last - name;
+		if(object_get_namespace(item->obj, space, sizeof(space)) && strlen(space) == len && strncmp(space, name, len) == 0){
+			return item->obj;
+		}
+	}
+
+	/* normal operation, remain silent */
+	return NULL;
 }
 
 int object_build_name(OBJECT *obj, char *buffer, int len){
@@ -2412,6 +2563,7 @@ int object_build_name(OBJECT *obj, char *buffer, int len){
 OBJECTNAME object_set_name(OBJECT *obj, OBJECTNAME name){
 	OBJECTTREE *item = NULL;
 
+	header_serial++;
 	if((isalpha(name[0]) != 0) || (name[0] == '_')){
 		; // good
 	} else {
@@ -2458,11 +2610,19 @@ void remove_objects(){
 	while(obj1 != NULL){
 		first_object = obj1->next;
 		obj1->oclass->profiler.numobjs--;
-		free(obj1);
+		if ( !arena_contains(obj1) )
+			free(obj1);
 		obj1 = first_object;
 	}
+	arena_release();
+	object_tree_free(top);
+	top = NULL;
+	name_index_clear();
+	if ( object_array!=NULL )
+		memset(object_array,0,sizeof(OBJECT*)*object_array_size);
 
 	next_object_id = 0;
+	header_serial++;
 }
 
 /*****************************************************************************************************
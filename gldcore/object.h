@@ -133,6 +133,8 @@ typedef struct s_callbacks {
 		int (*set_dependent)(OBJECT*,OBJECT*);
 		int (*set_parent)(OBJECT*,OBJECT*);
 		int (*set_rank)(OBJECT*,unsigned int);
+		OBJECT *(*get_first_in_class)(CLASS*);
+		OBJECT *(*get_next_in_class)(OBJECT*);
 	} object;
 	struct {
 		PROPERTY *(*get_property)(OBJECT*,PROPERTYNAME,PROPERTYSTRUCT*);
@@ -400,6 +402,8 @@ OBJECT *object_find_by_id(OBJECTNUM id);
 OBJECT *object_get_first(void);
 OBJECT *object_get_next(OBJECT *obj);
 unsigned int object_get_count(void);
+OBJECTNUM object_get_id_limit(void);
+unsigned int object_get_header_serial(void);
 int object_dump(char *buffer, int size, OBJECT *obj);
 int object_save(char *buffer, int size, OBJECT *obj);
 int object_saveall(FILE *fp);
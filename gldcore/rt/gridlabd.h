@@ -758,11 +758,11 @@ typedef struct s_datetime { ///< The s_datetime structure
 
 struct s_schedule {
 	char name[64];						/**< the name of the schedule */
-	char definition[65536];				/**< the definition string of the schedule */
+	char *definition;					/**< the definition string of the schedule */
 	char blockname[MAXBLOCKS][64];		/**< the name of each block */
 	unsigned char block;				/**< the last block used (4 max) */
-	unsigned char index[14][366*24*60];	/**< the schedule index (enough room for all 14 annual calendars to 1 minute resolution) */
-	uint32 dtnext[14][366*24*60];/**< the time until the next schedule change (in minutes) */
+	struct s_schedulecalendar *calendar[14];	/**< the compiled annual calendars (shared with other schedules) */
+	unsigned char invariant;			/**< flag indicating the schedule value never changes */
 	double data[MAXBLOCKS*MAXVALUES];	/**< the list of values used in each block */
 	unsigned int weight[MAXBLOCKS*MAXVALUES];	/**< the weight (in minutes) associate with each value */
 	double sum[MAXBLOCKS];				/**< the sum of values for each block -- used to normalize */
@@ -177,13 +177,13 @@ int find_value_index (SCHEDULE *sch, /// schedule to search
 	return -1;
 }
 
-/* compiles a single schedule block and report errors
+/* compiles a single schedule block into the minute index of each calendar and report errors
    returns 1 on success, 0 on failure 
  */
 
-int schedule_compile_block(SCHEDULE *sch, char *blockname, char *blockdef)
+int schedule_compile_block(SCHEDULE *sch, unsigned char index[14][366*24*60], char *blockname, char *blockdef)
 {
-	char *token = NULL;
+	char *token = NULL, *last = NULL;
 	unsigned int minute=0;
 
 	/* check block count */
@@ -198,7 +198,7 @@ int schedule_compile_block(SCHEDULE *sch, char *blockname, char *blockdef)
 
 	/* first index is always default value 0 */
 	sch->count[sch->block]=1;
-	while ( (token=strtok(token==NULL?blockdef:NULL,";\r\n"))!=NULL )
+	while ( (token=strtok_s(token==NULL?blockdef:NULL,";\r\n",&last))!=NULL )
 	{
 		struct {
 			char *name;
@@ -317,10 +317,10 @@ int schedule_compile_block(SCHEDULE *sch, char *blockname, char *blockdef)
 						{
 							if (matcher[0].table[minute%60])
 							{
-								if (sch->index[calendar][minute]>0)
+								if (index[calendar][minute]>0)
 								{
 									char *dayofweek[] = {"Sun","Mon","Tue","Wed","Thu","Fri","Sat","Sun","Hol"};
-									output_error("schedule_compile(SCHEDULE *sch={name='%s', ...}) '%s' in block '%s' has a conflict with value %g on %s %d/%d %02d:%02d", sch->name, token, blockname, sch->data[sch->index[calendar][minute]], dayofweek[weekday], month+1, day+1, hour, minute%60);
+									output_error("schedule_compile(SCHEDULE *sch={name='%s', ...}) '%s' in block '%s' has a conflict with value %g on %s %d/%d %02d:%02d", sch->name, token, blockname, sch->data[index[calendar][minute]], dayofweek[weekday], month+1, day+1, hour, minute%60);
 									/* TROUBLESHOOT
 									   The schedule definition is not valid and has been ignored.  Check the syntax of your schedule and try again.
 									 */
@@ -329,7 +329,7 @@ int schedule_compile_block(SCHEDULE *sch, char *blockname, char *blockdef)
 								else
 								{
 									/* associate this time with the current value */
-									sch->index[calendar][minute] = n;
+									index[calendar][minute] = n;
 									sch->weight[n]++;
 									sch->minutes[sch->block]++;
 
@@ -346,13 +346,13 @@ int schedule_compile_block(SCHEDULE *sch, char *blockname, char *blockdef)
 	return 1;
 }
 
-/* compiles a multi-block schedule and report errors
+/* compiles a multi-block schedule into the minute index of each calendar and report errors
    returns 1 on success, 0 on failure 
  */
-int schedule_compile(SCHEDULE *sch)
+int schedule_compile(SCHEDULE *sch, unsigned char index[14][366*24*60])
 {
 	char *p = sch->definition, *q = NULL;
-	char blockdef[65536];
+	char blockdef[MAXDEFINITION];
 	char blockname[64];
 	enum {INIT, NAME, OPEN, BLOCK, CLOSE} state = INIT;
 	int comment=0;
@@ -364,7 +364,7 @@ int schedule_compile(SCHEDULE *sch)
 		/* remove leading whitespace */
 		while (isspace(*p)) p++;
 		strcpy(blockdef,p);
-		if (schedule_compile_block(sch,"*",blockdef))
+		if (schedule_compile_block(sch,index,"*",blockdef))
 		{
 			sch->block++;
 			return 1;
@@ -486,7 +486,7 @@ int schedule_compile(SCHEDULE *sch)
 				state = CLOSE;
 				q = NULL;
 				p++;
-				if (schedule_compile_block(sch,blockname,blockdef))
+				if (schedule_compile_block(sch,index,blockname,blockdef))
 					sch->block++;
 				else
 					return 0;
@@ -515,6 +515,184 @@ int schedule_compile(SCHEDULE *sch)
 	return 1;
 }
 
+/* compiled calendars are shared by all schedules that use the same runs */
+#define CALENDAR_BUCKETS 1024
+static SCHEDULECALENDAR *calendar_cache[CALENDAR_BUCKETS];
+static unsigned int calendar_lock = 0;
+static unsigned int calendar_count = 0;
+static size_t calendar_size = 0;
+
+/* FNV-1a hash of the calendar runs */
+static unsigned int schedule_calendar_hash(unsigned int n_runs, uint32 *minute, uint32 *end, unsigned char *index)
+{
+	unsigned int h = 2166136261u;
+	unsigned int n;
+	for ( n=0 ; n<n_runs ; n++ )
+	{
+		h = (h^minute[n])*16777619u;
+		h = (h^end[n])*16777619u;
+		h = (h^index[n])*16777619u;
+	}
+	return h;
+}
+
+/* find or add a compiled calendar in the calendar cache
+   returns the shared calendar, or NULL on failure
+ */
+static SCHEDULECALENDAR *schedule_calendar_share(unsigned int n_runs, uint32 *minute, uint32 *end, unsigned char *index)
+{
+	unsigned int hash = schedule_calendar_hash(n_runs,minute,end,index);
+	SCHEDULECALENDAR *cal;
+	size_t size = sizeof(SCHEDULECALENDAR) + n_runs*(2*sizeof(uint32)+sizeof(unsigned char));
+
+	wlock(&calendar_lock);
+	for ( cal=calendar_cache[hash%CALENDAR_BUCKETS] ; cal!=NULL ; cal=cal->next )
+	{
+		if ( cal->hash==hash && cal->n_runs==n_runs
+			&& memcmp(cal->minute,minute,n_runs*sizeof(uint32))==0
+			&& memcmp(cal->end,end,n_runs*sizeof(uint32))==0
+			&& memcmp(cal->index,index,n_runs*sizeof(unsigned char))==0 )
+		{
+			cal->refcount++;
+			wunlock(&calendar_lock);
+			return cal;
+		}
+	}
+
+	/* the runs are stored in the same block as the calendar */
+	cal = (SCHEDULECALENDAR*)malloc(size);
+	if ( cal!=NULL )
+	{
+		cal->n_runs = n_runs;
+		cal->minute = (uint32*)(cal+1);
+		cal->end = cal->minute + n_runs;
+		cal->index = (unsigned char*)(cal->end + n_runs);
+		memcpy(cal->minute,minute,n_runs*sizeof(uint32));
+		memcpy(cal->end,end,n_runs*sizeof(uint32));
+		memcpy(cal->index,index,n_runs*sizeof(unsigned char));
+		cal->hash = hash;
+		cal->refcount = 1;
+		cal->next = calendar_cache[hash%CALENDAR_BUCKETS];
+		calendar_cache[hash%CALENDAR_BUCKETS] = cal;
+		calendar_count++;
+		calendar_size += size;
+	}
+	wunlock(&calendar_lock);
+	return cal;
+}
+
+/* release the compiled calendars used by a schedule */
+static void schedule_calendar_release(SCHEDULE *sch)
+{
+	int c;
+	wlock(&calendar_lock);
+	for ( c=0 ; c<14 ; c++ )
+	{
+		SCHEDULECALENDAR *cal = sch->calendar[c], **prev;
+		if ( cal==NULL || --cal->refcount>0 )
+			continue;
+		for ( prev=&calendar_cache[cal->hash%CALENDAR_BUCKETS] ; *prev!=cal ; prev=&(*prev)->next )
+			;
+		*prev = cal->next;
+		calendar_count--;
+		calendar_size -= sizeof(SCHEDULECALENDAR) + cal->n_runs*(2*sizeof(uint32)+sizeof(unsigned char));
+		free(cal);
+	}
+	wunlock(&calendar_lock);
+	memset(sch->calendar,0,sizeof(sch->calendar));
+}
+
+/* convert the minute index of each calendar into shared runs
+   returns 1 on success, 0 on failure
+ */
+static int schedule_calendar_build(SCHEDULE *sch, unsigned char index[14][366*24*60])
+{
+	const uint32 n_minutes = 366*24*60;
+	uint32 *minute = (uint32*)malloc(sizeof(uint32)*n_minutes);
+	uint32 *end = (uint32*)malloc(sizeof(uint32)*n_minutes);
+	unsigned char *value = (unsigned char*)malloc(n_minutes);
+	unsigned int calendar;
+	int ok = (minute!=NULL && end!=NULL && value!=NULL);
+	sch->invariant = 1;
+	for ( calendar=0 ; ok && calendar<14 ; calendar++ )
+	{
+		unsigned int n_runs = 0;
+		uint32 t;
+		int n;
+
+		/* find the runs of minutes that use the same value index */
+		for ( t=0 ; t<n_minutes ; t++ )
+		{
+			if ( t==0 || index[calendar][t]!=index[calendar][t-1] )
+			{
+				minute[n_runs] = t;
+				value[n_runs] = index[calendar][t];
+				n_runs++;
+			}
+		}
+
+		/* find the end of the run of equal values each run belongs to (scanning backwards through time) */
+		for ( n=n_runs-1 ; n>=0 ; n-- )
+		{
+			if ( n==n_runs-1 )
+				end[n] = n_minutes-1; /* loopback is assumed to result in a value change */
+			else if ( sch->data[value[n]]==sch->data[value[n+1]] )
+				end[n] = end[n+1];
+			else
+			{
+				end[n] = minute[n+1]-1;
+				sch->invariant = 0;
+			}
+		}
+
+		sch->calendar[calendar] = schedule_calendar_share(n_runs,minute,end,value);
+		if ( sch->calendar[calendar]==NULL )
+			ok = 0;
+	}
+	if ( !ok )
+	{
+		output_error("schedule_compile(SCHEDULE *sch={name='%s', ...}) memory allocation failed", sch->name);
+		/* TROUBLESHOOT
+			The schedule could not allocate enough memory to store its compiled calendars.  Try freeing system memory and try again.
+		 */
+		schedule_calendar_release(sch);
+	}
+	free(minute);
+	free(end);
+	free(value);
+	return ok;
+}
+
+/* find the run that includes the given minute of a calendar */
+static unsigned int schedule_calendar_find(SCHEDULECALENDAR *cal, uint32 minute)
+{
+	unsigned int lo=0, hi=cal->n_runs;
+	while ( hi-lo>1 )
+	{
+		unsigned int mid = (lo+hi)/2;
+		if ( cal->minute[mid]<=minute )
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* get the value index of a minute of a calendar, and optionally the end of the run of equal values it belongs to */
+static unsigned char schedule_lookup(SCHEDULE *sch, unsigned int calendar, uint32 minute, uint32 *end)
+{
+	SCHEDULECALENDAR *cal = sch->calendar[calendar];
+	unsigned int n;
+	if ( cal==NULL ) /* not compiled (yet) */
+	{
+		if ( end!=NULL ) *end = 366*24*60-1;
+		return 0;
+	}
+	n = schedule_calendar_find(cal,minute);
+	if ( end!=NULL ) *end = cal->end[n];
+	return cal->index[n];
+}
+
 static pthread_cond_t sc_active = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t sc_activelock = PTHREAD_MUTEX_INITIALIZER;
 static STATUS sc_status = SUCCESS;
@@ -525,6 +703,7 @@ void *schedule_createproc(void *args)
 	STATUS status = SUCCESS;
 	void *rv = 0;
 	SCHEDULE *sch = (SCHEDULE *)args;
+	unsigned char (*index)[366*24*60] = NULL;
 
 	pthread_mutex_lock(&sc_activelock);
 	while ( sc_running>=global_threadcount )
@@ -537,83 +716,24 @@ void *schedule_createproc(void *args)
 	pthread_cond_broadcast(&sc_active);
 	pthread_mutex_unlock(&sc_activelock);
 
-	/* compile the schedule */
-	if (schedule_compile(sch))
+	/* the minute index is only needed while compiling */
+	index = calloc(14,sizeof(index[0]));
+	if (index==NULL)
 	{
-		/* construct the dtnext array */
-		unsigned char calendar;
-		int invariant = 1;
-		for (calendar=0; calendar<14; calendar++)
-		{
-			/* number of minutes that are indexed */
-			int t = sizeof(sch->dtnext[calendar])/sizeof(sch->dtnext[calendar][0])-1;
-
-			/* assume that loopback results in a value change in 1 minute */
-			sch->dtnext[calendar][t] = 1; 
-
-			/* scan backwards through time */
-			for (t--; t>=0; t--)
-			{
-				/* get this and the next index to values */
-				int index0 = sch->index[calendar][t];
-				int index1 = sch->index[calendar][t+1];
-
-				/* if the values are the same */
-				if (sch->data[index0]==sch->data[index1])
-				{	
-					/* if we haven't reached the maximum delta-t (for unsigned char dtnext) */
-					if (sch->dtnext[calendar][t+1]<255)
-
-						/* add 1 minute to next values time */
-						sch->dtnext[calendar][t] = sch->dtnext[calendar][t+1] + 1;
-					else
-
-						/* start the time over at 1 minute (to next value) */
-						sch->dtnext[calendar][t] = 1;
-				}
-				else
-				{
-					/* start the time over at 1 minute (to next value) */
-					sch->dtnext[calendar][t] = 1;
-					invariant = 0;
-				}
-			}
-		}
-
-		/* special case for invariant schedule */
-		if (invariant)
-			memset(sch->dtnext,0,sizeof(sch->dtnext)); /* zero means never */
+		output_error("schedule_compile(SCHEDULE *sch={name='%s', ...}) memory allocation failed", sch->name);
+		/* TROUBLESHOOT
+			The schedule could not allocate enough memory to compile its definition.  Try freeing system memory and try again.
+		 */
+		status = FAILED;
+		goto Done;
+	}
 
-		/* check for gaps in the schedule */
-		else
-		{
-			int ngaps = 0;
-			int ingap = 0;
-			for (calendar=0; calendar<14; calendar++)
-			{
-				int t;
-				for ( t=0; t<sizeof(sch->dtnext[calendar])/sizeof(sch->dtnext[calendar][0])-1; t++ )
-				{
-					if ( sch->dtnext[calendar][t] == 0 && !ingap)
-					{
-						int day = t/60/24;
-						int hour = t/60 - day*24;
-						int minute = t - hour*60 - day*24*60;
-						IN_MYCONTEXT output_debug("schedule '%s' gap in calendar %d at day %d, hour %d, minute %d lasting %d minutes", sch->name, day, hour, minute);
-						ingap = 1;
-						ngaps++;
-					}
-					else if ( sch->dtnext[calendar][t] != 0 && ingap )
-						ingap = 0;
-				}
-			}
-			if (ngaps>0)
-				output_error("schedule '%s' has %d gaps which may cause erroneous results", sch->name, ngaps);
-				/* TROUBLESHOOT
-					The definition given the schedule has missing data that will cause time synchronization problems.
-					Make sure that all the time covered by the schedule has values given.
-				 */
-		}
+	/* compile the schedule */
+	if (schedule_compile(sch,index) && schedule_calendar_build(sch,index))
+	{
+		free(index);
+		index = NULL;
+		IN_MYCONTEXT output_debug("schedule '%s' compiled (%d shared calendars use %.1f kB of memory)", sch->name, calendar_count, calendar_size/1000.0);
 
 		/* normalize */
 		if (sch->flags!=0)
@@ -636,6 +756,8 @@ void *schedule_createproc(void *args)
 	else
 		status = FAILED;
 Done:
+	if ( index!=NULL )
+		free(index);
 	pthread_mutex_lock(&sc_activelock);
 	sc_running--;
 	sc_done++;
@@ -715,7 +837,6 @@ SCHEDULE *schedule_create(char *name,		/**< the name of the schedule */
 		 */
 		return NULL;
 	}
-	IN_MYCONTEXT output_debug("schedule '%s' uses %.1f MB of memory", name, sizeof(SCHEDULE)/1000000.0);
 	if (strlen(name)>=sizeof(sch->name))
 	{
 		output_error("schedule_create(char *name='%s', char *definition='%s') name too long)", name, definition);
@@ -726,7 +847,7 @@ SCHEDULE *schedule_create(char *name,		/**< the name of the schedule */
 		return NULL;
 	}
 	strcpy(sch->name,name);
-	if (strlen(definition)>=sizeof(sch->definition))
+	if (strlen(definition)>=MAXDEFINITION)
 	{
 		output_error("schedule_create(char *name='%s', char *definition='%s') definition too long)", name, definition);
 		/* TROUBLESHOOT
@@ -735,7 +856,16 @@ SCHEDULE *schedule_create(char *name,		/**< the name of the schedule */
 		free(sch);
 		return NULL;
 	}
-	strcpy(sch->definition,definition);
+	sch->definition = strdup(definition);
+	if (sch->definition==NULL)
+	{
+		output_error("schedule_create(char *name='%s', char *definition='%s') memory allocation failed)", name, definition);
+		/* TROUBLESHOOT
+			The schedule module could not allocate enough memory to create a schedule item.  Try freeing system memory and try again.
+		 */
+		free(sch);
+		return NULL;
+	}
 
 	/* attach to schedule list */
 	schedule_add(sch);
@@ -751,6 +881,8 @@ SCHEDULE *schedule_create(char *name,		/**< the name of the schedule */
 		else
 		{
 			/* error message should be given by schedule_compile */
+			schedule_calendar_release(sch);
+			free(sch->definition);
 			free(sch);
 			sch = NULL;
 			return NULL;
@@ -949,7 +1081,7 @@ double schedule_value(SCHEDULE *sch,		/**< the schedule to read */
 	int32 min = GET_MINUTE(index);
 	if ( cal>=14 || min>=60*24*366 )
 		output_error("schedule_index(): index %d has calendar %d minute %d which is invalid", index, cal, min);
-	return sch->data[sch->index[cal][min]];
+	return sch->data[schedule_lookup(sch,cal,min,NULL)];
 }
 
 /** reads the time until the next change in the schedule 
@@ -960,9 +1092,15 @@ int32 schedule_dtnext(SCHEDULE *sch,			/**< the schedule to read */
 {
 	int32 cal = GET_CALENDAR(index);
 	int32 min = GET_MINUTE(index);
+	uint32 end;
 	if ( cal>=14 || min>=60*24*366 )
 		output_error("schedule_dtnext(): index %d has calendar %d minute %d which is invalid", index, cal, min);
-	return sch->dtnext[cal][min];
+	if ( sch->invariant )
+		return 0; /* zero means never */
+
+	/* count down to the end of the run of equal values (at most 255 minutes at a time) */
+	schedule_lookup(sch,cal,min,&end);
+	return (end-min)%255 + 1;
 }
 
 int32 schedule_duration(SCHEDULE *sch,			/**< the schedule to read */
@@ -973,7 +1111,7 @@ int32 schedule_duration(SCHEDULE *sch,			/**< the schedule to read */
 	int block;
 	if ( cal>=14 || min>=60*24*366 )
 		output_error("schedule_duration(): index %d has calendar %d minute %d which is invalid", index, cal, min);
-	block = (sch->index[cal][min]>>6)&MAXBLOCKS; // these change if MAXVALUES or MAXBLOCKS changes
+	block = (schedule_lookup(sch,cal,min,NULL)>>6)&MAXBLOCKS; // these change if MAXVALUES or MAXBLOCKS changes
 	return sch->minutes[block];
 }
 
@@ -984,7 +1122,7 @@ double schedule_weight(SCHEDULE *sch,			/**< the schedule to read */
 	int32 min = GET_MINUTE(index);
 	if ( cal>=14 || min>=60*24*366 )
 		output_error("schedule_weight(): index %d has calendar %d minute %d which is invalid", index, cal, min);
-	return sch->weight[sch->index[cal][min]];
+	return sch->weight[schedule_lookup(sch,cal,min,NULL)];
 }
 
 /** synchronize the schedule to the time given
@@ -1065,71 +1203,15 @@ TIMESTAMP schedule_sync(SCHEDULE *sch, /**< the schedule that is to be synchroni
 	return sch->next_t;
 }
 
-typedef struct s_schedulesyncdata {
-	unsigned int n;
-	pthread_t pt;
-	bool ok;
-	SCHEDULE *sch;
-	unsigned int nsch;
-	TIMESTAMP t0;
-} SCHEDULESYNCDATA;
-
-static pthread_cond_t start_sch = PTHREAD_COND_INITIALIZER;
-static pthread_mutex_t startlock_sch = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t done_sch = PTHREAD_COND_INITIALIZER;
-static pthread_mutex_t donelock_sch = PTHREAD_MUTEX_INITIALIZER;
-static TIMESTAMP next_t1_sch;
+static SCHEDULE **schedule_array = NULL;
+static unsigned int n_schedule_array = 0;
 static TIMESTAMP next_t2_sch = TS_ZERO;
-static unsigned int donecount_sch;
 
 clock_t schedule_synctime = 0;
 
-void *schedule_syncproc(void *ptr)
+static TIMESTAMP schedule_syncproc(unsigned int thread, void *item, void *arg)
 {
-	SCHEDULESYNCDATA *data = (SCHEDULESYNCDATA*)ptr;
-	SCHEDULE *sch;
-	unsigned int n;
-	TIMESTAMP t2;
-
-	// begin processing loop
-	while ( data->ok )
-	{
-		// lock access to start condition
-		pthread_mutex_lock(&startlock_sch);
-
-		// wait for thread start condition
-		while (data->t0==next_t1_sch) 
-			pthread_cond_wait(&start_sch,&startlock_sch);
-		
-		// unlock access to start count
-		pthread_mutex_unlock(&startlock_sch);
-
-		// process the list for this thread
-		t2 = TS_NEVER;
-		for ( sch=data->sch, n=0 ; sch!=NULL, n<data->nsch ; sch=sch->next, n++ )
-		{
-			TIMESTAMP t = schedule_sync(sch,next_t1_sch);
-			if (t<t2) t2 = t;
-		}
-
-		// signal completed condition
-		data->t0 = next_t1_sch;
-
-		// lock access to done condition
-		pthread_mutex_lock(&donelock_sch);
-
-		// signal thread is done for now
-		donecount_sch--;
-		if ( t2<next_t2_sch ) next_t2_sch = t2;
-
-		// signal change in done condition
-		pthread_cond_broadcast(&done_sch);
-
-		// unlock access to done count
-		pthread_mutex_unlock(&donelock_sch);
-	}
-	pthread_exit((void*)0);
-	return (void*)0;
+	return schedule_sync((SCHEDULE*)item,*(TIMESTAMP*)arg);
 }
 
 /** synchronized all the schedules to the time given
@@ -1137,72 +1219,25 @@ void *schedule_syncproc(void *ptr)
  **/
 TIMESTAMP schedule_syncall(TIMESTAMP t1) /**< the time to which the schedule is synchronized */
 {
-	static unsigned int n_threads_sch=0;
-	static SCHEDULESYNCDATA *thread_sch = NULL;
-	TIMESTAMP t2 = TS_NEVER;
+	TIMESTAMP t2;
 	clock_t ts = (clock_t)exec_clock();
 
 	// skip schedule_syncall if there's no schedule in the glm
 	if (n_schedules == 0)
 		return TS_NEVER;
 
-
-	// number of threads desired
-	if (n_threads_sch==0) 
+	// build the schedule array used by the executor
+	if (n_schedule_array!=n_schedules)
 	{
 		SCHEDULE *sch;
-		int n_items, schn=0;
-
-		IN_MYCONTEXT output_debug("loadshape_syncall setting up for %d shapes", n_schedules);
-
-		// determine needed threads
-		n_threads_sch = global_threadcount;
-		if (n_threads_sch>1)
-		{
-			unsigned int n;
-			if (n_schedules<n_threads_sch*4)
-				n_threads_sch = n_schedules/4;
-
-			// only need 1 thread if n_schedules is less than 4
-			if (n_threads_sch == 0)
-				n_threads_sch = 1;
-
-			// determine shapes per thread
-			n_items = n_schedules/n_threads_sch;
-			n_threads_sch = n_schedules/n_items;
-			if (n_threads_sch*n_items<n_schedules) // not enough slots yet
-				n_threads_sch++; // add one underused threads
-
-			IN_MYCONTEXT output_debug("schedule_syncall is using %d of %d available threads", n_threads_sch, global_threadcount);
-			IN_MYCONTEXT output_debug("schedule_syncall is assigning %d shapes per thread", n_items);
-
-			// allocate thread list
-			thread_sch = (SCHEDULESYNCDATA*)malloc(sizeof(SCHEDULESYNCDATA)*n_threads_sch);
-			memset(thread_sch,0,sizeof(SCHEDULESYNCDATA)*n_threads_sch);
-
-			// assign starting shape for each thread
-			for (sch=schedule_list; sch!=NULL; sch=sch->next)
-			{
-				if (thread_sch[schn].nsch==n_items)
-					schn++;
-				if (thread_sch[schn].nsch==0)
-					thread_sch[schn].sch = sch;
-				thread_sch[schn].nsch++;
-			}
-
-			// create threads
-			for (n=0; n<n_threads_sch; n++)
-			{
-				thread_sch[n].ok = true;
-				if ( pthread_create(&(thread_sch[n].pt),NULL,schedule_syncproc,&(thread_sch[n]))!=0 )
-				{
-					output_fatal("loadshape_sync thread creation failed");
-					thread_sch[n].ok = false;
-				}
-				else
-					thread_sch[n].n = n;
-			}
-		}
+		unsigned int n = 0;
+		IN_MYCONTEXT output_debug("schedule_syncall setting up for %d schedules", n_schedules);
+		schedule_array = (SCHEDULE**)realloc(schedule_array,sizeof(SCHEDULE*)*n_schedules);
+		if (schedule_array==NULL)
+			throw_exception("schedule_syncall memory allocation failure");
+		for (sch=schedule_list; sch!=NULL && n<n_schedules; sch=sch->next)
+			schedule_array[n++] = sch;
+		n_schedule_array = n;
 	}
 
 	// don't update if no schedules ever expect to change again
@@ -1213,50 +1248,8 @@ TIMESTAMP schedule_syncall(TIMESTAMP t1) /**< the time to which the schedule is
 	if (next_t2_sch > t1 && !interpolated_schedules)
 		return next_t2_sch;
 
-	// no threading required
-	if (n_threads_sch<2) 
-	{
-		// process list directly
-		SCHEDULE *sch;
-		for (sch=schedule_list; sch!=NULL; sch=sch->next)
-		{
-			TIMESTAMP t3 = schedule_sync(sch,t1);
-			if (t3<t2) t2 = t3;
-		}
-		next_t2_sch = t2;
-	}
-	else
-	{
-		// lock access to done count
-		pthread_mutex_lock(&donelock_sch);
-
-		// initialize wait count
-		donecount_sch = n_threads_sch;
-
-		// lock access to start condition
-		pthread_mutex_lock(&startlock_sch);
-
-		// update start condition
-		next_t1_sch = t1;
-		next_t2_sch = TS_NEVER;
-
-		// signal all the threads
-		pthread_cond_broadcast(&start_sch);
-
-		// unlock access to start count
-		pthread_mutex_unlock(&startlock_sch);
-
-		// begin wait
-		while (donecount_sch>0) 
-			pthread_cond_wait(&done_sch,&donelock_sch);
-		IN_MYCONTEXT output_debug("passed donecount==0 condition");
-
-		// unlock done count
-		pthread_mutex_unlock(&donelock_sch);
-
-		// process results from all threads
-		if (next_t2_sch<t2) t2=next_t2_sch;
-	}
+	t2 = executor_run_min(exec_get_executor(),(void**)schedule_array,n_schedule_array,0,schedule_syncproc,&t1);
+	next_t2_sch = t2;
 
 	schedule_synctime += (clock_t)exec_clock() - ts;
 	return t2;
@@ -37,6 +37,7 @@
 
 #define MAXBLOCKS 4
 #define MAXVALUES 64
+#define MAXDEFINITION 65536
 #define GET_BLOCK(I) ((I)>>6)&0x02)
 #define GET_VALUE(I) ((I)&0x3f)
 
@@ -50,6 +51,23 @@ typedef uint32 SCHEDULEINDEX;
 #define SCHEDULE_MAGIC 0x47ab617e
 #endif
 
+/** The SCHEDULECALENDAR structure is the compiled form of one of the 14 annual calendars
+	of a schedule.  The minutes of the year are stored as runs of consecutive minutes that
+	use the same value index, so the size of a calendar depends on the number of changes
+	in the schedule rather than the number of minutes in a year.  Calendars are shared
+	by all schedules (and calendars within a schedule) that compile to the same runs.
+ **/
+typedef struct s_schedulecalendar SCHEDULECALENDAR;
+struct s_schedulecalendar {
+	unsigned int n_runs;				/**< the number of runs */
+	uint32 *minute;						/**< the first minute of each run */
+	uint32 *end;						/**< the last minute of the run of equal values that includes each run (see schedule_dtnext) */
+	unsigned char *index;				/**< the value index of each run */
+	unsigned int hash;					/**< the hash of the runs */
+	unsigned int refcount;				/**< the number of schedule calendars using this calendar */
+	SCHEDULECALENDAR *next;				/**< the next calendar in the same hash bucket */
+};
+
 /** The SCHEDULE structure defines POSIX style schedules */
 typedef struct s_schedule SCHEDULE;
 struct s_schedule {
@@ -59,11 +77,11 @@ struct s_schedule {
 	unsigned int magic1;	/* values between magic1 and magic2 should never change once compiled */
 #endif
 	char name[64];						/**< the name of the schedule */
-	char definition[65536];				/**< the definition string of the schedule */
+	char *definition;					/**< the definition string of the schedule */
 	char blockname[MAXBLOCKS][64];		/**< the name of each block */
 	unsigned char block;				/**< the last block used (4 max) */
-	unsigned char index[14][366*24*60];	/**< the schedule index (enough room for all 14 annual calendars to 1 minute resolution) */
-	unsigned char dtnext[14][366*24*60];/**< the time until the next schedule change (in minutes) */
+	SCHEDULECALENDAR *calendar[14];		/**< the compiled annual calendars (shared with other schedules) */
+	unsigned char invariant;			/**< flag indicating the schedule value never changes */
 	double data[MAXBLOCKS*MAXVALUES];	/**< the list of values used in each block */
 	unsigned int weight[MAXBLOCKS*MAXVALUES];	/**< the weight (in minutes) associate with each value */
 	double sum[MAXBLOCKS];				/**< the sum of values for each block -- used to normalize */
@@ -5,6 +5,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #ifdef WIN32
 
 #include <winsock2.h>
@@ -17,6 +21,10 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <sys/errno.h>
+#include <sys/time.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 #define SOCKET int
 #define INVALID_SOCKET (-1)
 
@@ -24,6 +32,7 @@
 
 #include <memory.h>
 #include <string.h>
+#include <ctype.h>
 #include <errno.h>
 #include <pthread.h>
 
@@ -34,6 +43,7 @@
 #include "exec.h"
 #include "timestamp.h"
 #include "load.h"
+#include "threadpool.h"
 
 #include "legal.h"
 
@@ -81,6 +91,12 @@ int GetLastError()
 void server_request(int);	// Function to handle clients' request(s)
 void *http_response(void *ptr);
 
+#ifdef HAVE_SYS_EPOLL_H
+static int epoll_fd = -1; /**< epoll instance watching the open connections */
+static void *server_worker(void *arg);
+static void server_add_connection(SOCKET s);
+#endif
+
 /** Send the data to the client
 	@returns the number of bytes sent if successful, -1 if failed (errno is set).
  **/
@@ -113,7 +129,9 @@ int client_allowed(char *saddr)
     @returns a pointer to the status flag
  **/
 static unsigned int n_threads = 0;
+#ifndef HAVE_SYS_EPOLL_H
 static pthread_t thread_id;
+#endif
 static void *server_routine(void *arg)
 {
 	static int status = 0;
@@ -125,9 +143,43 @@ static void *server_routine(void *arg)
 	}
 	started = 1;
 	sockfd = (SOCKET)arg;
+#ifdef HAVE_SYS_EPOLL_H
+	/* start the worker pool */
+	if ( epoll_fd<0 )
+	{
+		unsigned int n, n_workers = global_server_threads>0 ? global_server_threads : processor_count();
+		epoll_fd = epoll_create(64);
+		if ( epoll_fd<0 )
+		{
+			status = GetLastError();
+			output_error("unable to create server event handler: %s", strerror(status));
+			/* TROUBLESHOOT
+				The server could not create the epoll instance it uses to watch its
+				connections.  This is usually caused by a system limit on the number of
+				open files.  Increase the limit and try again.
+			 */
+			goto Done;
+		}
+		for ( n=0 ; n<n_workers ; n++ )
+		{
+			pthread_t worker;
+			if ( pthread_create(&worker,NULL,server_worker,NULL)!=0 )
+			{
+				status = GetLastError();
+				output_error("unable to start server worker thread %d: %s", n, strerror(status));
+				/* TROUBLESHOOT
+					The server could not start one of its worker threads.  This is usually
+					caused by a system limit on the number of threads.  Reduce server_threads
+					and try again.
+				 */
+				goto Done;
+			}
+			pthread_detach(worker);
+		}
+		IN_MYCONTEXT output_verbose("server started %d worker threads", n_workers);
+	}
+#endif
 	// repeat forever..
-	static int active = 0;
-	void *result = NULL;
 	while (!shutdown_server)
 	{
 		struct sockaddr_in cli_addr;
@@ -153,15 +205,20 @@ static void *server_routine(void *arg)
 				continue;
 			}
 			IN_MYCONTEXT output_verbose("accepting connection from %s on port %d",saddr, cli_addr.sin_port);
-			if ( active )
-				pthread_join(thread_id,&result);
+#ifdef HAVE_SYS_EPOLL_H
+			/* connections are served by the worker pool */
+			server_add_connection(newsockfd);
+#else
+			/* each connection is served by its own thread */
 			if ( pthread_create(&thread_id,NULL, http_response,(void*)newsockfd)!=0 )
 				output_error("unable to start http response thread");
+			else
+				pthread_detach(thread_id);
+#endif
 			if (global_server_quit_on_close)
 				shutdown_now();
 			else
 				gui_wait_status(0);
-			active = 1;
 		}
 	}
 	IN_MYCONTEXT output_verbose("server shutdown");
@@ -293,21 +350,176 @@ typedef struct s_httpcnx {
 	char *type;
 	SOCKET s;
 	bool cooked;
+	bool close; /**< connection is closed after the response is sent */
+	char *input; /**< data received from the client */
+	size_t input_len; /**< number of bytes received */
+	size_t input_max; /**< size of the input buffer */
+	size_t input_used; /**< number of bytes used by the current request */
+	char *body; /**< content of the current request (NUL terminated) */
+	size_t body_len; /**< length of the content */
 } HTTPCNX;
 
+#define HTTP_MAXREQUEST (16*1024*1024) /**< largest request accepted (header and content) */
+
 /** Create an HTTPCNX connection handle
     @returns HTTPCNX connection handle pointer on success, NULL on failure
  **/
 static HTTPCNX *http_create(SOCKET s)
 {
 	HTTPCNX *http = (HTTPCNX*)malloc(sizeof(HTTPCNX));
+	if ( http==NULL )
+		return NULL;
 	memset(http,0,sizeof(HTTPCNX));
 	http->s = s;
 	http->max = 65536;
 	http->buffer = malloc(http->max);
+	http->input_max = sizeof(http->query);
+	http->input = malloc(http->input_max);
+	if ( http->buffer==NULL || http->input==NULL )
+	{
+		free(http->buffer);
+		free(http->input);
+		free(http);
+		return NULL;
+	}
 	return http;
 }
 
+/** Destroy an HTTPCNX connection handle (the socket must already be closed)
+ **/
+static void http_destroy(HTTPCNX *http)
+{
+	free(http->buffer);
+	free(http->input);
+	free(http->body);
+	free(http);
+}
+
+/* find the end of the request header in the input buffer */
+static char *http_header_end(HTTPCNX *http)
+{
+	size_t n;
+	for ( n=0 ; n+1<http->input_len ; n++ )
+	{
+		if ( http->input[n]=='\n' && http->input[n+1]=='\n' )
+			return http->input+n+2;
+		if ( n+3<http->input_len && strncmp(http->input+n,"\r\n\r\n",4)==0 )
+			return http->input+n+4;
+	}
+	return NULL;
+}
+
+/* receive more data from the client, returns 0 if the connection was closed */
+static int http_fill(HTTPCNX *http)
+{
+	size_t len;
+	if ( http->input_len==http->input_max )
+	{
+		char *more;
+		if ( http->input_max*2>HTTP_MAXREQUEST )
+		{
+			output_error("request on socket %d is too large", http->s);
+			return 0;
+		}
+		more = (char*)realloc(http->input,http->input_max*2);
+		if ( more==NULL )
+			return 0;
+		http->input = more;
+		http->input_max *= 2;
+	}
+	len = recv_data(http->s,http->input+http->input_len,http->input_max-http->input_len);
+	if ( (int)len<=0 )
+		return 0;
+	http->input_len += len;
+	return 1;
+}
+
+/** Read the next request from the client
+
+	The request header is copied into the query buffer and the content,
+	if any, into the body.  Data received after the request is kept for
+	the next one.
+	@returns 1 when a request has been read, 0 if the connection was closed
+ **/
+static int http_read(HTTPCNX *http)
+{
+	char *end, *p;
+	size_t header_len, content_length = 0;
+
+	/* drop the previous request */
+	if ( http->input_used>0 )
+	{
+		memmove(http->input,http->input+http->input_used,http->input_len-http->input_used);
+		http->input_len -= http->input_used;
+		http->input_used = 0;
+	}
+	free(http->body);
+	http->body = NULL;
+	http->body_len = 0;
+
+	/* read the header */
+	while ( (end=http_header_end(http))==NULL )
+	{
+		if ( !http_fill(http) )
+			return 0;
+	}
+	header_len = end-http->input;
+	if ( header_len>=sizeof(http->query) )
+	{
+		output_error("request header on socket %d is too long", http->s);
+		return 0;
+	}
+	memcpy(http->query,http->input,header_len);
+	http->query[header_len] = '\0';
+
+	/* find the content length */
+	for ( p=strchr(http->query,'\n') ; p!=NULL ; p=strchr(p,'\n') )
+	{
+		p++;
+		if ( strnicmp(p,"Content-Length:",15)==0 )
+			content_length = (size_t)atol(p+15);
+	}
+	if ( header_len+content_length>HTTP_MAXREQUEST )
+	{
+		output_error("request content on socket %d is too large", http->s);
+		return 0;
+	}
+
+	/* read the content */
+	while ( http->input_len<header_len+content_length )
+	{
+		while ( http->input_max<header_len+content_length )
+		{
+			char *more = (char*)realloc(http->input,http->input_max*2);
+			if ( more==NULL )
+				return 0;
+			http->input = more;
+			http->input_max *= 2;
+		}
+		if ( !http_fill(http) )
+			return 0;
+	}
+	http->body = (char*)malloc(content_length+1);
+	if ( http->body==NULL )
+		return 0;
+	memcpy(http->body,http->input+header_len,content_length);
+	http->body[content_length] = '\0';
+	http->body_len = content_length;
+	http->input_used = header_len+content_length;
+	return 1;
+}
+
+/* check whether another complete request header has already been received */
+static int http_pending(HTTPCNX *http)
+{
+	if ( http->input_len<=http->input_used )
+		return 0;
+	memmove(http->input,http->input+http->input_used,http->input_len-http->input_used);
+	http->input_len -= http->input_used;
+	http->input_used = 0;
+	return http_header_end(http)!=NULL;
+}
+
 /** Reset an HTTPCNX connection handle
 
 	This function clears the contents of HTTPCNX connection block so that it can be reused to handle a new message.
@@ -317,6 +529,7 @@ static void http_reset(HTTPCNX *http)
 {
 	http->status = NULL;
 	http->type = NULL;
+	http->close = false;
 }
 
 #define HTTP_CONTINUE "100 Continue"
@@ -386,6 +599,8 @@ static void http_send(HTTPCNX *http)
 	len += sprintf(header+len, "Cache-Control: no-cache\n");
 	len += sprintf(header+len, "Cache-Control: no-store\n");
 	len += sprintf(header+len, "Expires: -1\n");
+	if ( http->close )
+		len += sprintf(header+len, "Connection: close\n");
 	len += sprintf(header+len,"\n");
 	send_data(http->s,header,len);
 	if (http->len>0)
@@ -479,6 +694,10 @@ static void http_close(HTTPCNX *http)
 {
 	if (http->len>0)
 		http_send(http);
+#ifdef HAVE_SYS_EPOLL_H
+	if ( epoll_fd>=0 )
+		epoll_ctl(epoll_fd,EPOLL_CTL_DEL,http->s,NULL);
+#endif
 #ifdef WIN32
 	closesocket(http->s);
 #else
@@ -1082,6 +1301,242 @@ int http_json_request(HTTPCNX *http,char *uri)
 	return 0;
 }
 
+/* state of the simple JSON parser used by bulk requests */
+typedef struct s_jsonparse {
+	char *next; /**< next character to parse */
+	char held; /**< delimiter overwritten by the end of a bare value */
+} JSONPARSE;
+
+/* skip white space and check for an expected JSON delimiter */
+static int json_expect(JSONPARSE *json, char c)
+{
+	if ( json->held!='\0' && !isspace(json->held) )
+	{
+		if ( json->held!=c )
+			return 0;
+		json->held = '\0';
+		return 1;
+	}
+	json->held = '\0';
+	while ( isspace(*json->next) ) json->next++;
+	if ( *json->next!=c )
+		return 0;
+	json->next++;
+	return 1;
+}
+
+/* parse a JSON string (or a bare value) in place, returns NULL if none is found */
+static char *json_parse_value(JSONPARSE *json)
+{
+	char *p, *start, *out;
+	if ( json->held!='\0' && !isspace(json->held) )
+		return NULL;
+	json->held = '\0';
+	p = json->next;
+	while ( isspace(*p) ) p++;
+	if ( *p=='"' )
+	{
+		start = out = ++p;
+		while ( *p!='"' )
+		{
+			if ( *p=='\0' )
+				return NULL;
+			if ( *p=='\\' )
+			{
+				switch ( *++p ) {
+				case 'n': *out++ = '\n'; break;
+				case 't': *out++ = '\t'; break;
+				case 'r': *out++ = '\r'; break;
+				case 'b': *out++ = '\b'; break;
+				case 'f': *out++ = '\f'; break;
+				case '\0': return NULL;
+				default: *out++ = *p; break;
+				}
+				p++;
+			}
+			else
+				*out++ = *p++;
+		}
+		json->next = p+1;
+		*out = '\0';
+		return start;
+	}
+	start = p;
+	while ( *p!='\0' && *p!=',' && *p!=':' && *p!='}' && *p!=']' && !isspace(*p) ) p++;
+	if ( p==start )
+		return NULL;
+	json->held = *p;
+	if ( *p!='\0' )
+	{
+		*p = '\0';
+		json->next = p+1;
+	}
+	else
+		json->next = p;
+	return start;
+}
+
+/* write a JSON string value */
+static void http_json_string(HTTPCNX *http, char *value)
+{
+	char buffer[2048], *out = buffer;
+	while ( *value!='\0' && out<buffer+sizeof(buffer)-3 )
+	{
+		if ( *value=='"' || *value=='\\' ) *out++ = '\\';
+		*out++ = *value++;
+	}
+	*out = '\0';
+	http_format(http,"\"%s\"",buffer);
+}
+
+/* find the object and property named by an "object.property" reference */
+static OBJECT *http_find_property(char *ref, char *property, size_t len)
+{
+	char name[1024], *dot;
+	strncpy(name,ref,sizeof(name)-1);
+	name[sizeof(name)-1] = '\0';
+	for ( dot=strchr(name,'.') ; dot!=NULL ; dot=strchr(dot+1,'.') )
+	{
+		char pname[1024], *unit;
+		OBJECT *obj;
+		char *id;
+		*dot = '\0';
+		id = strchr(name,':');
+		obj = ( id==NULL ) ? object_find_name(name) : object_find_by_id(atoi(id+1));
+		*dot = '.';
+		if ( obj==NULL )
+			continue;
+		strncpy(pname,dot+1,sizeof(pname)-1);
+		pname[sizeof(pname)-1] = '\0';
+		unit = strchr(pname,'[');
+		if ( unit!=NULL ) *unit = '\0';
+		if ( object_get_property(obj,pname,NULL)==NULL )
+			continue;
+		strncpy(property,dot+1,len-1);
+		property[len-1] = '\0';
+		return obj;
+	}
+	return NULL;
+}
+
+/* get (and optionally set) one property of a bulk request */
+static void http_bulk_item(HTTPCNX *http, char *ref, char *value, int first)
+{
+	char property[1024], buffer[1024] = "";
+	OBJECT *obj = http_find_property(ref,property,sizeof(property));
+	http_format(http,"%s\n\t",first?"":",");
+	http_json_string(http,ref);
+	if ( obj==NULL )
+		http_format(http,": {\"error\": \"property not found\"}");
+	else if ( value!=NULL && !object_set_value_by_name(obj,property,value) )
+		http_format(http,": {\"error\": \"property write failed\"}");
+	else if ( !get_value_with_unit(obj,ref,property,buffer,sizeof(buffer)) )
+		http_format(http,": {\"error\": \"unable to get property value\"}");
+	else
+	{
+		http_format(http,": ");
+		http_json_string(http,http_unquote(buffer));
+	}
+}
+
+/** Process an incoming bulk JSON request
+
+	Bulk requests read or write many object properties at once.  All the
+	properties are read or written while the main loop is between timesteps,
+	so the response is a consistent snapshot of the model.  Properties are
+	named "object.property", and may include a unit as in JSON requests.
+
+	- GET /bulk/get/<ref>,<ref>,... reads a comma-separated list of properties
+	- POST /bulk/get with the content ["<ref>", ...] reads a list of properties
+	- POST /bulk/set with the content {"<ref>": "<value>", ...} writes the
+	  properties and reads them back
+
+	The response is a JSON object giving the value of each property, or an
+	error object for the properties that could not be read or written.
+	@returns non-zero on success, 0 if the request is not valid
+ **/
+int http_bulk_request(HTTPCNX *http, char *uri)
+{
+	JSONPARSE json = {http->body,'\0'};
+	char **ref = NULL, **value = NULL;
+	size_t n, count = 0, max = 0;
+	int ok = 1;
+
+	/* parse the request before the snapshot is taken */
+	if ( strncmp(uri,"get/",4)==0 )
+	{
+		/* comma-separated list (commas inside a unit spec do not separate properties) */
+		char *p = uri+4;
+		int depth = 0;
+		http_decode(p);
+		while ( ok && *p!='\0' )
+		{
+			if ( count==max )
+			{
+				max = max ? max*2 : 64;
+				ref = (char**)realloc(ref,max*sizeof(char*));
+				if ( ref==NULL ) return 0;
+			}
+			ref[count++] = p;
+			for ( ; *p!='\0' && (*p!=',' || depth>0) ; p++ )
+			{
+				if ( *p=='[' ) depth++;
+				else if ( *p==']' ) depth--;
+			}
+			if ( *p==',' ) *p++ = '\0';
+		}
+	}
+	else if ( (strcmp(uri,"get")==0 || strcmp(uri,"set")==0) && http->body!=NULL )
+	{
+		int set = strcmp(uri,"set")==0;
+		ok = json_expect(&json,set?'{':'[');
+		if ( ok && !json_expect(&json,set?'}':']') )
+		{
+			do {
+				if ( count==max )
+				{
+					max = max ? max*2 : 64;
+					ref = (char**)realloc(ref,max*sizeof(char*));
+					value = (char**)realloc(value,max*sizeof(char*));
+					if ( ref==NULL || value==NULL ) { ok = 0; break; }
+				}
+				ref[count] = json_parse_value(&json);
+				value[count] = NULL;
+				if ( ref[count]==NULL || ( set && ( !json_expect(&json,':') || (value[count]=json_parse_value(&json))==NULL ) ) )
+				{
+					ok = 0;
+					break;
+				}
+				count++;
+			} while ( json_expect(&json,',') );
+			if ( ok )
+				ok = json_expect(&json,set?'}':']');
+		}
+	}
+	else
+		ok = 0;
+	if ( !ok )
+	{
+		http_format(http,"{\"error\": \"invalid bulk request\", query: \"%s\"}\n", uri);
+		http_type(http,"text/json");
+		free(ref);
+		free(value);
+		return 0;
+	}
+
+	/* read and write the properties while the main loop is between timesteps */
+	exec_snapshot_lock();
+	http_format(http,"{");
+	for ( n=0 ; n<count ; n++ )
+		http_bulk_item(http,ref[n],value?value[n]:NULL,n==0);
+	exec_snapshot_unlock();
+	http_format(http,"\n}\n");
+	http_type(http,"text/json");
+	free(ref);
+	free(value);
+	return 1;
+}
+
 /** Process an incoming GUI request
 	@returns non-zero on success, 0 on failure (errno set)
  **/
@@ -1730,14 +2185,11 @@ int http_favicon(HTTPCNX *http)
 	return http_copy(http,"icon",fullpath,false);
 }
 
-/** Process an incoming request
-	@returns nothing
+/** Process a request read by http_read()
+	@returns 1 if the connection remains open for another request, 0 if it must be closed
  **/
-void *http_response(void *ptr)
+static int http_request(HTTPCNX *http)
 {
-	SOCKET fd = (SOCKET)ptr;
-	HTTPCNX *http = http_create(fd);
-	size_t len;
 	int content_length = 0;
 	char *user_agent = NULL;
 	char *host = NULL;
@@ -1757,117 +2209,211 @@ void *http_response(void *ptr)
 		{"Accept", STRING, (void*)&accept, 0},
 	};
 
-	while ( (int)(len=recv_data(fd,http->query,sizeof(http->query)))>0 )
-	{
-		/* first term is always the request */
-		char *request = http->query;
-		char method[32];
-		char uri[1024];
-		char version[32];
-		char *p = strchr(http->query,'\r');
-		int v;
-		
-		/* initialize the response */
-		http_reset(http);
+	/* first term is always the request */
+	char *request = http->query;
+	char method[32];
+	char uri[1024];
+	char version[32];
+	char *p = strchr(http->query,'\r');
+	int v;
+	
+	/* initialize the response */
+	http_reset(http);
 
-		/* read the request string */
-		if (sscanf(request,"%s %s %s",method,uri,version)!=3)
-		{
-			http_status(http,HTTP_BADREQUEST);
-			output_error("request [%s] is bad", request);
-			http_send(http);
-			break;
-		}
+	/* read the request string */
+	if (sscanf(request,"%31s %1023s %31s",method,uri,version)!=3)
+	{
+		http_status(http,HTTP_BADREQUEST);
+		output_error("request [%s] is bad", request);
+		http->close = true;
+		http_send(http);
+		return 0;
+	}
 
-		/* read the rest of the header */
-		while (p!=NULL && (p=strchr(p,'\r'))!=NULL) 
+	/* read the rest of the header */
+	while (p!=NULL && (p=strchr(p,'\r'))!=NULL) 
+	{
+ 		*p = '\0';
+		p+=2;
+		for ( v=0 ; v<sizeof(map)/sizeof(map[0]) ; v++ )
 		{
- 			*p = '\0';
-			p+=2;
-			for ( v=0 ; v<sizeof(map)/sizeof(map[0]) ; v++ )
+			if (map[v].sz==0) map[v].sz = strlen(map[v].name);
+			if (strnicmp(map[v].name,p,map[v].sz)==0 && strncmp(p+map[v].sz,": ",2)==0)
 			{
-				if (map[v].sz==0) map[v].sz = strlen(map[v].name);
-				if (strnicmp(map[v].name,p,map[v].sz)==0 && strncmp(p+map[v].sz,": ",2)==0)
-				{
-					if (map[v].type==INTEGER) { *(int*)(map[v].value) = atoi(p+map[v].sz+2); break; }
-					else if (map[v].type==STRING) { *(char**)map[v].value = p+map[v].sz+2; break; }
-				}
+				if (map[v].type==INTEGER) { *(int*)(map[v].value) = atoi(p+map[v].sz+2); break; }
+				else if (map[v].type==STRING) { *(char**)map[v].value = p+map[v].sz+2; break; }
 			}
 		}
-		IN_MYCONTEXT output_verbose("%s (host='%s', len=%d, keep-alive=%d)",http->query,host?host:"???",content_length, keep_alive);
+	}
+	IN_MYCONTEXT output_verbose("%s (host='%s', len=%d, keep-alive=%d)",http->query,host?host:"???",content_length, keep_alive);
 
-		/* reject anything but a GET */
-		if (stricmp(method,"GET")!=0)
+	/* HTTP/1.1 connections are persistent unless the client asks otherwise */
+	if ( connection!=NULL )
+		http->close = stricmp(connection,"close")==0;
+	else
+		http->close = stricmp(version,"HTTP/1.1")!=0;
+
+	/* reject anything but a GET (or a POST of bulk data) */
+	if ( stricmp(method,"GET")!=0 && !(stricmp(method,"POST")==0 && strncmp(uri,"/bulk/",6)==0) )
+	{
+		http_status(http,HTTP_METHODNOTALLOWED);
+		/* technically, we should add an Allow entry to the response header */
+		output_error("request [%s %s %s]: '%s' is not an allowed method", method, uri, version, method);
+		http->close = true;
+		http_send(http);
+		return 0;
+	}
+
+	/* handle request */
+	if ( strcmp(uri,"/favicon.ico")==0 )
+	{
+		if ( http_favicon(http) )
+			http_status(http,HTTP_OK);
+		else
+			http_status(http,HTTP_NOTFOUND);
+		http_send(http);
+	}
+	else {
+		static struct s_map {
+			char *path;
+			int (*request)(HTTPCNX*,char*);
+			char *success;
+			char *failure;
+		} map[] = {
+			/* this is the map of recognize request types */
+			{"/control/",	http_control_request,	HTTP_ACCEPTED, HTTP_NOTFOUND},
+			{"/open/",		http_open_request,		HTTP_ACCEPTED, HTTP_NOTFOUND},
+			{"/raw/",		http_raw_request,		HTTP_OK, HTTP_NOTFOUND},
+			{"/xml/",		http_xml_request,		HTTP_OK, HTTP_NOTFOUND},
+			{"/gui/",		http_gui_request,		HTTP_OK, HTTP_NOTFOUND},
+			{"/output/",	http_output_request,	HTTP_OK, HTTP_NOTFOUND},
+			{"/action/",	http_action_request,	HTTP_ACCEPTED,HTTP_NOTFOUND},
+			{"/rt/",		http_get_rt,			HTTP_OK, HTTP_NOTFOUND},
+			{"/rb/",		http_get_rb,			HTTP_OK, HTTP_NOTFOUND},
+			{"/perl/",		http_run_perl,			HTTP_OK, HTTP_NOTFOUND},
+			{"/gnuplot/",	http_run_gnuplot,		HTTP_OK, HTTP_NOTFOUND},
+			{"/java/",		http_run_java,			HTTP_OK, HTTP_NOTFOUND},
+			{"/python/",	http_run_python,		HTTP_OK, HTTP_NOTFOUND},
+			{"/r/",			http_run_r,				HTTP_OK, HTTP_NOTFOUND},
+			{"/scilab/",	http_run_scilab,		HTTP_OK, HTTP_NOTFOUND},
+			{"/octave/",	http_run_octave,		HTTP_OK, HTTP_NOTFOUND},
+			{"/kml/", 		http_kml_request,		HTTP_OK, HTTP_NOTFOUND},
+			{"/json/",		http_json_request,		HTTP_OK, HTTP_NOTFOUND},
+			{"/bulk/",		http_bulk_request,		HTTP_OK, HTTP_BADREQUEST},
+		};
+		int n;
+		for ( n=0 ; n<sizeof(map)/sizeof(map[0]) ; n++ )
 		{
-			http_status(http,HTTP_METHODNOTALLOWED);
-			/* technically, we should add an Allow entry to the response header */
-			output_error("request [%s %s %s]: '%s' is not an allowed method", method, uri, version, method);
-			http_send(http);
-			break;
+			size_t len = strlen(map[n].path);
+			if (strncmp(uri,map[n].path,len)==0)
+			{
+				if ( map[n].request(http,uri+len) )
+					http_status(http,map[n].success);
+				else
+					http_status(http,map[n].failure);
+				http_send(http);
+				break;
+			}
 		}
-
-		/* handle request */
-		if ( strcmp(uri,"/favicon.ico")==0 )
+		if ( n==sizeof(map)/sizeof(map[0]) )
 		{
-			if ( http_favicon(http) )
-				http_status(http,HTTP_OK);
-			else
-				http_status(http,HTTP_NOTFOUND);
+			http_status(http,HTTP_NOTFOUND);
 			http_send(http);
 		}
-		else {
-			static struct s_map {
-				char *path;
-				int (*request)(HTTPCNX*,char*);
-				char *success;
-				char *failure;
-			} map[] = {
-				/* this is the map of recognize request types */
-				{"/control/",	http_control_request,	HTTP_ACCEPTED, HTTP_NOTFOUND},
-				{"/open/",		http_open_request,		HTTP_ACCEPTED, HTTP_NOTFOUND},
-				{"/raw/",		http_raw_request,		HTTP_OK, HTTP_NOTFOUND},
-				{"/xml/",		http_xml_request,		HTTP_OK, HTTP_NOTFOUND},
-				{"/gui/",		http_gui_request,		HTTP_OK, HTTP_NOTFOUND},
-				{"/output/",	http_output_request,	HTTP_OK, HTTP_NOTFOUND},
-				{"/action/",	http_action_request,	HTTP_ACCEPTED,HTTP_NOTFOUND},
-				{"/rt/",		http_get_rt,			HTTP_OK, HTTP_NOTFOUND},
-				{"/rb/",		http_get_rb,			HTTP_OK, HTTP_NOTFOUND},
-				{"/perl/",		http_run_perl,			HTTP_OK, HTTP_NOTFOUND},
-				{"/gnuplot/",	http_run_gnuplot,		HTTP_OK, HTTP_NOTFOUND},
-				{"/java/",		http_run_java,			HTTP_OK, HTTP_NOTFOUND},
-				{"/python/",	http_run_python,		HTTP_OK, HTTP_NOTFOUND},
-				{"/r/",			http_run_r,				HTTP_OK, HTTP_NOTFOUND},
-				{"/scilab/",	http_run_scilab,		HTTP_OK, HTTP_NOTFOUND},
-				{"/octave/",	http_run_octave,		HTTP_OK, HTTP_NOTFOUND},
-				{"/kml/", 		http_kml_request,		HTTP_OK, HTTP_NOTFOUND},
-				{"/json/",		http_json_request,		HTTP_OK, HTTP_NOTFOUND},
-			};
-			int n;
-			for ( n=0 ; n<sizeof(map)/sizeof(map[0]) ; n++ )
-			{
-				size_t len = strlen(map[n].path);
-				if (strncmp(uri,map[n].path,len)==0)
-				{
-					if ( map[n].request(http,uri+len) )
-						http_status(http,map[n].success);
-					else
-						http_status(http,map[n].failure);
-					http_send(http);
+	}
+	return http->close ? 0 : 1;
+}
 
-					/* keep-alive not desired*/
-					if (connection && stricmp(connection,"close")==0)
-						break;
-					else
-						continue;
-				}
-			}
-			break;
-		}
-		break;
+/** Process the requests on a connection until it is closed (used when connections have their own thread)
+	@returns nothing
+ **/
+void *http_response(void *ptr)
+{
+	SOCKET fd = (SOCKET)ptr;
+	HTTPCNX *http = http_create(fd);
+	if ( http==NULL )
+	{
+		output_error("unable to create http connection handle for socket %d", fd);
+#ifdef WIN32
+		closesocket(fd);
+#else
+		close(fd);
+#endif
+		return 0;
 	}
+	while ( http_read(http) && http_request(http) ) {}
 	http_close(http);
 	IN_MYCONTEXT output_verbose("socket %d closed",http->s);
+	http_destroy(http);
 	return 0;
 }
 
+#ifdef HAVE_SYS_EPOLL_H
+/** Add an accepted connection to the set served by the worker pool
+ **/
+static void server_add_connection(SOCKET s)
+{
+	struct epoll_event event;
+	struct timeval timeout = {5,0};
+	HTTPCNX *http = http_create(s);
+	if ( http==NULL )
+	{
+		output_error("unable to create http connection handle for socket %d", s);
+		close(s);
+		return;
+	}
+
+	/* a client that stops in the middle of a request cannot hold a worker forever */
+	setsockopt(s,SOL_SOCKET,SO_RCVTIMEO,&timeout,sizeof(timeout));
+
+	/* each connection is handled by one worker at a time */
+	event.events = EPOLLIN|EPOLLRDHUP|EPOLLONESHOT;
+	event.data.ptr = (void*)http;
+	if ( epoll_ctl(epoll_fd,EPOLL_CTL_ADD,s,&event)<0 )
+	{
+		output_error("unable to add socket %d to server event handler: %s", s, strerror(GetLastError()));
+		close(s);
+		http_destroy(http);
+	}
+}
+
+/** Server worker thread
 
+	Workers wait for a connection to have a request, serve the requests
+	that have arrived, and return the connection to the set that is
+	watched for the next request.
+ **/
+static void *server_worker(void *arg)
+{
+	while ( !shutdown_server )
+	{
+		struct epoll_event event;
+		HTTPCNX *http;
+		int keep = 1;
+		int n = epoll_wait(epoll_fd,&event,1,-1);
+		if ( n<0 && errno==EINTR )
+			continue;
+		else if ( n<0 )
+		{
+			output_error("server worker wait failed: %s", strerror(GetLastError()));
+			break;
+		}
+		else if ( n==0 )
+			continue;
+		http = (HTTPCNX*)event.data.ptr;
+		do {
+			keep = http_read(http) && http_request(http);
+		} while ( keep && http_pending(http) );
+		if ( keep )
+		{
+			event.events = EPOLLIN|EPOLLRDHUP|EPOLLONESHOT;
+			if ( epoll_ctl(epoll_fd,EPOLL_CTL_MOD,http->s,&event)==0 )
+				continue;
+		}
+		http_close(http);
+		IN_MYCONTEXT output_verbose("socket %d closed",http->s);
+		http_destroy(http);
+	}
+	return NULL;
+}
+#endif
@@ -2,6 +2,14 @@
  *
  */
 
+#ifndef WIN32
+#include <sys/mman.h>
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
+#include <stddef.h>
 #include "output.h"
 #include "stream.h"
 #include "module.h"
@@ -370,6 +378,7 @@ size_t stream(void *ptr, ///< pointer to buffer
 		if ( a>len ) throw;
 		size_t c = fread((void*)ptr,1,a,fp);
 		if ( a!=c ) throw;
+		if ( is_str && a<len ) ((char*)ptr)[a] = '\0';
 		if ( match!=NULL && memcmp(ptr,match,a)!=0 ) throw 0;
 		b+=c;
 		stream_pos += b;
@@ -494,6 +503,116 @@ void stream(OBJECT *obj)
 	stream("/OBJ");
 }
 
+/* object checksums used by delta streams
+
+   The checksums are kept in shared memory so that checkpoints written by a
+   child process (see checkpoint_background) update the checksums seen by the
+   next checkpoint.
+ */
+static unsigned int64 *checksum = NULL; ///< checksums of the objects as of the last base or delta stream
+static unsigned int64 *checksum_next = NULL; ///< checksums of the objects in the delta stream in progress
+static size_t checksum_count = 0; ///< number of object ids covered by the checksums
+
+/** Allocate the object checksums used by SF_BASE and SF_DELTA streams
+    This must be called before any checkpoint process is started.
+    @returns 1 on success, 0 on failure
+ **/
+extern "C" int stream_delta_init(void)
+{
+	OBJECT *obj;
+	size_t n = 0, size;
+	if ( checksum!=NULL )
+		return 1;
+	for ( obj=object_get_first() ; obj!=NULL ; obj=object_get_next(obj) )
+	{
+		if ( obj->id>=n ) n = obj->id+1;
+	}
+	size = sizeof(unsigned int64)*2*(n>0?n:1);
+#ifdef WIN32
+	checksum = (unsigned int64*)malloc(size);
+	if ( checksum==NULL )
+		return 0;
+#else
+	void *ptr = mmap(NULL,size,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_ANONYMOUS,-1,0);
+	if ( ptr==MAP_FAILED )
+		return 0;
+	checksum = (unsigned int64*)ptr;
+#endif
+	memset(checksum,0,size);
+	checksum_next = checksum+n;
+	checksum_count = n;
+	return 1;
+}
+
+// checksum of an object's data (FNV-1a taken a word at a time)
+static unsigned int64 object_checksum(OBJECT *obj)
+{
+	const unsigned char *data = (const unsigned char*)(obj+1);
+	size_t n, len = obj->oclass->size;
+	unsigned int64 hash = 14695981039346656037ULL;
+	for ( n=0 ; n+sizeof(unsigned int64)<=len ; n+=sizeof(unsigned int64) )
+	{
+		unsigned int64 word;
+		memcpy(&word,data+n,sizeof(word));
+		hash = (hash^word)*1099511628211ULL;
+	}
+	for ( ; n<len ; n++ )
+		hash = (hash^data[n])*1099511628211ULL;
+	return hash;
+}
+
+// changed object stream (used by delta streams in place of the object stream)
+void stream_changes(OBJECT *obj)
+{
+	stream("DOBJ");
+
+	size_t count = 0;
+	if ( flags&SF_OUT )
+	{
+		for ( ; obj!=NULL ; obj=obj->next )
+		{
+			if ( obj->id<checksum_count )
+			{
+				checksum_next[obj->id] = object_checksum(obj);
+				if ( checksum_next[obj->id]==checksum[obj->id] )
+					continue;
+			}
+			count++;
+		}
+		obj = object_get_first();
+	}
+	stream(count);
+	size_t n;
+	for ( n=0 ; n<count ; n++ )
+	{
+		if ( flags&SF_OUT )
+		{
+			while ( obj->id<checksum_count && checksum_next[obj->id]==checksum[obj->id] )
+				obj = obj->next;
+		}
+
+		OBJECTNUM id; if ( obj ) id = obj->id;
+		stream(id);
+
+		unsigned int size; if ( obj ) size = obj->oclass->size;
+		stream(size);
+
+		if ( flags&SF_OUT )
+		{
+			stream((void*)(obj+1),size);
+			obj = obj->next;
+		}
+		else if ( flags&SF_IN )
+		{
+			OBJECT *target = object_find_by_id(id);
+			if ( target==NULL || target->oclass->size!=size )
+				throw "changed object";
+			stream((void*)(target+1),size);
+		}
+	}
+	stream("/DOBJ");
+}
+
 // globals stream
 void stream(GLOBALVAR *var)
 {
@@ -507,7 +626,9 @@ void stream(GLOBALVAR *var)
 		PROPERTYNAME name; if ( var ) strcpy(name,var->prop->name);
 		stream(name,sizeof(name));
 
-		char value[1024]; if ( var ) global_getvar(name,value,sizeof(value));
+		char value[1024];
+		global_dateformat = DF_ISO;
+		if ( var ) global_getvar(name,value,sizeof(value));
 		stream(value,sizeof(value));
 
 		if ( flags&SF_OUT ) var = var->next;
@@ -525,17 +646,33 @@ size_t stream(FILE *fileptr,int opts)
 	IN_MYCONTEXT output_debug("starting stream on file %d with options %x", fileno(fp), flags);
 	try {
 
-		// header
-		stream("GLD30");
-
-		// runtime classes
-		try { stream(class_get_first_runtime()); } catch (int) {};
+		// header (delta streams only contain the objects that changed)
+		char header[8] = "GLD30";
+		if ( (flags&SF_OUT) && (flags&SF_DELTA) ) strcat(header,"D");
+		stream(header,sizeof(header)-1);
+		if ( strcmp(header,"GLD30D")==0 )
+			flags |= SF_DELTA;
+		else if ( strcmp(header,"GLD30")!=0 )
+			throw "header";
+		if ( (flags&(SF_BASE|SF_DELTA)) && (flags&SF_OUT) && checksum==NULL )
+			throw "delta stream without checksums";
+
+		if ( flags&SF_DELTA )
+		{
+			// changed objects
+			stream_changes(object_get_first());
+		}
+		else
+		{
+			// runtime classes
+			try { stream(class_get_first_runtime()); } catch (int) {};
 
-		// modules
-		try { stream(module_get_first()); } catch (int) {}
+			// modules
+			try { stream(module_get_first()); } catch (int) {}
 
-		// objects
-		try { stream(object_get_first()); } catch (int) {};
+			// objects
+			try { stream(object_get_first()); } catch (int) {};
+		}
 
 		// globals
 		try { stream(global_getnext(NULL)); } catch (int) {};
@@ -546,6 +683,19 @@ size_t stream(FILE *fileptr,int opts)
 		{	
 			s->call((int)flags,(STREAMCALLBACK)stream_callback);
 		}
+
+		// the objects written are the base of the next delta stream
+		if ( (flags&SF_OUT) && (flags&SF_DELTA) )
+			memcpy(checksum,checksum_next,sizeof(unsigned int64)*checksum_count);
+		else if ( (flags&SF_OUT) && (flags&SF_BASE) )
+		{
+			OBJECT *obj;
+			for ( obj=object_get_first() ; obj!=NULL ; obj=obj->next )
+			{
+				if ( obj->id<checksum_count )
+					checksum[obj->id] = object_checksum(obj);
+			}
+		}
 		IN_MYCONTEXT output_debug("done processing stream on file %d with options %x", fileno(fp), flags);
 		return stream_pos;
 	}
@@ -561,6 +711,1037 @@ size_t stream(FILE *fileptr,int opts)
 	}
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// MODEL CACHE
+//
+// The model cache is an image of a model taken just after it is loaded from GLM.  The image
+// is only used when the GLM files, the public globals in effect when the load started, and the
+// layout of the classes it uses are unchanged.  Property values are copied directly into the
+// objects, except those that have notifiers or refer to other core structures.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+static const char model_stale[] = "stale model"; ///< thrown when the model cache cannot be used
+static char model_reason[1024] = ""; ///< thrown when the model cannot be cached
+
+typedef struct s_modelsource {
+	char path[1024];
+	struct s_modelsource *next;
+} MODELSOURCE;
+static MODELSOURCE *model_sources = NULL; ///< GLM files read by the load
+static bool model_sources_failed = false; ///< a GLM file could not be recorded
+static unsigned int64 model_key = 0; ///< hash of the public globals when the load started
+static GLOBALVAR **model_vars = NULL; ///< globals that existed when the load started
+static unsigned int64 *model_values = NULL; ///< hash of the values of those globals
+static size_t model_nvars = 0;
+static TRANSFORM *model_xforms = NULL; ///< first transform that existed when the load started
+
+/* how a property value is kept in the model cache */
+typedef enum {
+	MP_NONE, ///< not kept
+	MP_DATA, ///< copied
+	MP_NOTIFY, ///< copied, and set from text first when it changes so the notifier runs
+	MP_OBJECT, ///< object id
+	MP_RANDOM, ///< copied, except the random variable list
+	MP_LOADSHAPE, ///< copied, except the loadshape list, with the schedule kept by name
+	MP_ENDUSE, ///< copied, except the pointers set when the object is created
+	MP_TEXT, ///< set from text when it changes
+} MODELPROPERTY;
+
+typedef struct s_modelclass {
+	CLASS *oclass;
+	size_t nprops;
+	PROPERTY **prop; ///< properties of the class and its parents
+	MODELPROPERTY *kind;
+	size_t datasize; ///< size of the object data image
+} MODELCLASS;
+static MODELCLASS *model_class = NULL;
+static size_t model_nclasses = 0;
+static OBJECT **model_object = NULL; ///< objects in the image, by id less the first id
+static size_t model_nobjects = 0;
+static OBJECTNUM model_first = 0;
+
+#define MODEL_REASON(...) (sprintf(model_reason,__VA_ARGS__),model_reason)
+#define MODEL_ALIGN(N) (((N)+7)&~(size_t)7) ///< properties in the object data image are 8-byte aligned
+
+// FNV-1a hash
+static unsigned int64 model_hash(const void *data, size_t len, unsigned int64 hash=14695981039346656037ULL)
+{
+	const unsigned char *p = (const unsigned char*)data;
+	while ( len-->0 )
+		hash = (hash^*p++)*1099511628211ULL;
+	return hash;
+}
+
+// hash of a file, 0 if it cannot be read
+static unsigned int64 model_file_hash(const char *path)
+{
+	char buffer[65536];
+	size_t len;
+	unsigned int64 hash = model_hash(NULL,0);
+	FILE *fp = fopen(path,"rb");
+	if ( fp==NULL )
+		return 0;
+	while ( (len=fread(buffer,1,sizeof(buffer),fp))>0 )
+		hash = model_hash(buffer,len,hash);
+	fclose(fp);
+	return hash;
+}
+
+// hash of the value of a global
+static unsigned int64 model_global_hash(GLOBALVAR *var)
+{
+	char value[1024];
+	if ( global_getvar(var->prop->name,value,sizeof(value))==NULL )
+		strcpy(value,"");
+	return model_hash(value,strlen(value));
+}
+
+// globals that are not part of the model (the random seed is restored after the objects)
+static bool model_global_ignored(GLOBALVAR *var)
+{
+	return strcmp(var->prop->name,"randomseed")==0 || strcmp(var->prop->name,"model_cache")==0;
+}
+
+// globals that do not change the model when they are given on the command line
+static bool model_global_unkeyed(GLOBALVAR *var)
+{
+	static const char *unkeyed[] = {"quiet","warn","debug","verbose","show_progress","profiler","lock_profile","find_index","suppress_repeat_messages","output_message_context",NULL};
+	const char **name;
+	for ( name=unkeyed ; *name!=NULL ; name++ )
+	{
+		if ( strcmp(var->prop->name,*name)==0 )
+			return true;
+	}
+	return model_global_ignored(var);
+}
+
+// how a property is kept in the model cache
+static MODELPROPERTY model_property_kind(PROPERTY *prop)
+{
+	switch ( prop->ptype ) {
+	case PT_void:
+	case PT_method:
+		return MP_NONE;
+	case PT_object:
+		return MP_OBJECT;
+	case PT_random:
+		return MP_RANDOM;
+	case PT_loadshape:
+		return MP_LOADSHAPE;
+	case PT_enduse:
+		return MP_ENDUSE;
+	case PT_double_array:
+	case PT_complex_array:
+		return MP_TEXT;
+	case PT_delegated:
+		throw MODEL_REASON("class %s property %s is delegated", prop->oclass->name, prop->name);
+	default:
+		if ( property_size(prop)==0 )
+			throw MODEL_REASON("class %s property %s type is not supported", prop->oclass->name, prop->name);
+		return prop->notify!=NULL ? MP_NOTIFY : MP_DATA;
+	}
+}
+
+// size of a property in the object data image
+static size_t model_property_size(PROPERTY *prop, MODELPROPERTY kind)
+{
+	size_t count = prop->size>1 ? prop->size : 1;
+	switch ( kind ) {
+	case MP_DATA:
+	case MP_NOTIFY:
+		return property_size(prop)*count;
+	case MP_OBJECT:
+		return sizeof(int64)*count;
+	case MP_RANDOM:
+		return offsetof(randomvar,next);
+	case MP_LOADSHAPE:
+		return offsetof(loadshape,next)+sizeof(((SCHEDULE*)NULL)->name);
+	case MP_ENDUSE:
+		return sizeof(enduse);
+	default:
+		return 0;
+	}
+}
+
+// hash of the layout of a class
+static unsigned int64 model_class_hash(CLASS *oclass)
+{
+	CLASS *pclass;
+	PROPERTY *prop;
+	unsigned int64 hash = model_hash(&oclass->size,sizeof(oclass->size));
+	for ( pclass=oclass ; pclass!=NULL ; pclass=pclass->parent )
+	{
+		for ( prop=pclass->pmap ; prop!=NULL && prop->oclass==pclass ; prop=prop->next )
+		{
+			bool notify = (prop->notify!=NULL);
+			hash = model_hash(prop->name,strlen(prop->name),hash);
+			hash = model_hash(&prop->ptype,sizeof(prop->ptype),hash);
+			hash = model_hash(&prop->addr,sizeof(prop->addr),hash);
+			hash = model_hash(&prop->size,sizeof(prop->size),hash);
+			hash = model_hash(&prop->width,sizeof(prop->width),hash);
+			hash = model_hash(&notify,sizeof(notify),hash);
+		}
+	}
+	return hash;
+}
+
+// property table of a class
+static void model_class_init(MODELCLASS *mc, CLASS *oclass)
+{
+	CLASS *pclass;
+	PROPERTY *prop;
+	size_t n = 0;
+	mc->oclass = oclass;
+	mc->nprops = 0;
+	mc->datasize = 0;
+	for ( pclass=oclass ; pclass!=NULL ; pclass=pclass->parent )
+	{
+		for ( prop=pclass->pmap ; prop!=NULL && prop->oclass==pclass ; prop=prop->next )
+			mc->nprops++;
+	}
+	mc->prop = (PROPERTY**)malloc(sizeof(PROPERTY*)*(mc->nprops+1));
+	mc->kind = (MODELPROPERTY*)malloc(sizeof(MODELPROPERTY)*(mc->nprops+1));
+	if ( mc->prop==NULL || mc->kind==NULL )
+		throw "memory allocation failure";
+	for ( pclass=oclass ; pclass!=NULL ; pclass=pclass->parent )
+	{
+		for ( prop=pclass->pmap ; prop!=NULL && prop->oclass==pclass ; prop=prop->next )
+		{
+			mc->prop[n] = prop;
+			mc->kind[n] = model_property_kind(prop);
+			mc->datasize += MODEL_ALIGN(model_property_size(prop,mc->kind[n]));
+			n++;
+		}
+	}
+}
+
+static void model_free(void)
+{
+	size_t n;
+	for ( n=0 ; n<model_nclasses ; n++ )
+	{
+		free(model_class[n].prop);
+		free(model_class[n].kind);
+	}
+	free(model_class);
+	model_class = NULL;
+	model_nclasses = 0;
+	free(model_object);
+	model_object = NULL;
+	model_nobjects = 0;
+}
+
+// object in the image by id
+static OBJECT *model_find_object(int64 id)
+{
+	if ( id<0 )
+		return NULL;
+	if ( id<model_first || id-model_first>=(int64)model_nobjects || model_object[id-model_first]==NULL )
+		throw "object reference";
+	return model_object[id-model_first];
+}
+
+// model header and source files
+static void stream_model_sources(void)
+{
+	char header[8] = "GLD30M";
+	stream(header,sizeof(header)-1);
+	if ( strcmp(header,"GLD30M")!=0 )
+		throw "header";
+
+	stream("SRC");
+	unsigned int64 key = model_key;
+	stream(key);
+	if ( key!=model_key )
+		throw model_stale;
+
+	size_t count = 0;
+	MODELSOURCE *src;
+	if ( flags&SF_OUT )
+	{
+		for ( src=model_sources ; src!=NULL ; src=src->next )
+			count++;
+	}
+	stream(count);
+	src = model_sources;
+	size_t n;
+	for ( n=0 ; n<count ; n++ )
+	{
+		char path[1024]; if ( src ) strcpy(path,src->path);
+		stream(path,sizeof(path));
+
+		unsigned int64 hash; if ( src ) hash = model_file_hash(path);
+		if ( (flags&SF_OUT) && hash==0 )
+			throw MODEL_REASON("file '%s' cannot be read", path);
+		stream(hash);
+
+		if ( flags&SF_OUT ) src = src->next;
+		if ( (flags&SF_IN) && model_file_hash(path)!=hash )
+			throw model_stale;
+	}
+	stream("/SRC");
+}
+
+// classes used by the model (a change in layout means the image is stale)
+static void stream_model_classes(void)
+{
+	stream("MCLS");
+	size_t count = model_nclasses;
+	stream(count);
+	if ( flags&SF_IN )
+	{
+		model_class = (MODELCLASS*)calloc(count+1,sizeof(MODELCLASS));
+		if ( model_class==NULL )
+			throw "memory allocation failure";
+	}
+	size_t n;
+	for ( n=0 ; n<count ; n++ )
+	{
+		MODELCLASS *mc = model_class+n;
+
+		char modname[1024]; if ( flags&SF_OUT ) strcpy(modname,mc->oclass->module->name);
+		stream(modname,sizeof(modname));
+
+		CLASSNAME classname; if ( flags&SF_OUT ) strcpy(classname,mc->oclass->name);
+		stream(classname,sizeof(classname));
+
+		unsigned int64 hash; if ( flags&SF_OUT ) hash = model_class_hash(mc->oclass);
+		stream(hash);
+
+		if ( flags&SF_IN )
+		{
+			MODULE *mod = module_find(modname);
+			CLASS *oclass = mod ? class_get_class_from_classname_in_module(classname,mod) : NULL;
+			if ( oclass==NULL || model_class_hash(oclass)!=hash )
+				throw model_stale;
+			model_class_init(mc,oclass);
+			model_nclasses++;
+		}
+	}
+	stream("/MCLS");
+}
+
+// timezone and the globals set by the load
+static void stream_model_globals(void)
+{
+	stream("MVAR");
+
+	char tz[64]; if ( flags&SF_OUT ) { strncpy(tz,timestamp_current_timezone(),sizeof(tz)-1); tz[sizeof(tz)-1] = '\0'; }
+	stream(tz,sizeof(tz));
+	if ( (flags&SF_IN) && strcmp(tz,timestamp_current_timezone())!=0 && timestamp_set_tz(tz)==NULL )
+		throw "timezone";
+
+	size_t count = 0;
+	GLOBALVAR *var = NULL, **list = NULL;
+	if ( flags&SF_OUT )
+	{
+		// only globals that are new or changed are kept
+		size_t n = 0;
+		for ( var=global_getnext(NULL) ; var!=NULL ; var=global_getnext(var) )
+			count++;
+		list = (GLOBALVAR**)malloc(sizeof(GLOBALVAR*)*(count+1));
+		if ( list==NULL )
+			throw "memory allocation failure";
+		count = 0;
+		for ( var=global_getnext(NULL) ; var!=NULL ; var=global_getnext(var) )
+		{
+			while ( n<model_nvars && model_vars[n]!=var ) n++;
+			if ( (var->prop->access&PA_W) && !model_global_ignored(var) && ( n==model_nvars || model_values[n]!=model_global_hash(var) ) )
+				list[count++] = var;
+			if ( n==model_nvars ) n = 0;
+		}
+	}
+	stream(count);
+
+	// timestamps are always cached in ISO format because dateformat may itself be one of the globals
+	int dateformat = global_dateformat;
+	global_dateformat = DF_ISO;
+	try {
+		size_t n;
+		for ( n=0 ; n<count ; n++ )
+		{
+			var = list ? list[n] : NULL;
+
+			char name[64]; if ( var ) strcpy(name,var->prop->name);
+			stream(name,sizeof(name));
+
+			char value[1024];
+			if ( var )
+			{
+				if ( strcmp(name,"dateformat")==0 )
+					global_dateformat = dateformat;
+				global_getvar(name,value,sizeof(value));
+				global_dateformat = DF_ISO;
+			}
+			stream(value,sizeof(value));
+
+			if ( flags&SF_IN )
+			{
+				char current[1024];
+				if ( global_getvar(name,current,sizeof(current))==NULL || strcmp(current,value)!=0 )
+				{
+					int strictnames = global_strictnames;
+					STATUS status;
+					global_strictnames = FALSE;
+					status = global_setvar(name,value);
+					global_strictnames = strictnames;
+					if ( strcmp(name,"dateformat")==0 )
+					{
+						dateformat = global_dateformat;
+						global_dateformat = DF_ISO;
+					}
+					if ( status==FAILED )
+						throw MODEL_REASON("global %s could not be set to '%s'", name, value);
+				}
+			}
+		}
+	}
+	catch (...)
+	{
+		global_dateformat = dateformat;
+		free(list);
+		throw;
+	}
+	global_dateformat = dateformat;
+	free(list);
+	stream("/MVAR");
+}
+
+// schedules (in the order they were created)
+static void stream_model_schedules(void)
+{
+	static char definition[MAXDEFINITION];
+	stream("SCH");
+	size_t count = 0;
+	SCHEDULE *sch, **list = NULL;
+	if ( flags&SF_OUT )
+	{
+		for ( sch=schedule_getfirst() ; sch!=NULL ; sch=schedule_getnext(sch) )
+			count++;
+		list = (SCHEDULE**)malloc(sizeof(SCHEDULE*)*(count+1));
+		if ( list==NULL )
+			throw "memory allocation failure";
+		size_t n = count;
+		for ( sch=schedule_getfirst() ; sch!=NULL ; sch=schedule_getnext(sch) )
+			list[--n] = sch;
+	}
+	stream(count);
+	size_t n;
+	for ( n=0 ; n<count ; n++ )
+	{
+		char name[64]; if ( list ) strcpy(name,list[n]->name);
+		stream(name,sizeof(name));
+
+		if ( list ) strcpy(definition,list[n]->definition?list[n]->definition:"");
+		stream(definition,sizeof(definition));
+
+		if ( (flags&SF_IN) && schedule_create(name,definition)==NULL )
+			throw MODEL_REASON("schedule %s could not be created", name);
+	}
+	free(list);
+	stream("/SCH");
+}
+
+// object header data not kept with the properties
+typedef struct s_modelobject {
+	OBJECTNUM id;
+	unsigned int oclass; ///< index in the class table
+	int64 parent; ///< parent id, -1 for none
+	unsigned int child_count;
+	OBJECTRANK rank;
+	TIMESTAMP clock, valid_to, schedule_skew;
+	double latitude, longitude;
+	TIMESTAMP in_svc, out_svc;
+	unsigned int in_svc_micro, out_svc_micro;
+	double in_svc_double, out_svc_double;
+	unsigned int rng_state;
+	TIMESTAMP heartbeat;
+	uint64 flags;
+	char32 groupid;
+} MODELOBJECT;
+
+// objects and their property values
+static void stream_model_objects(void)
+{
+	static char text[65536];
+	stream("MOBJ");
+
+	size_t count = model_nobjects;
+	stream(count);
+	stream(model_first);
+	if ( flags&SF_IN )
+	{
+		model_object = (OBJECT**)calloc(count+1,sizeof(OBJECT*));
+		if ( model_object==NULL )
+			throw "memory allocation failure";
+		model_nobjects = count;
+	}
+
+	size_t n, k, maxsize = 0;
+	for ( k=0 ; k<model_nclasses ; k++ )
+	{
+		if ( model_class[k].datasize>maxsize ) maxsize = model_class[k].datasize;
+	}
+	typedef struct { OBJECT **addr; int64 id; } MODELREFERENCE;
+	MODELREFERENCE *refs = NULL;
+	size_t nrefs = 0, maxrefs = 0;
+	char *data = (char*)malloc(maxsize+1);
+	MODELOBJECT *header = (MODELOBJECT*)malloc(sizeof(MODELOBJECT)*(count+1));
+	if ( data==NULL || header==NULL )
+	{
+		free(data);
+		free(header);
+		throw "memory allocation failure";
+	}
+
+	try {
+		for ( n=0 ; n<count ; n++ )
+		{
+			OBJECT *obj = model_object[n];
+			MODELOBJECT *hdr = header+n;
+			if ( flags&SF_OUT )
+			{
+				memset(hdr,0,sizeof(MODELOBJECT));
+				hdr->id = obj->id;
+				for ( hdr->oclass=0 ; model_class[hdr->oclass].oclass!=obj->oclass ; hdr->oclass++ ) {}
+				hdr->parent = obj->parent ? (int64)obj->parent->id : -1;
+				hdr->child_count = obj->child_count;
+				hdr->rank = obj->rank;
+				hdr->clock = obj->clock;
+				hdr->valid_to = obj->valid_to;
+				hdr->schedule_skew = obj->schedule_skew;
+				hdr->latitude = obj->latitude;
+				hdr->longitude = obj->longitude;
+				hdr->in_svc = obj->in_svc;
+				hdr->out_svc = obj->out_svc;
+				hdr->in_svc_micro = obj->in_svc_micro;
+				hdr->out_svc_micro = obj->out_svc_micro;
+				hdr->in_svc_double = obj->in_svc_double;
+				hdr->out_svc_double = obj->out_svc_double;
+				hdr->rng_state = obj->rng_state;
+				hdr->heartbeat = obj->heartbeat;
+				hdr->flags = obj->flags;
+				strcpy(hdr->groupid,obj->groupid);
+			}
+			stream(*hdr);
+			if ( hdr->oclass>=model_nclasses )
+				throw "class index";
+			MODELCLASS *mc = model_class+hdr->oclass;
+
+			char name[1024]; if ( obj ) strcpy(name,obj->name?obj->name:"");
+			stream(name,sizeof(name));
+
+			if ( flags&SF_IN )
+			{
+				// create the object the way the loader does
+				OBJECT *parent = ( hdr->parent>=0 && hdr->parent<hdr->id ) ? model_find_object(hdr->parent) : NULL;
+				if ( mc->oclass->create!=NULL )
+				{
+					if ( (*mc->oclass->create)(&obj,parent)==0 || obj==NULL )
+						throw MODEL_REASON("create failed for object %s:%d", mc->oclass->name, hdr->id);
+				}
+				else if ( (obj=object_create_single(mc->oclass))==NULL )
+					throw MODEL_REASON("create failed for object %s:%d", mc->oclass->name, hdr->id);
+				if ( obj->id!=hdr->id )
+					throw MODEL_REASON("object %s:%d was created as %s:%d", mc->oclass->name, hdr->id, mc->oclass->name, obj->id);
+				model_object[n] = obj;
+				if ( name[0]!='\0' && object_set_name(obj,name)==NULL )
+					throw MODEL_REASON("object %s:%d could not be named '%s'", mc->oclass->name, hdr->id, name);
+				obj->clock = hdr->clock;
+				obj->valid_to = hdr->valid_to;
+				obj->schedule_skew = hdr->schedule_skew;
+				obj->latitude = hdr->latitude;
+				obj->longitude = hdr->longitude;
+				obj->in_svc = hdr->in_svc;
+				obj->out_svc = hdr->out_svc;
+				obj->in_svc_micro = hdr->in_svc_micro;
+				obj->out_svc_micro = hdr->out_svc_micro;
+				obj->in_svc_double = hdr->in_svc_double;
+				obj->out_svc_double = hdr->out_svc_double;
+				obj->rng_state = hdr->rng_state;
+				obj->heartbeat = hdr->heartbeat;
+				obj->flags = hdr->flags;
+				strcpy(obj->groupid,hdr->groupid);
+			}
+
+			// property values that are copied
+			char *pos = data;
+			memset(data,0,mc->datasize);
+			for ( k=0 ; k<mc->nprops ; k++ )
+			{
+				PROPERTY *prop = mc->prop[k];
+				size_t size = model_property_size(prop,mc->kind[k]);
+				if ( (flags&SF_OUT) && size>0 )
+				{
+					char *addr = (char*)(obj+1)+(int64)prop->addr;
+					if ( mc->kind[k]==MP_OBJECT )
+					{
+						size_t i;
+						for ( i=0 ; i<size/sizeof(int64) ; i++ )
+						{
+							OBJECT *ref = ((OBJECT**)addr)[i];
+							int64 id = ref ? (int64)ref->id : -1;
+							memcpy(pos+i*sizeof(int64),&id,sizeof(id));
+						}
+					}
+					else if ( mc->kind[k]==MP_LOADSHAPE )
+					{
+						SCHEDULE *sch = ((loadshape*)addr)->schedule;
+						memcpy(pos,addr,offsetof(loadshape,next));
+						strcpy(pos+offsetof(loadshape,next),sch?sch->name:"");
+					}
+					else
+						memcpy(pos,addr,size);
+				}
+				pos += MODEL_ALIGN(size);
+			}
+			stream((void*)data,mc->datasize);
+			if ( flags&SF_IN )
+			{
+				for ( pos=data, k=0 ; k<mc->nprops ; k++ )
+				{
+					PROPERTY *prop = mc->prop[k];
+					size_t size = model_property_size(prop,mc->kind[k]);
+					char *addr = (char*)(obj+1)+(int64)prop->addr;
+					switch ( mc->kind[k] ) {
+					case MP_NOTIFY:
+						if ( memcmp(addr,pos,size)!=0 )
+						{
+							if ( class_property_to_string(prop,pos,text,sizeof(text))<=0
+								|| object_set_value_by_name(obj,prop->name,text)<=0 )
+								throw MODEL_REASON("object %s:%d property %s could not be set", mc->oclass->name, hdr->id, prop->name);
+						}
+						// fall through to copy the exact value
+					case MP_DATA:
+					case MP_RANDOM:
+						memcpy(addr,pos,size);
+						break;
+					case MP_LOADSHAPE:
+					{
+						loadshape *ls = (loadshape*)addr;
+						char *sname = pos+offsetof(loadshape,next);
+						memcpy(ls,pos,offsetof(loadshape,next));
+						ls->schedule = sname[0]!='\0' ? schedule_find_byname(sname) : NULL;
+						if ( sname[0]!='\0' && ls->schedule==NULL )
+							throw MODEL_REASON("object %s:%d property %s schedule %s not found", mc->oclass->name, hdr->id, prop->name, sname);
+						break;
+					}
+					case MP_ENDUSE:
+					{
+						enduse *eu = (enduse*)addr, created = *eu;
+						memcpy(eu,pos,sizeof(enduse));
+						eu->name = created.name;
+						eu->shape = created.shape;
+						eu->end_obj = created.end_obj;
+						eu->next = created.next;
+						break;
+					}
+					case MP_OBJECT:
+						// references are resolved once all the objects exist
+						for ( size_t i=0 ; i<size/sizeof(int64) ; i++ )
+						{
+							if ( nrefs==maxrefs )
+							{
+								MODELREFERENCE *more = (MODELREFERENCE*)realloc(refs,sizeof(MODELREFERENCE)*(maxrefs=maxrefs*2+1024));
+								if ( more==NULL )
+									throw "memory allocation failure";
+								refs = more;
+							}
+							refs[nrefs].addr = (OBJECT**)addr+i;
+							memcpy(&refs[nrefs].id,pos+i*sizeof(int64),sizeof(int64));
+							nrefs++;
+						}
+						break;
+					default:
+						break;
+					}
+					pos += MODEL_ALIGN(size);
+				}
+			}
+
+			// property values that are set from text
+			for ( k=0 ; k<mc->nprops ; k++ )
+			{
+				if ( mc->kind[k]!=MP_TEXT )
+					continue;
+				PROPERTY *prop = mc->prop[k];
+				void *addr = (void*)((char*)(obj+1)+(int64)prop->addr);
+				if ( flags&SF_OUT && class_property_to_string(prop,addr,text,sizeof(text))<0 )
+					throw MODEL_REASON("object %s:%d property %s could not be converted to text", mc->oclass->name, hdr->id, prop->name);
+				stream(text,sizeof(text));
+				if ( flags&SF_IN )
+				{
+					char current[sizeof(text)];
+					if ( ( class_property_to_string(prop,addr,current,sizeof(current))<0 || strcmp(current,text)!=0 )
+						&& object_set_value_by_name(obj,prop->name,text)<=0 )
+						throw MODEL_REASON("object %s:%d property %s could not be set to '%s'", mc->oclass->name, hdr->id, prop->name, text);
+				}
+			}
+		}
+
+		if ( flags&SF_IN )
+		{
+			// object references, parents, and ranks
+			for ( k=0 ; k<nrefs ; k++ )
+				*(refs[k].addr) = model_find_object(refs[k].id);
+			for ( n=0 ; n<count ; n++ )
+			{
+				OBJECT *obj = model_object[n];
+				MODELOBJECT *hdr = header+n;
+				obj->parent = model_find_object(hdr->parent);
+				obj->child_count = hdr->child_count;
+				obj->rank = hdr->rank;
+			}
+		}
+	}
+	catch (...)
+	{
+		free(data);
+		free(header);
+		free(refs);
+		throw;
+	}
+	free(data);
+	free(header);
+	free(refs);
+	stream("/MOBJ");
+}
+
+// objects sorted by address (used to find transform sources)
+static int model_object_compare(const void *a, const void *b)
+{
+	OBJECT *x = *(OBJECT**)a, *y = *(OBJECT**)b;
+	return x<y ? -1 : ( x>y ? 1 : 0 );
+}
+
+// linear transforms added by the load (in the order they were added)
+static void stream_model_transforms(void)
+{
+	stream("XFRM");
+	size_t count = 0;
+	TRANSFORM *xform, **list = NULL;
+	OBJECT **sorted = NULL;
+	if ( flags&SF_OUT )
+	{
+		for ( xform=transform_getnext(NULL) ; xform!=NULL && xform!=model_xforms ; xform=transform_getnext(xform) )
+			count++;
+		list = (TRANSFORM**)malloc(sizeof(TRANSFORM*)*(count+1));
+		sorted = (OBJECT**)malloc(sizeof(OBJECT*)*(model_nobjects+1));
+		if ( list==NULL || sorted==NULL )
+		{
+			free(list);
+			free(sorted);
+			throw "memory allocation failure";
+		}
+		size_t n = count;
+		for ( xform=transform_getnext(NULL) ; n>0 ; xform=transform_getnext(xform) )
+			list[--n] = xform;
+		memcpy(sorted,model_object,sizeof(OBJECT*)*model_nobjects);
+		qsort(sorted,model_nobjects,sizeof(OBJECT*),model_object_compare);
+	}
+	try {
+		stream(count);
+		size_t n;
+		for ( n=0 ; n<count ; n++ )
+		{
+			xform = list ? list[n] : NULL;
+			if ( xform && xform->function_type!=XT_LINEAR )
+				throw MODEL_REASON("%s transform of %s:%d property %s is not supported",
+					xform->function_type==XT_FILTER?"filter":"external",
+					xform->target_obj->oclass->name, xform->target_obj->id, xform->target_prop->name);
+
+			int64 target = xform ? (int64)xform->target_obj->id : -1;
+			stream(target);
+
+			PROPERTYNAME pname; if ( xform ) strcpy(pname,xform->target_prop->name);
+			stream(pname,sizeof(pname));
+
+			TRANSFORMSOURCE stype; if ( xform ) stype = xform->source_type;
+			stream(stype);
+
+			double scale; if ( xform ) scale = xform->scale;
+			stream(scale);
+
+			double bias; if ( xform ) bias = xform->bias;
+			stream(bias);
+
+			// the source is either a schedule or an object property
+			char sname[64] = "";
+			int64 source = -1, offset = 0;
+			if ( xform && xform->source_schedule!=NULL )
+				strcpy(sname,xform->source_schedule->name);
+			else if ( xform )
+			{
+				size_t lo = 0, hi = model_nobjects;
+				char *addr = (char*)xform->source;
+				while ( hi-lo>1 )
+				{
+					size_t mid = (lo+hi)/2;
+					if ( (char*)sorted[mid]<=addr ) lo = mid; else hi = mid;
+				}
+				OBJECT *obj = model_nobjects>0 ? sorted[lo] : NULL;
+				if ( obj==NULL || addr<(char*)(obj+1) || addr>=(char*)(obj+1)+obj->oclass->size )
+					throw MODEL_REASON("transform source of %s:%d property %s is not an object property",
+						xform->target_obj->oclass->name, xform->target_obj->id, xform->target_prop->name);
+				source = obj->id;
+				offset = addr-(char*)(obj+1);
+			}
+			stream(sname,sizeof(sname));
+			stream(source);
+			stream(offset);
+
+			if ( flags&SF_IN )
+			{
+				OBJECT *obj = model_find_object(target);
+				PROPERTY *prop = obj ? class_find_property(obj->oclass,pname) : NULL;
+				SCHEDULE *sch = sname[0]!='\0' ? schedule_find_byname(sname) : NULL;
+				OBJECT *from = model_find_object(source);
+				double *addr = sch ? (double*)sch : ( from ? (double*)((char*)(from+1)+offset) : NULL );
+				if ( prop==NULL || addr==NULL || ( from && ( offset<0 || offset>=from->oclass->size ) ) )
+					throw "transform";
+				if ( !transform_add_linear(stype,addr,(void*)((char*)(obj+1)+(int64)prop->addr),scale,bias,obj,prop,sch) )
+					throw "memory allocation failure";
+			}
+		}
+	}
+	catch (...)
+	{
+		free(list);
+		free(sorted);
+		throw;
+	}
+	free(list);
+	free(sorted);
+	stream("/XFRM");
+}
+
+// the model cache image
+static void stream_model(void)
+{
+	// nothing changes until the image is known to be current
+	stream_model_sources();
+	stream(module_get_first());
+	stream_model_classes();
+
+	stream_model_globals();
+	stream_model_schedules();
+	stream_model_objects();
+	stream_model_transforms();
+
+	// the random number sequence continues where the load left it
+	stream("RNG");
+	stream(global_randomseed);
+	stream("/RNG");
+}
+
+/** Start recording a model load for the model cache
+	This must be called before the GLM file is loaded.
+ **/
+extern "C" void stream_model_begin(void)
+{
+	GLOBALVAR *var;
+	MODELSOURCE *src;
+	size_t count = 0;
+
+	while ( (src=model_sources)!=NULL )
+	{
+		model_sources = src->next;
+		free(src);
+	}
+	model_sources_failed = false;
+
+	// the model depends on the version and on the public globals
+	model_key = model_hash(&global_version_major,sizeof(global_version_major));
+	model_key = model_hash(&global_version_minor,sizeof(global_version_minor),model_key);
+	model_key = model_hash(&global_version_patch,sizeof(global_version_patch),model_key);
+	model_key = model_hash(&global_version_build,sizeof(global_version_build),model_key);
+	for ( var=global_getnext(NULL) ; var!=NULL ; var=global_getnext(var) )
+		count++;
+	free(model_vars);
+	free(model_values);
+	model_vars = (GLOBALVAR**)malloc(sizeof(GLOBALVAR*)*(count+1));
+	model_values = (unsigned int64*)malloc(sizeof(unsigned int64)*(count+1));
+	model_nvars = 0;
+	for ( var=global_getnext(NULL) ; var!=NULL && model_vars!=NULL && model_values!=NULL ; var=global_getnext(var) )
+	{
+		unsigned int64 hash = model_global_hash(var);
+		model_vars[model_nvars] = var;
+		model_values[model_nvars++] = hash;
+		if ( var->prop->access==PA_PUBLIC && !model_global_unkeyed(var) )
+		{
+			model_key = model_hash(var->prop->name,strlen(var->prop->name),model_key);
+			model_key = model_hash(&hash,sizeof(hash),model_key);
+		}
+	}
+	if ( model_nvars<count )
+		model_sources_failed = true;
+
+	model_xforms = transform_getnext(NULL);
+}
+
+/** Record a GLM file read by the model load
+ **/
+extern "C" void stream_model_source(char *path)
+{
+	MODELSOURCE *src = (MODELSOURCE*)malloc(sizeof(MODELSOURCE));
+	if ( src==NULL || strlen(path)>=sizeof(src->path) )
+	{
+		free(src);
+		model_sources_failed = true;
+		return;
+	}
+	strcpy(src->path,path);
+	src->next = model_sources;
+	model_sources = src;
+}
+
+/** Load a model from the model cache
+	@returns 1 if the model was loaded, 0 if the cache is missing or stale, -1 on failure
+ **/
+extern "C" int stream_model_load(char *fname)
+{
+	int result = 1;
+	FILE *fileptr = fopen(fname,"rb");
+	if ( fileptr==NULL )
+		return 0;
+	stream_pos = 0;
+	fp = fileptr;
+	flags = SF_IN|SF_MODEL;
+	try {
+		stream_model();
+		IN_MYCONTEXT output_verbose("model loaded from model cache '%s' (%d objects)", fname, model_nobjects);
+	}
+	catch (const char *msg)
+	{
+		if ( msg==model_stale )
+		{
+			IN_MYCONTEXT output_verbose("model cache '%s' is stale", fname);
+			result = 0;
+		}
+		else
+		{
+			output_error("model cache '%s' could not be loaded: %s at offset %lld", fname, msg, (int64)stream_pos);
+			/* TROUBLESHOOT
+				The model cache named by the <b>model_cache</b> global could not be loaded.  Delete the
+				model cache file and run the model again to rebuild it.
+			 */
+			result = -1;
+		}
+	}
+	catch (...)
+	{
+		output_error("model cache '%s' could not be loaded: invalid data at offset %lld", fname, (int64)stream_pos);
+		/* TROUBLESHOOT
+			The model cache named by the <b>model_cache</b> global is not a valid model cache.  Delete the
+			model cache file and run the model again to rebuild it.
+		 */
+		result = -1;
+	}
+	fclose(fileptr);
+	model_free();
+	return result;
+}
+
+/** Save the model just loaded to the model cache
+	@returns 1 if the model was saved, 0 if it cannot be cached, -1 on failure
+ **/
+extern "C" int stream_model_save(char *fname)
+{
+	int result = 1;
+	char tmpname[1024];
+	FILE *fileptr = NULL;
+	OBJECT *obj;
+	CLASS *oclass;
+	int *index = NULL;
+	size_t n, maxclass = 0;
+
+	try {
+		if ( model_sources_failed )
+			throw "model sources could not be recorded";
+
+		// objects and the classes they use
+		for ( oclass=class_get_first_class() ; oclass!=NULL ; oclass=oclass->next )
+		{
+			if ( oclass->id>=0 && (size_t)oclass->id>=maxclass ) maxclass = oclass->id+1;
+		}
+		index = (int*)malloc(sizeof(int)*(maxclass+1));
+		model_nobjects = object_get_count();
+		model_object = (OBJECT**)malloc(sizeof(OBJECT*)*(model_nobjects+1));
+		model_class = (MODELCLASS*)calloc(maxclass+1,sizeof(MODELCLASS));
+		if ( index==NULL || model_object==NULL || model_class==NULL )
+			throw "memory allocation failure";
+		for ( n=0 ; n<maxclass ; n++ )
+			index[n] = -1;
+		obj = object_get_first();
+		model_first = obj ? obj->id : 0;
+		for ( n=0 ; obj!=NULL ; obj=obj->next, n++ )
+		{
+			model_object[n] = obj;
+			if ( obj->id!=model_first+n )
+				throw "object ids are not sequential";
+			if ( obj->forecast!=NULL || obj->space!=NULL )
+				throw MODEL_REASON("object %s:%d uses forecasts or namespaces", obj->oclass->name, obj->id);
+			if ( obj->name!=NULL && strlen(obj->name)>=1024 )
+				throw MODEL_REASON("object %s:%d name is too long", obj->oclass->name, obj->id);
+			if ( obj->oclass->module==NULL )
+				throw MODEL_REASON("class %s is defined by the model", obj->oclass->name);
+			if ( index[obj->oclass->id]<0 )
+			{
+				index[obj->oclass->id] = (int)model_nclasses;
+				model_class_init(model_class+model_nclasses++,obj->oclass);
+			}
+		}
+
+		// write to a temporary file so a failed save does not leave a partial cache
+		sprintf(tmpname,"%.1000s.tmp",fname);
+		fileptr = fopen(tmpname,"wb");
+		if ( fileptr==NULL )
+			throw MODEL_REASON("'%s' cannot be opened for writing", tmpname);
+		stream_pos = 0;
+		fp = fileptr;
+		flags = SF_OUT|SF_MODEL;
+		stream_model();
+		if ( fclose(fileptr)!=0 )
+		{
+			fileptr = NULL;
+			throw MODEL_REASON("'%s' could not be written", tmpname);
+		}
+		fileptr = NULL;
+#ifdef WIN32
+		unlink(fname);
+#endif
+		if ( rename(tmpname,fname)!=0 )
+			throw MODEL_REASON("'%s' could not be renamed to '%s'", tmpname, fname);
+		IN_MYCONTEXT output_verbose("model saved to model cache '%s' (%lld bytes)", fname, (int64)stream_pos);
+	}
+	catch (const char *msg)
+	{
+		output_warning("model cache '%s' not saved: %s", fname, msg);
+		/* TROUBLESHOOT
+			The model just loaded uses a feature the model cache does not support, or the model cache
+			could not be written.  The model will be loaded from GLM each time it is run.
+		 */
+		result = 0;
+	}
+	catch (...)
+	{
+		output_warning("model cache '%s' not saved: write failed at offset %lld", fname, (int64)stream_pos);
+		/* TROUBLESHOOT
+			The model cache could not be written.  Check that there is enough space on the device
+			where the model cache is written.
+		 */
+		result = -1;
+	}
+	if ( fileptr!=NULL )
+	{
+		fclose(fileptr);
+		unlink(tmpname);
+	}
+	free(index);
+	model_free();
+	return result;
+}
+
 #define stream_type(T) extern "C" size_t stream_##T(void *ptr, size_t len, PROPERTY *prop) { return stream((T*)ptr,len); }
 #include "stream_type.h"
 #undef stream_type
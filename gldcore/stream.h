@@ -14,6 +14,9 @@
 #define SF_IN		0x0001
 #define SF_OUT		0x0002
 #define SF_STR		0x0004
+#define SF_BASE		0x0008	/* record object checksums for later SF_DELTA streams */
+#define SF_DELTA	0x0010	/* only objects changed since the last SF_BASE or SF_DELTA stream */
+#define SF_MODEL	0x0020	/* model cache image (see stream_model_save) */
 
 typedef const char *TOKEN;
 typedef unsigned int uint;
@@ -35,6 +38,11 @@ typedef size_t (*STREAMCALL)(int flags,STREAMCALLBACK call);
 void stream_register(STREAMCALL);
 size_t stream(FILE *fp, int flags);
 char* stream_context();
+int stream_delta_init(void);
+void stream_model_begin(void);
+void stream_model_source(char *path);
+int stream_model_load(char *fname);
+int stream_model_save(char *fname);
 #endif
 
 #define stream_type(T) size_t stream_##T(void*,size_t,PROPERTY*p)
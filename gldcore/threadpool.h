@@ -36,7 +36,8 @@ If the #mti_run() call succeeds or no iterations is needed, it returns 1.  If it
 fails it returns 0 and a single threaded iteration should be performed by the caller
 instead.
 
-An example of how this is done is implemented in exec.c for commit_all().
+The core no longer uses MTIs; its parallel loops all run on the main loop
+executor (see executor.h) so that the thread count is not exceeded.
 
 @{**/
 
@@ -0,0 +1,221 @@
+/** $Id$
+    Copyright (C) 2008 Battelle Memorial Institute
+	@file watchdog.c
+	@addtogroup watchdog
+	@ingroup core
+
+	Sync lockup watchdog implementation.
+
+ @{
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "watchdog.h"
+#include "output.h"
+#include "globals.h"
+#include "lock.h"
+
+/** Sync slot of a thread **/
+typedef struct s_watchdogslot {
+	OBJECT * volatile obj; /**< object being synced, NULL when idle */
+	volatile unsigned int count; /**< number of syncs started by the thread */
+	volatile PASSCONFIG pass; /**< pass of the current sync */
+	int in_use; /**< flag indicating the slot belongs to a running thread */
+	unsigned int last_count; /**< sync count at the last sample (monitor only) */
+	unsigned int since; /**< sample at which the current sync was first seen (monitor only) */
+	struct s_watchdogslot *next; /**< next slot */
+} WATCHDOGSLOT;
+
+static WATCHDOGSLOT * volatile first_slot = NULL; /**< slot list (slots are reused but never freed) */
+static unsigned int slot_lock = 0;
+static pthread_key_t slot_key;
+static int key_ok = 0;
+
+static volatile int running = 0;
+static unsigned int sample = 0; /**< number of samples taken (monitor only) */
+static pthread_t monitor_thread;
+static pthread_mutex_t monitor_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t monitor_wake = PTHREAD_COND_INITIALIZER;
+
+/* release the slot of a thread that exits so that another thread can use it */
+static void release_slot(void *ptr)
+{
+	WATCHDOGSLOT *slot = (WATCHDOGSLOT*)ptr;
+	slot->obj = NULL;
+	wlock(&slot_lock);
+	slot->in_use = 0;
+	wunlock(&slot_lock);
+}
+
+/* get the slot of the calling thread, assigning one if needed */
+static WATCHDOGSLOT *get_slot(void)
+{
+	WATCHDOGSLOT *slot = (WATCHDOGSLOT*)pthread_getspecific(slot_key);
+	if ( slot!=NULL )
+		return slot;
+
+	wlock(&slot_lock);
+	for ( slot=first_slot ; slot!=NULL ; slot=slot->next )
+	{
+		if ( !slot->in_use )
+			break;
+	}
+	if ( slot==NULL )
+	{
+		slot = (WATCHDOGSLOT*)malloc(sizeof(WATCHDOGSLOT));
+		if ( slot!=NULL )
+		{
+			memset(slot,0,sizeof(WATCHDOGSLOT));
+			slot->next = first_slot;
+			first_slot = slot;
+		}
+	}
+	if ( slot!=NULL )
+		slot->in_use = 1;
+	wunlock(&slot_lock);
+
+	if ( slot!=NULL )
+		pthread_setspecific(slot_key,slot);
+	return slot;
+}
+
+/* report a sync that exceeded the maximum sync time and stop */
+static void lockup(OBJECT *obj, PASSCONFIG pass, unsigned int elapsed)
+{
+	char name[64];
+	char *passname = (pass==PC_PRETOPDOWN?"PC_PRETOPDOWN":(pass==PC_BOTTOMUP?"PC_BOTTOMUP":(pass==PC_POSTTOPDOWN?"PC_POSTTOPDOWN":"<unknown>")));
+	output_fatal("object_sync(OBJECT *obj='%s', PASSCONFIG pass=%s): sync has not completed after %d seconds", object_name(obj,name,sizeof(name)), passname, elapsed);
+	/*	TROUBLESHOOT
+		The sync of the indicated object took longer than the time allowed
+		by the global variable maximum_synctime.  This usually means that the
+		object is stuck in a loop.  Check the object's properties and the
+		module that implements the class.  If the object really needs more
+		time to sync, increase maximum_synctime, or set it to zero to disable
+		the check.
+	 */
+#ifdef WIN32
+	exit(XC_RUNERR);
+#else
+	raise(SIGALRM);
+#endif
+}
+
+/* monitor thread main loop */
+static void *monitor_proc(void *arg)
+{
+	struct timespec ts;
+	ts.tv_sec = time(NULL);
+	ts.tv_nsec = 0;
+	pthread_mutex_lock(&monitor_lock);
+	while ( running )
+	{
+		WATCHDOGSLOT *slot;
+
+		/* wait until the next one second sample time, or until stopped */
+		ts.tv_sec++;
+		while ( running && pthread_cond_timedwait(&monitor_wake,&monitor_lock,&ts)==0 )
+			;
+		if ( !running )
+			break;
+
+		/* sample the slots */
+		sample++;
+		for ( slot=first_slot ; slot!=NULL ; slot=slot->next )
+		{
+			OBJECT *obj = slot->obj;
+			unsigned int count = slot->count;
+			if ( obj==NULL || count!=slot->last_count )
+			{
+				slot->last_count = count;
+				slot->since = sample;
+			}
+			else if ( global_maximum_synctime>0 && sample-slot->since>=(unsigned int)global_maximum_synctime )
+				lockup(obj,slot->pass,sample-slot->since);
+		}
+	}
+	pthread_mutex_unlock(&monitor_lock);
+	return NULL;
+}
+
+/** Start the watchdog monitor
+	@return 1 on success (or when the watchdog is disabled), 0 on failure
+ **/
+int watchdog_start(void)
+{
+	if ( running || global_maximum_synctime<=0 )
+		return 1;
+	if ( !key_ok )
+	{
+		if ( pthread_key_create(&slot_key,release_slot)!=0 )
+		{
+			output_error("watchdog_start(): unable to create thread slot key");
+			/*	TROUBLESHOOT
+				The watchdog could not allocate the thread-specific data it uses to track
+				object syncs.  Free up system resources and try again, or set maximum_synctime
+				to zero to disable the watchdog.
+			 */
+			return 0;
+		}
+		key_ok = 1;
+	}
+	running = 1;
+	if ( pthread_create(&monitor_thread,NULL,monitor_proc,NULL)!=0 )
+	{
+		running = 0;
+		output_error("watchdog_start(): unable to start monitor thread");
+		/*	TROUBLESHOOT
+			The watchdog thread could not be created.  Free up system resources
+			and try again, or set maximum_synctime to zero to disable the watchdog.
+		 */
+		return 0;
+	}
+	return 1;
+}
+
+/** Stop the watchdog monitor
+ **/
+void watchdog_stop(void)
+{
+	if ( !running )
+		return;
+	pthread_mutex_lock(&monitor_lock);
+	running = 0;
+	pthread_cond_signal(&monitor_wake);
+	pthread_mutex_unlock(&monitor_lock);
+	pthread_join(monitor_thread,NULL);
+}
+
+/** Record the start of an object sync by the calling thread
+ **/
+void watchdog_enter(OBJECT *obj, PASSCONFIG pass)
+{
+	WATCHDOGSLOT *slot;
+	if ( !running )
+		return;
+	slot = get_slot();
+	if ( slot==NULL )
+		return;
+	/* the count must change before the object so the monitor never mistakes a new sync for an old one */
+	slot->count++;
+	slot->pass = pass;
+	slot->obj = obj;
+}
+
+/** Record the end of an object sync by the calling thread
+ **/
+void watchdog_leave(void)
+{
+	WATCHDOGSLOT *slot;
+	if ( !key_ok )
+		return;
+	slot = (WATCHDOGSLOT*)pthread_getspecific(slot_key);
+	if ( slot!=NULL )
+		slot->obj = NULL;
+}
+
+/**@}**/
@@ -0,0 +1,41 @@
+/** $Id$
+    Copyright (C) 2008 Battelle Memorial Institute
+
+@file watchdog.h
+@addtogroup watchdog Sync lockup watchdog
+@ingroup core
+
+The watchdog detects object syncs that do not complete within
+#global_maximum_synctime seconds.
+
+Each thread that syncs objects owns a slot that records the object
+currently being synced and a count of the syncs started by the thread.
+Updating the slot only requires a few stores, so it is much cheaper than
+arming an alarm for each sync.  A single monitor thread samples the slots
+about once a second, and when the same sync is found in a slot for longer
+than the maximum sync time, the monitor reports the object and stops the
+simulation the same way the lockup alarm did.
+
+Setting \p maximum_synctime to zero disables the watchdog.
+
+@{**/
+
+#ifndef _WATCHDOG_H
+#define _WATCHDOG_H
+
+#include "object.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int watchdog_start(void);
+void watchdog_stop(void);
+void watchdog_enter(OBJECT *obj, PASSCONFIG pass);
+void watchdog_leave(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /**@} _WATCHDOG_H */
@@ -80,6 +80,8 @@ powerflow_powerflow_la_SOURCES += powerflow/sectionalizer.cpp
 powerflow_powerflow_la_SOURCES += powerflow/sectionalizer.h
 powerflow_powerflow_la_SOURCES += powerflow/series_reactor.cpp
 powerflow_powerflow_la_SOURCES += powerflow/series_reactor.h
+powerflow_powerflow_la_SOURCES += powerflow/solver_klu.cpp
+powerflow_powerflow_la_SOURCES += powerflow/solver_klu.h
 powerflow_powerflow_la_SOURCES += powerflow/solver_nr.cpp
 powerflow_powerflow_la_SOURCES += powerflow/solver_nr.h
 powerflow_powerflow_la_SOURCES += powerflow/substation.cpp
@@ -708,6 +708,16 @@ int node::init(OBJECT *parent)
 			{
 				matrix_solver_method=MM_SUPERLU;	//This is the default, but we'll set it here anyways
 			}
+			else if (stricmp(LUSolverName.get_string(),"KLU")==0)	//Built-in KLU solver
+			{
+				gl_verbose("Built-in KLU solver selected for NR");
+				/*  TROUBLESHOOT
+				The built-in KLU matrix solver was requested with lu_solver "KLU", so NR will be calculated
+				using that instead of superLU.
+				*/
+
+				matrix_solver_method=MM_KLU;
+			}
 			else	//Something is there, see if we can find it
 			{
 				//Initialize the global
@@ -1413,7 +1423,7 @@ TIMESTAMP node::presync(TIMESTAMP t0)
 	{
 		if (prev_NTime==0)	//First run, if we are a child, make sure no one linked us before we knew that
 		{
-			if (((SubNode == CHILD) || (SubNode == DIFF_CHILD)) && (NR_connected_links>0))
+			if ((SubNode == CHILD) || (SubNode == DIFF_CHILD))
 			{
 				node *parNode = OBJECTDATA(SubNodeParent,node);
 
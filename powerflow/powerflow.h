@@ -29,7 +29,7 @@ void print_matrix(complex mat[3][3]);
 #define IMPORT_CLASS(name) extern CLASS *name##_class
 
 typedef enum {SM_FBS=0, SM_GS=1, SM_NR=2} SOLVERMETHOD;		/**< powerflow solver methodology */
-typedef enum {MM_SUPERLU=0, MM_EXTERN=1} MATRIXSOLVERMETHOD;	/**< NR matrix solver methodlogy */
+typedef enum {MM_SUPERLU=0, MM_EXTERN=1, MM_KLU=2} MATRIXSOLVERMETHOD;	/**< NR matrix solver methodlogy */
 typedef enum {
 	MD_NONE=0,			///< No matrix dump desired
 	MD_ONCE=1,			///< Single matrix dump desired
@@ -71,6 +71,7 @@ GLOBAL int64 NR_iteration_limit INIT(500);			/**< Newton-Raphson iteration limit
 GLOBAL bool NR_dyn_first_run INIT(true);			/**< Newton-Raphson first run indicator - used by deltamode functionality for initialization powerflow */
 GLOBAL bool NR_admit_change INIT(true);				/**< Newton-Raphson admittance matrix change detector - used to prevent complete recalculation of admittance at every timestep */
 GLOBAL int NR_superLU_procs INIT(1);				/**< Newton-Raphson related - superLU MT processor count to request - separate from thread_count */
+GLOBAL int NR_island_procs INIT(0);				/**< Newton-Raphson related - threads the KLU solver uses for independent islands - 0 uses thread_count */
 GLOBAL TIMESTAMP NR_retval INIT(TS_NEVER);			/**< Newton-Raphson current return value - if t0 objects know we aren't going anywhere */
 GLOBAL OBJECT *NR_swing_bus INIT(NULL);				/**< Newton-Raphson swing bus */
 GLOBAL int NR_swing_bus_reference INIT(-1);			/**< Newton-Raphson swing bus index reference in NR_busdata */
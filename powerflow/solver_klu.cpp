@@ -0,0 +1,1011 @@
+/* $Id
+ * Built-in sparse LU solver for the Newton-Raphson method
+ *
+ * See solver_klu.h for a description of the method.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "powerflow.h"
+#include "solver_klu.h"
+
+//Relative pivot tolerance - a diagonal pivot is kept if it is at least this fraction of the largest candidate
+#define KLU_PIVOT_TOL 0.001
+
+//Allocate on the GLD heap, or complain
+static void *klu_alloc(size_t size)
+{
+	void *ptr = gl_malloc(size>0 ? size : 1);
+
+	if (ptr == NULL)
+	{
+		GL_THROW("NR: One of the KLU solver matrices failed to allocate");
+		/*  TROUBLESHOOT
+		While attempting to allocate the memory for one of the built-in KLU solver working matrices,
+		an error was encountered and it was not allocated.  Please try again.  If it fails
+		again, please submit your code and a bug report using the trac website.
+		*/
+	}
+
+	return ptr;
+}
+
+//Free a GLD heap pointer and null it
+static void klu_release(void **ptr)
+{
+	if (*ptr != NULL)
+	{
+		gl_free(*ptr);
+		*ptr = NULL;
+	}
+}
+
+//Enlarge the L or U storage, keeping the first used entries
+static void klu_grow(int **index, double **value, unsigned int *maxsize, unsigned int used, unsigned int needed)
+{
+	int *new_index;
+	double *new_value;
+	unsigned int new_size;
+
+	if (needed <= *maxsize)
+		return;
+
+	new_size = 2*(*maxsize) + needed;
+	new_index = (int *)klu_alloc(new_size*sizeof(int));
+	new_value = (double *)klu_alloc(new_size*sizeof(double));
+
+	if (used > 0)
+	{
+		memcpy(new_index,*index,used*sizeof(int));
+		memcpy(new_value,*value,used*sizeof(double));
+	}
+
+	klu_release((void **)index);
+	klu_release((void **)value);
+
+	*index = new_index;
+	*value = new_value;
+	*maxsize = new_size;
+}
+
+static int klu_int_compare(const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+//Minimum degree ordering of the pattern of A+A' - Q receives the elimination order
+static void klu_order(KLU_SOLVER_VARS *klu)
+{
+	unsigned int n = klu->n;
+	int **adj;
+	unsigned int *len, *cap;
+	int *head, *next, *prev, *buf;
+	unsigned int indexer, k, mindeg;
+	int p, q, col, row, node, nbr;
+
+	adj = (int **)klu_alloc(n*sizeof(int *));
+	len = (unsigned int *)klu_alloc(n*sizeof(unsigned int));
+	cap = (unsigned int *)klu_alloc(n*sizeof(unsigned int));
+	head = (int *)klu_alloc(n*sizeof(int));
+	next = (int *)klu_alloc(n*sizeof(int));
+	prev = (int *)klu_alloc(n*sizeof(int));
+	buf = (int *)klu_alloc(n*sizeof(int));
+
+	//Count the off-diagonal entries of A+A' (duplicates are removed below)
+	memset(cap,0,n*sizeof(unsigned int));
+	for (col=0; col<(int)n; col++)
+	{
+		for (p=klu->Ap[col]; p<klu->Ap[col+1]; p++)
+		{
+			row = klu->Ai[p];
+			if (row != col)
+			{
+				cap[row]++;
+				cap[col]++;
+			}
+		}
+	}
+
+	for (indexer=0; indexer<n; indexer++)
+	{
+		adj[indexer] = (int *)klu_alloc(cap[indexer]*sizeof(int));
+		len[indexer] = 0;
+	}
+
+	for (col=0; col<(int)n; col++)
+	{
+		for (p=klu->Ap[col]; p<klu->Ap[col+1]; p++)
+		{
+			row = klu->Ai[p];
+			if (row != col)
+			{
+				adj[row][len[row]++] = col;
+				adj[col][len[col]++] = row;
+			}
+		}
+	}
+
+	//Sort the adjacency lists and drop duplicates
+	for (indexer=0; indexer<n; indexer++)
+	{
+		qsort(adj[indexer],len[indexer],sizeof(int),klu_int_compare);
+		for (k=0, q=0; k<len[indexer]; k++)
+		{
+			if ((q == 0) || (adj[indexer][q-1] != adj[indexer][k]))
+				adj[indexer][q++] = adj[indexer][k];
+		}
+		len[indexer] = q;
+	}
+
+	//Put the nodes in degree buckets
+	for (indexer=0; indexer<n; indexer++)
+		head[indexer] = -1;
+
+	for (indexer=n; indexer>0; indexer--)
+	{
+		node = indexer-1;
+		prev[node] = -1;
+		next[node] = head[len[node]];
+		if (next[node] >= 0)
+			prev[next[node]] = node;
+		head[len[node]] = node;
+	}
+
+	//Eliminate the nodes in order of degree
+	mindeg = 0;
+	for (k=0; k<n; k++)
+	{
+		while (head[mindeg] < 0)
+			mindeg++;
+
+		//Pull the first node of the lowest bucket
+		node = head[mindeg];
+		head[mindeg] = next[node];
+		if (next[node] >= 0)
+			prev[next[node]] = -1;
+
+		klu->Q[k] = node;
+
+		//Its neighbors become a clique
+		for (indexer=0; indexer<len[node]; indexer++)
+		{
+			unsigned int a_ind, b_ind, count;
+
+			nbr = adj[node][indexer];
+
+			//Remove the neighbor from its bucket
+			if (prev[nbr] >= 0)
+				next[prev[nbr]] = next[nbr];
+			else
+				head[len[nbr]] = next[nbr];
+			if (next[nbr] >= 0)
+				prev[next[nbr]] = prev[nbr];
+
+			//Merge the two sorted lists, leaving out the neighbor and the eliminated node
+			a_ind = 0;
+			b_ind = 0;
+			count = 0;
+			while ((a_ind < len[nbr]) || (b_ind < len[node]))
+			{
+				if ((b_ind >= len[node]) || ((a_ind < len[nbr]) && (adj[nbr][a_ind] < adj[node][b_ind])))
+					q = adj[nbr][a_ind++];
+				else if ((a_ind >= len[nbr]) || (adj[node][b_ind] < adj[nbr][a_ind]))
+					q = adj[node][b_ind++];
+				else
+				{
+					q = adj[nbr][a_ind++];
+					b_ind++;
+				}
+
+				if ((q != nbr) && (q != node))
+					buf[count++] = q;
+			}
+
+			if (count > cap[nbr])
+			{
+				gl_free(adj[nbr]);
+				cap[nbr] = 2*count;
+				adj[nbr] = (int *)klu_alloc(cap[nbr]*sizeof(int));
+			}
+			memcpy(adj[nbr],buf,count*sizeof(int));
+			len[nbr] = count;
+
+			//Put it back with its new degree
+			prev[nbr] = -1;
+			next[nbr] = head[count];
+			if (next[nbr] >= 0)
+				prev[next[nbr]] = nbr;
+			head[count] = nbr;
+
+			if (count < mindeg)
+				mindeg = count;
+		}
+
+		//Done with this one
+		gl_free(adj[node]);
+		adj[node] = NULL;
+		len[node] = 0;
+	}
+
+	gl_free(adj);
+	gl_free(len);
+	gl_free(cap);
+	gl_free(head);
+	gl_free(next);
+	gl_free(prev);
+	gl_free(buf);
+}
+
+//Save the pattern and compute the ordering
+static void klu_analyze(KLU_SOLVER_VARS *klu, unsigned int n, int *Ap, int *Ai)
+{
+	unsigned int nnz = Ap[n];
+
+	klu_solver_free(klu);
+
+	klu->n = n;
+	klu->nnz = nnz;
+
+	klu->Ap = (int *)klu_alloc((n+1)*sizeof(int));
+	klu->Ai = (int *)klu_alloc(nnz*sizeof(int));
+	memcpy(klu->Ap,Ap,(n+1)*sizeof(int));
+	memcpy(klu->Ai,Ai,nnz*sizeof(int));
+
+	klu->Q = (int *)klu_alloc(n*sizeof(int));
+	klu->pinv = (int *)klu_alloc(n*sizeof(int));
+	klu->Lp = (int *)klu_alloc((n+1)*sizeof(int));
+	klu->Up = (int *)klu_alloc((n+1)*sizeof(int));
+	klu->x = (double *)klu_alloc(n*sizeof(double));
+	klu->xi = (int *)klu_alloc(2*n*sizeof(int));
+	klu->mark = (int *)klu_alloc(n*sizeof(int));
+
+	klu_order(klu);
+
+	klu->analyze_count++;
+}
+
+//Depth-first search of the graph of L from row j - returns the new top of the reach
+static int klu_dfs(KLU_SOLVER_VARS *klu, int j, int top, int stamp)
+{
+	int *xi = klu->xi;
+	int *pstack = klu->xi + klu->n;
+	int head = 0;
+	int i, p, p2, jnew;
+	bool done;
+
+	xi[0] = j;
+	while (head >= 0)
+	{
+		j = xi[head];
+		jnew = klu->pinv[j];
+
+		if (klu->mark[j] != stamp)
+		{
+			klu->mark[j] = stamp;
+			pstack[head] = (jnew < 0) ? 0 : klu->Lp[jnew];
+		}
+
+		done = true;
+		p2 = (jnew < 0) ? 0 : klu->Lp[jnew+1];
+		for (p=pstack[head]; p<p2; p++)
+		{
+			i = klu->Li[p];
+			if (klu->mark[i] == stamp)
+				continue;
+
+			//Go deeper
+			pstack[head] = p;
+			xi[++head] = i;
+			done = false;
+			break;
+		}
+
+		if (done)
+		{
+			head--;
+			xi[--top] = j;
+		}
+	}
+
+	return top;
+}
+
+//Left-looking LU with partial pivoting on the ordered columns - returns 0 or the 1-based singular column
+static int klu_factor(KLU_SOLVER_VARS *klu, double *Ax)
+{
+	unsigned int n = klu->n;
+	double *x = klu->x;
+	int *xi = klu->xi;
+	unsigned int lnz, unz, k;
+	int col, top, p, px, i, j, jnew, ipiv;
+	double a, t, pivot;
+
+	//Initial guess at the factor size
+	klu_grow(&klu->Li,&klu->Lx,&klu->Lmax,0,4*klu->nnz + n);
+	klu_grow(&klu->Ui,&klu->Ux,&klu->Umax,0,4*klu->nnz + n);
+
+	for (k=0; k<n; k++)
+	{
+		x[k] = 0.0;
+		klu->pinv[k] = -1;
+		klu->mark[k] = -1;
+	}
+
+	klu->factored = false;
+	lnz = 0;
+	unz = 0;
+
+	for (k=0; k<n; k++)
+	{
+		klu->Lp[k] = lnz;
+		klu->Up[k] = unz;
+
+		//Make sure the worst case fits
+		klu_grow(&klu->Li,&klu->Lx,&klu->Lmax,lnz,lnz + n);
+		klu_grow(&klu->Ui,&klu->Ux,&klu->Umax,unz,unz + n);
+
+		col = klu->Q[k];
+
+		//Find the pattern of this column of L\A
+		top = n;
+		for (p=klu->Ap[col]; p<klu->Ap[col+1]; p++)
+		{
+			if (klu->mark[klu->Ai[p]] != (int)k)
+				top = klu_dfs(klu,klu->Ai[p],top,k);
+		}
+
+		//Sparse triangular solve
+		for (p=top; p<(int)n; p++)
+			x[xi[p]] = 0.0;
+
+		for (p=klu->Ap[col]; p<klu->Ap[col+1]; p++)
+			x[klu->Ai[p]] = Ax[p];
+
+		for (px=top; px<(int)n; px++)
+		{
+			j = xi[px];
+			jnew = klu->pinv[j];
+			if (jnew < 0)
+				continue;
+
+			for (p=klu->Lp[jnew]+1; p<klu->Lp[jnew+1]; p++)
+				x[klu->Li[p]] -= klu->Lx[p]*x[j];
+		}
+
+		//Find the pivot - U entries are stored in topological order
+		ipiv = -1;
+		a = -1.0;
+		for (p=top; p<(int)n; p++)
+		{
+			i = xi[p];
+			if (klu->pinv[i] < 0)
+			{
+				t = fabs(x[i]);
+				if (t > a)
+				{
+					a = t;
+					ipiv = i;
+				}
+			}
+			else
+			{
+				klu->Ui[unz] = klu->pinv[i];
+				klu->Ux[unz++] = x[i];
+			}
+		}
+
+		if ((ipiv < 0) || !(a > 0.0))
+			return k+1;
+
+		//Prefer the diagonal
+		if ((klu->pinv[col] < 0) && (fabs(x[col]) >= a*KLU_PIVOT_TOL))
+			ipiv = col;
+
+		pivot = x[ipiv];
+		klu->Ui[unz] = k;
+		klu->Ux[unz++] = pivot;
+		klu->pinv[ipiv] = k;
+		klu->Li[lnz] = ipiv;
+		klu->Lx[lnz++] = 1.0;
+
+		for (p=top; p<(int)n; p++)
+		{
+			i = xi[p];
+			if (klu->pinv[i] < 0)
+			{
+				klu->Li[lnz] = i;
+				klu->Lx[lnz++] = x[i]/pivot;
+			}
+			x[i] = 0.0;
+		}
+	}
+
+	klu->Lp[n] = lnz;
+	klu->Up[n] = unz;
+
+	//Put L in pivot order so the refactorization and solve work in one index space
+	for (p=0; p<(int)lnz; p++)
+		klu->Li[p] = klu->pinv[klu->Li[p]];
+
+	klu->factored = true;
+	klu->factor_count++;
+
+	return 0;
+}
+
+//Numeric refactorization with the previous pivots - returns false if a pivot is no longer acceptable
+static bool klu_refactor(KLU_SOLVER_VARS *klu, double *Ax)
+{
+	unsigned int n = klu->n;
+	double *x = klu->x;
+	unsigned int k;
+	int col, p, q, j, udiag;
+	double xj, a, pivot;
+
+	for (k=0; k<n; k++)
+	{
+		col = klu->Q[k];
+		udiag = klu->Up[k+1]-1;
+
+		//Clear and scatter the column
+		for (p=klu->Up[k]; p<=udiag; p++)
+			x[klu->Ui[p]] = 0.0;
+
+		for (p=klu->Lp[k]; p<klu->Lp[k+1]; p++)
+			x[klu->Li[p]] = 0.0;
+
+		for (p=klu->Ap[col]; p<klu->Ap[col+1]; p++)
+			x[klu->pinv[klu->Ai[p]]] = Ax[p];
+
+		//Apply the previous columns
+		for (p=klu->Up[k]; p<udiag; p++)
+		{
+			j = klu->Ui[p];
+			xj = x[j];
+			klu->Ux[p] = xj;
+
+			for (q=klu->Lp[j]+1; q<klu->Lp[j+1]; q++)
+				x[klu->Li[q]] -= klu->Lx[q]*xj;
+		}
+
+		//Check the pivot against the rest of the column
+		pivot = x[k];
+		a = 0.0;
+		for (q=klu->Lp[k]+1; q<klu->Lp[k+1]; q++)
+		{
+			if (fabs(x[klu->Li[q]]) > a)
+				a = fabs(x[klu->Li[q]]);
+		}
+
+		if (!(fabs(pivot) > 0.0) || (fabs(pivot) < a*KLU_PIVOT_TOL))
+			return false;
+
+		klu->Ux[udiag] = pivot;
+		for (q=klu->Lp[k]+1; q<klu->Lp[k+1]; q++)
+			klu->Lx[q] = x[klu->Li[q]]/pivot;
+	}
+
+	klu->refactor_count++;
+
+	return true;
+}
+
+/** Factor the n x n matrix given in compressed column form
+
+	The analysis and the pivots of the previous call are reused when the
+	pattern has not changed.
+
+	@return 0 on success, or k>0 if the matrix is singular at column k
+ **/
+int klu_solver_factor(KLU_SOLVER_VARS *klu, unsigned int n, int *Ap, int *Ai, double *Ax)
+{
+	//See if the pattern changed
+	if ((klu->Ap == NULL) || (klu->n != n) || (klu->nnz != (unsigned int)Ap[n])
+		|| (memcmp(klu->Ap,Ap,(n+1)*sizeof(int)) != 0)
+		|| (memcmp(klu->Ai,Ai,Ap[n]*sizeof(int)) != 0))
+	{
+		klu_analyze(klu,n,Ap,Ai);
+	}
+	else if (klu->factored)
+	{
+		if (klu_refactor(klu,Ax))
+			return 0;
+
+		gl_verbose("NR: KLU pivot became too small, refactoring with new pivots");
+	}
+
+	return klu_factor(klu,Ax);
+}
+
+/** Solve Ax=b in place with the current factors
+ **/
+void klu_solver_solve(KLU_SOLVER_VARS *klu, double *b)
+{
+	unsigned int n = klu->n;
+	double *x = klu->x;
+	unsigned int k;
+	int j, p;
+
+	//Permute the rows
+	for (k=0; k<n; k++)
+		x[klu->pinv[k]] = b[k];
+
+	//Forward substitution - unit diagonal is first in each column
+	for (j=0; j<(int)n; j++)
+	{
+		for (p=klu->Lp[j]+1; p<klu->Lp[j+1]; p++)
+			x[klu->Li[p]] -= klu->Lx[p]*x[j];
+	}
+
+	//Backward substitution - diagonal is last in each column
+	for (j=n-1; j>=0; j--)
+	{
+		x[j] /= klu->Ux[klu->Up[j+1]-1];
+		for (p=klu->Up[j]; p<klu->Up[j+1]-1; p++)
+			x[klu->Ui[p]] -= klu->Ux[p]*x[j];
+	}
+
+	//Permute the columns back
+	for (k=0; k<n; k++)
+		b[klu->Q[k]] = x[k];
+}
+
+/** Release the analysis and the factors
+ **/
+void klu_solver_free(KLU_SOLVER_VARS *klu)
+{
+	klu_release((void **)&klu->Ap);
+	klu_release((void **)&klu->Ai);
+	klu_release((void **)&klu->Q);
+	klu_release((void **)&klu->pinv);
+	klu_release((void **)&klu->Lp);
+	klu_release((void **)&klu->Li);
+	klu_release((void **)&klu->Lx);
+	klu_release((void **)&klu->Up);
+	klu_release((void **)&klu->Ui);
+	klu_release((void **)&klu->Ux);
+	klu_release((void **)&klu->x);
+	klu_release((void **)&klu->xi);
+	klu_release((void **)&klu->mark);
+
+	klu->n = 0;
+	klu->nnz = 0;
+	klu->Lmax = 0;
+	klu->Umax = 0;
+	klu->factored = false;
+}
+
+//Find the root of a node in the island forest, halving the path on the way
+static int klu_island_root(int *parent, int i)
+{
+	while (parent[i] != i)
+	{
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+
+	return i;
+}
+
+typedef struct {
+	unsigned int size;
+	unsigned int label;
+} KLU_ISLAND_ORDER;
+
+//Sort islands largest first, then in order of their first row
+static int klu_island_compare(const void *a, const void *b)
+{
+	const KLU_ISLAND_ORDER *ia = (const KLU_ISLAND_ORDER *)a;
+	const KLU_ISLAND_ORDER *ib = (const KLU_ISLAND_ORDER *)b;
+
+	if (ia->size != ib->size)
+		return (ia->size > ib->size) ? -1 : 1;
+
+	return (ia->label < ib->label) ? -1 : ((ia->label > ib->label) ? 1 : 0);
+}
+
+//Release the islands, but leave the threads alone
+static void klu_islands_clear(KLU_ISLAND_VARS *isl)
+{
+	unsigned int k;
+
+	if (isl->island != NULL)
+	{
+		for (k=0; k<isl->n_islands; k++)
+		{
+			klu_release((void **)&isl->island[k].Ap);
+			klu_release((void **)&isl->island[k].Ai);
+			klu_release((void **)&isl->island[k].Ax);
+			klu_release((void **)&isl->island[k].src);
+			klu_release((void **)&isl->island[k].rows);
+			klu_release((void **)&isl->island[k].b);
+			klu_solver_free(&isl->island[k].klu);
+		}
+
+		klu_release((void **)&isl->island);
+	}
+
+	klu_release((void **)&isl->Ap);
+	klu_release((void **)&isl->Ai);
+
+	isl->n = 0;
+	isl->nnz = 0;
+	isl->n_islands = 0;
+}
+
+//Split the pattern into its connected components and set up the island matrices
+static void klu_islands_build(KLU_ISLAND_VARS *isl, unsigned int n, int *Ap, int *Ai)
+{
+	unsigned int nnz = Ap[n];
+	unsigned int i, j, k, n_islands;
+	int p, ri, rj;
+	int *parent, *label, *local, *slot;
+	KLU_ISLAND_ORDER *order;
+	KLU_ISLAND *island;
+
+	klu_islands_clear(isl);
+
+	isl->n = n;
+	isl->nnz = nnz;
+	isl->Ap = (int *)klu_alloc((n+1)*sizeof(int));
+	isl->Ai = (int *)klu_alloc(nnz*sizeof(int));
+	memcpy(isl->Ap,Ap,(n+1)*sizeof(int));
+	memcpy(isl->Ai,Ai,nnz*sizeof(int));
+
+	parent = (int *)klu_alloc(n*sizeof(int));
+	label = (int *)klu_alloc(n*sizeof(int));
+	local = (int *)klu_alloc(n*sizeof(int));
+
+	//Join the row and column of every entry
+	for (i=0; i<n; i++)
+		parent[i] = i;
+
+	for (j=0; j<n; j++)
+	{
+		for (p=Ap[j]; p<Ap[j+1]; p++)
+		{
+			ri = klu_island_root(parent,Ai[p]);
+			rj = klu_island_root(parent,j);
+
+			if (ri != rj)
+			{
+				if (ri < rj)
+					parent[rj] = ri;
+				else
+					parent[ri] = rj;
+			}
+		}
+	}
+
+	//Number the islands in order of their first row
+	n_islands = 0;
+	for (i=0; i<n; i++)
+	{
+		ri = klu_island_root(parent,i);
+		if (ri == (int)i)
+			label[i] = n_islands++;
+		else
+			label[i] = label[ri];
+	}
+
+	isl->n_islands = n_islands;
+	isl->island = (KLU_ISLAND *)klu_alloc(n_islands*sizeof(KLU_ISLAND));
+	memset(isl->island,0,n_islands*sizeof(KLU_ISLAND));
+
+	//A connected matrix is factored as a whole
+	if (n_islands == 1)
+	{
+		gl_free(parent);
+		gl_free(label);
+		gl_free(local);
+		return;
+	}
+
+	//Put the largest islands first so they start first
+	order = (KLU_ISLAND_ORDER *)klu_alloc(n_islands*sizeof(KLU_ISLAND_ORDER));
+	slot = (int *)klu_alloc(n_islands*sizeof(int));
+
+	for (k=0; k<n_islands; k++)
+	{
+		order[k].size = 0;
+		order[k].label = k;
+	}
+
+	for (j=0; j<n; j++)
+		order[label[j]].size += Ap[j+1] - Ap[j];
+
+	qsort(order,n_islands,sizeof(KLU_ISLAND_ORDER),klu_island_compare);
+
+	for (k=0; k<n_islands; k++)
+		slot[order[k].label] = k;
+
+	//Size the islands - local indices follow the full matrix order, so the rows stay sorted
+	for (j=0; j<n; j++)
+	{
+		island = &isl->island[slot[label[j]]];
+		local[j] = island->n++;
+		island->nnz += Ap[j+1] - Ap[j];
+	}
+
+	for (k=0; k<n_islands; k++)
+	{
+		island = &isl->island[k];
+		island->Ap = (int *)klu_alloc((island->n+1)*sizeof(int));
+		island->Ai = (int *)klu_alloc(island->nnz*sizeof(int));
+		island->Ax = (double *)klu_alloc(island->nnz*sizeof(double));
+		island->src = (int *)klu_alloc(island->nnz*sizeof(int));
+		island->rows = (int *)klu_alloc(island->n*sizeof(int));
+		island->b = (double *)klu_alloc(island->n*sizeof(double));
+		island->Ap[0] = 0;
+		island->info = 0;
+	}
+
+	//Copy the pattern over
+	for (j=0; j<n; j++)
+	{
+		island = &isl->island[slot[label[j]]];
+		k = local[j];
+		island->rows[k] = j;
+		island->Ap[k+1] = island->Ap[k] + (Ap[j+1] - Ap[j]);
+
+		for (p=Ap[j]; p<Ap[j+1]; p++)
+		{
+			island->Ai[island->Ap[k] + (p - Ap[j])] = local[Ai[p]];
+			island->src[island->Ap[k] + (p - Ap[j])] = p;
+		}
+	}
+
+	gl_verbose("NR: KLU solver found %d independent islands in the %d x %d matrix",n_islands,n,n);
+
+	gl_free(order);
+	gl_free(slot);
+	gl_free(parent);
+	gl_free(label);
+	gl_free(local);
+}
+
+//Solve an island with the factors already in place
+static void klu_island_solve(KLU_ISLAND *island, double *b)
+{
+	unsigned int k;
+
+	for (k=0; k<island->n; k++)
+		island->b[k] = b[island->rows[k]];
+
+	klu_solver_solve(&island->klu,island->b);
+
+	for (k=0; k<island->n; k++)
+		b[island->rows[k]] = island->b[k];
+}
+
+//Refactor and solve the islands that can keep their pivots - nothing here may allocate or throw
+static void klu_islands_work(KLU_ISLAND_VARS *isl)
+{
+	unsigned int k, count;
+	double *Ax, *b;
+	KLU_ISLAND *island;
+	int p;
+
+	for (;;)
+	{
+		pthread_mutex_lock(&isl->lock);
+		k = isl->next_island++;
+		count = isl->n_islands;
+		Ax = isl->job_Ax;
+		b = isl->job_b;
+		pthread_mutex_unlock(&isl->lock);
+
+		if (k >= count)
+			break;
+
+		island = &isl->island[k];
+
+		for (p=0; p<(int)island->nnz; p++)
+			island->Ax[p] = Ax[island->src[p]];
+
+		if (island->klu.factored && klu_refactor(&island->klu,island->Ax))
+		{
+			klu_island_solve(island,b);
+			island->info = 0;
+		}
+		else
+			island->info = -1;	//Left for the calling thread
+
+		pthread_mutex_lock(&isl->lock);
+		isl->finished++;
+		if (isl->finished == count)
+			pthread_cond_signal(&isl->done);
+		pthread_mutex_unlock(&isl->lock);
+	}
+}
+
+//Helper thread main loop
+static void *klu_islands_thread(void *arg)
+{
+	KLU_ISLAND_VARS *isl = (KLU_ISLAND_VARS *)arg;
+	unsigned int seen;
+
+	pthread_mutex_lock(&isl->lock);
+	seen = isl->generation;
+	for (;;)
+	{
+		while (!isl->stop && (isl->generation == seen))
+			pthread_cond_wait(&isl->start,&isl->lock);
+
+		if (isl->stop)
+			break;
+
+		seen = isl->generation;
+		pthread_mutex_unlock(&isl->lock);
+
+		klu_islands_work(isl);
+
+		pthread_mutex_lock(&isl->lock);
+	}
+	pthread_mutex_unlock(&isl->lock);
+
+	return NULL;
+}
+
+//Stop the helper threads
+static void klu_islands_stop(KLU_ISLAND_VARS *isl)
+{
+	unsigned int k;
+
+	if (isl->thread == NULL)
+		return;
+
+	pthread_mutex_lock(&isl->lock);
+	isl->stop = true;
+	pthread_cond_broadcast(&isl->start);
+	pthread_mutex_unlock(&isl->lock);
+
+	for (k=0; k<isl->n_threads; k++)
+		pthread_join(isl->thread[k],NULL);
+
+	klu_release((void **)&isl->thread);
+	isl->n_threads = 0;
+	isl->stop = false;
+}
+
+//Make sure the number of helper threads matches the request
+static void klu_islands_start(KLU_ISLAND_VARS *isl, unsigned int n_helpers)
+{
+	unsigned int k;
+
+	if ((isl->thread != NULL) && (isl->n_threads == n_helpers))
+		return;
+
+	klu_islands_stop(isl);
+
+	if (n_helpers == 0)
+		return;
+
+	isl->thread = (pthread_t *)klu_alloc(n_helpers*sizeof(pthread_t));
+	isl->stop = false;
+
+	for (k=0; k<n_helpers; k++)
+	{
+		if (pthread_create(&isl->thread[k],NULL,klu_islands_thread,isl) != 0)
+		{
+			gl_warning("NR: unable to start all of the KLU island threads, using %d",k);
+			/*  TROUBLESHOOT
+			The built-in KLU solver could not create as many threads as requested to
+			solve the islands of the system.  The islands will be solved by fewer threads,
+			which gives the same result but may be slower.  Reduce powerflow::NR_island_procs
+			or free up system resources.
+			*/
+			break;
+		}
+	}
+
+	isl->n_threads = k;
+}
+
+/** Factor and solve Ax=b in place, island by island
+
+	The matrix is split into the independent blocks of its pattern, and the
+	blocks are refactored and solved concurrently by up to n_threads threads
+	(including the calling thread).  The split is only redone when the
+	pattern changes.
+
+	@return 0 on success, or k>0 if the matrix is singular at column k
+ **/
+int klu_islands_solve(KLU_ISLAND_VARS *isl, unsigned int n, int *Ap, int *Ai, double *Ax, double *b, unsigned int n_threads)
+{
+	unsigned int k, n_helpers;
+	int info, col;
+	KLU_ISLAND *island;
+
+	//See if the pattern changed
+	if ((isl->Ap == NULL) || (isl->n != n) || (isl->nnz != (unsigned int)Ap[n])
+		|| (memcmp(isl->Ap,Ap,(n+1)*sizeof(int)) != 0)
+		|| (memcmp(isl->Ai,Ai,Ap[n]*sizeof(int)) != 0))
+	{
+		klu_islands_build(isl,n,Ap,Ai);
+	}
+
+	//One island - no need to split anything
+	if (isl->n_islands == 1)
+	{
+		info = klu_solver_factor(&isl->island[0].klu,n,Ap,Ai,Ax);
+		if (info == 0)
+			klu_solver_solve(&isl->island[0].klu,b);
+
+		return info;
+	}
+
+	n_helpers = (n_threads < isl->n_islands) ? n_threads : isl->n_islands;
+	n_helpers = (n_helpers > 1) ? (n_helpers - 1) : 0;
+
+	if (!isl->sync_ready)
+	{
+		pthread_mutex_init(&isl->lock,NULL);
+		pthread_cond_init(&isl->start,NULL);
+		pthread_cond_init(&isl->done,NULL);
+		isl->sync_ready = true;
+	}
+
+	klu_islands_start(isl,n_helpers);
+
+	//Hand out the islands and take part
+	pthread_mutex_lock(&isl->lock);
+	isl->job_Ax = Ax;
+	isl->job_b = b;
+	isl->next_island = 0;
+	isl->finished = 0;
+	isl->generation++;
+	if (isl->n_threads > 0)
+		pthread_cond_broadcast(&isl->start);
+	pthread_mutex_unlock(&isl->lock);
+
+	klu_islands_work(isl);
+
+	pthread_mutex_lock(&isl->lock);
+	while (isl->finished < isl->n_islands)
+		pthread_cond_wait(&isl->done,&isl->lock);
+	pthread_mutex_unlock(&isl->lock);
+
+	//Islands that need a new analysis or new pivots are done here, where allocation is safe
+	info = 0;
+	for (k=0; k<isl->n_islands; k++)
+	{
+		island = &isl->island[k];
+
+		if (island->info < 0)
+		{
+			island->info = klu_solver_factor(&island->klu,island->n,island->Ap,island->Ai,island->Ax);
+
+			if (island->info == 0)
+				klu_island_solve(island,b);
+		}
+
+		//Report the lowest singular column of the full matrix
+		if (island->info > 0)
+		{
+			col = island->rows[island->info-1] + 1;
+			if ((info == 0) || (col < info))
+				info = col;
+		}
+	}
+
+	return info;
+}
+
+/** Stop the island threads and release the islands
+ **/
+void klu_islands_free(KLU_ISLAND_VARS *isl)
+{
+	klu_islands_stop(isl);
+	klu_islands_clear(isl);
+
+	if (isl->sync_ready)
+	{
+		pthread_mutex_destroy(&isl->lock);
+		pthread_cond_destroy(&isl->start);
+		pthread_cond_destroy(&isl->done);
+		isl->sync_ready = false;
+	}
+}
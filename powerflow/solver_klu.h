@@ -0,0 +1,90 @@
+/* $Id
+ * Built-in sparse LU solver for the Newton-Raphson method
+ *
+ * The solver follows the approach of KLU: the columns are ordered once
+ * by minimum degree on the pattern of A+A', and the matrix is factored by
+ * a left-looking sparse LU with partial pivoting that prefers the diagonal.
+ * The ordering, the pivot sequence and the patterns of L and U are kept
+ * between calls, so when the next matrix has the same pattern (the usual
+ * case between NR iterations and timesteps) only a numeric refactorization
+ * is needed.  A full factorization is only repeated when the pattern
+ * changes or when a reused pivot becomes too small.
+ *
+ * A matrix that falls apart into independent blocks (islands created by
+ * faults or switching, or separate feeders in one model) can be solved
+ * island by island.  Each island keeps its own analysis and factors, and
+ * the islands are factored and solved concurrently by a small pool of
+ * threads.  The results do not depend on the number of threads.
+ */
+
+#ifndef _SOLVER_KLU
+#define _SOLVER_KLU
+
+#include <pthread.h>
+
+typedef struct {
+	unsigned int n;			///< size of the analyzed matrix
+	unsigned int nnz;		///< number of non-zeros of the analyzed matrix
+	int *Ap;				///< column pointers of the analyzed pattern
+	int *Ai;				///< row indices of the analyzed pattern
+	int *Q;					///< fill-reducing column ordering
+	int *pinv;				///< row permutation - pivot position of each row
+	int *Lp;				///< column pointers of L
+	int *Li;				///< row indices of L (pivot order, unit diagonal first)
+	double *Lx;				///< values of L
+	unsigned int Lmax;		///< allocated size of Li/Lx
+	int *Up;				///< column pointers of U
+	int *Ui;				///< row indices of U (topological order, diagonal last)
+	double *Ux;				///< values of U
+	unsigned int Umax;		///< allocated size of Ui/Ux
+	double *x;				///< dense work vector
+	int *xi;				///< work vector for the reach - 2*n
+	int *mark;				///< visit marks for the reach
+	bool factored;			///< flag indicating the factors are valid for the analyzed pattern
+	unsigned int analyze_count;		///< number of symbolic analyses performed
+	unsigned int factor_count;		///< number of full factorizations performed
+	unsigned int refactor_count;	///< number of numeric refactorizations performed
+} KLU_SOLVER_VARS;
+
+typedef struct {
+	unsigned int n;			///< size of the island
+	unsigned int nnz;		///< number of non-zeros of the island
+	int *Ap;				///< column pointers of the island matrix
+	int *Ai;				///< row indices of the island matrix
+	double *Ax;				///< values of the island matrix
+	int *src;				///< position of each island value in the full matrix
+	int *rows;				///< full matrix row/column of each island row/column
+	double *b;				///< island right-hand side
+	int info;				///< result of the last factorization
+	KLU_SOLVER_VARS klu;	///< island factors
+} KLU_ISLAND;
+
+typedef struct {
+	unsigned int n;			///< size of the full matrix the islands were found for
+	unsigned int nnz;		///< number of non-zeros of the full matrix
+	int *Ap;				///< column pointers of the full matrix pattern
+	int *Ai;				///< row indices of the full matrix pattern
+	unsigned int n_islands;	///< number of islands
+	KLU_ISLAND *island;		///< islands, largest first
+	unsigned int n_threads;	///< number of helper threads running
+	pthread_t *thread;		///< helper threads
+	pthread_mutex_t lock;	///< lock for the job and the conditions
+	pthread_cond_t start;	///< signals a new job
+	pthread_cond_t done;	///< signals the last island is done
+	bool sync_ready;		///< flag indicating the lock and the conditions are initialized
+	unsigned int generation;	///< job counter
+	unsigned int next_island;	///< next island to take
+	unsigned int finished;	///< islands finished in the current job
+	bool stop;				///< flag to stop the helper threads
+	double *job_Ax;			///< full matrix values of the current job
+	double *job_b;			///< full right-hand side of the current job
+} KLU_ISLAND_VARS;
+
+int klu_solver_factor(KLU_SOLVER_VARS *klu, unsigned int n, int *Ap, int *Ai, double *Ax);
+void klu_solver_solve(KLU_SOLVER_VARS *klu, double *b);
+void klu_solver_free(KLU_SOLVER_VARS *klu);
+
+int klu_islands_solve(KLU_ISLAND_VARS *isl, unsigned int n, int *Ap, int *Ai, double *Ax, double *b, unsigned int n_threads);
+void klu_islands_free(KLU_ISLAND_VARS *isl);
+
+#endif
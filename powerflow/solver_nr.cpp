@@ -34,6 +34,7 @@ Initialization after returning to service?
 
 
 #include "solver_nr.h"
+#include "solver_klu.h"
 
 #define MT // this enables multithreaded SuperLU
 
@@ -56,169 +57,136 @@ SuperMatrix A_LU,B_LU;
 //External solver global
 void *ext_solver_glob_vars;
 
-//Initialize the sparse notation
-void sparse_init(SPARSE* sm, int nels, int ncols)
-{
-	int indexval;
-	
-	//Allocate the column pointer GLD heap
-	sm->cols = (SP_E**)gl_malloc(ncols*sizeof(SP_E*));
+//Built-in KLU solver variables - kept between calls so the analysis can be reused
+KLU_SOLVER_VARS klu_LU;
+KLU_ISLAND_VARS klu_islands;
 
-	//Check it
-	if (sm->cols == NULL)
-	{
-		GL_THROW("NR: Sparse matrix allocation failed");
-		/*  TROUBLESHOOT
-		While attempting to allocate space for one of the sparse matrix variables, an error was encountered.
-		Please try again.  If the error persists, please submit your code and a bug report via the ticketing system.
-		*/
-	}
-	else	//Zero it, for giggles
-	{
-		for (indexval=0; indexval<ncols; indexval++)
-		{
-			sm->cols[indexval] = NULL;
-		}
-	}
+//Number of threads the KLU solver may use for independent islands
+static unsigned int NR_island_threads(void)
+{
+	static int thread_count = -1;
+	char temp_buff[64];
 
-	//Allocate the elements on the GLD heap
-	sm->llheap = (SP_E*)gl_malloc(nels*sizeof(SP_E));
+	if (NR_island_procs > 0)
+		return NR_island_procs;
 
-	//Check it
-	if (sm->llheap == NULL)
-	{
-		GL_THROW("NR: Sparse matrix allocation failed");
-		//Defined above
-	}
-	else	//Zero it, for giggles
+	if (thread_count < 0)
 	{
-		for (indexval=0; indexval<nels; indexval++)
-		{
-			sm->llheap[indexval].next = NULL;
-			sm->llheap[indexval].row_ind = -1;	//Invalid, so it gets upset if we use this (intentional)
-			sm->llheap[indexval].value = 0.0;
-		}
+		thread_count = 1;
+		if (gl_global_getvar("threadcount",temp_buff,sizeof(temp_buff)) != NULL)
+			thread_count = atoi(temp_buff);
+
+		if (thread_count < 1)
+			thread_count = 1;
 	}
 
-	//Init others
-	sm->llptr = 0;
-	sm->ncols = ncols;
+	return thread_count;
 }
 
-//Free up/clear the sparse allocations
-void sparse_clear(SPARSE* sm)
+//Get an element of the Amatrix - off-diagonal elements first, then the fixed and the updated diagonal elements
+inline Y_NR *NR_Amatrix_element(NR_SOLVER_STRUCT *powerflow_values, unsigned int index)
 {
-	//Clear them up
-	gl_free(sm->llheap);
-	gl_free(sm->cols);
+	if (index < powerflow_values->size_offdiag_PQ*2)
+		return &(powerflow_values->Y_offdiag_PQ[index]);
 
-	//Null them, because I'm paranoid
-	sm->llheap = NULL;
-	sm->cols = NULL;
+	index -= powerflow_values->size_offdiag_PQ*2;
 
-	//Zero the last one
-	sm->ncols = 0;
+	if (index < powerflow_values->size_diag_fixed*2)
+		return &(powerflow_values->Y_diag_fixed[index]);
+
+	return &(powerflow_values->Y_diag_update[index - powerflow_values->size_diag_fixed*2]);
 }
 
-void sparse_reset(SPARSE* sm, int ncols)
+//Build the compressed column pattern of the Amatrix and the position of each element in it
+void sparse_pattern(NR_SOLVER_STRUCT *powerflow_values, NR_SOLVER_VARS *matrices_LU, unsigned int nels, unsigned int ncols)
 {
-	int indexval;
-
-	//Set the size
-	sm->ncols = ncols;
+	unsigned int *next_pos, *by_row;
+	unsigned int indexval, rowval, colval, posval;
+	Y_NR *element;
 
-	//Do brute force way, for paranoia
-	for (indexval=0; indexval<ncols; indexval++)
+	//Make sure the position map is big enough
+	if (nels > powerflow_values->max_size_Amatrix)
 	{
-		sm->cols[indexval] = NULL;
+		if (powerflow_values->Amatrix_slot != NULL)
+			gl_free(powerflow_values->Amatrix_slot);
+
+		powerflow_values->Amatrix_slot = (unsigned int *)gl_malloc(nels*sizeof(unsigned int));
+
+		//Make sure it worked
+		if (powerflow_values->Amatrix_slot == NULL)
+			GL_THROW("NR: Failed to allocate memory for one of the necessary matrices");
+			//Defined below
+
+		powerflow_values->max_size_Amatrix = nels;
 	}
-	
-	//Set the location pointer
-	sm->llptr = 0;
-}
 
-//Add in new elements to the sparse notation
-inline void sparse_add(SPARSE* sm, int row, int col, double value)
-{
-	SP_E* insertion_point = sm->cols[col];
-	SP_E* new_list_element = &(sm->llheap[sm->llptr++]);
+	//Working space - only needed when the topology changes
+	next_pos = (unsigned int *)gl_malloc((ncols+1)*sizeof(unsigned int));
+	by_row = (unsigned int *)gl_malloc((nels > 0 ? nels : 1)*sizeof(unsigned int));
 
-	new_list_element->next = NULL;
-	new_list_element->row_ind = row;
-	new_list_element->value = value;
+	if ((next_pos == NULL) || (by_row == NULL))
+	{
+		GL_THROW("NR: Sparse matrix allocation failed");
+		/*  TROUBLESHOOT
+		While attempting to allocate space for one of the sparse matrix variables, an error was encountered.
+		Please try again.  If the error persists, please submit your code and a bug report via the ticketing system.
+		*/
+	}
 
-	//if there's a non empty list, traverse to find our rightful insertion point
-	if(insertion_point != NULL)
+	//Count the elements of each row and column
+	for (indexval=0; indexval<=ncols; indexval++)
 	{
-		if(insertion_point->row_ind > new_list_element->row_ind)
-		{
-			//insert the new list element at the first position
-			new_list_element->next = insertion_point;
-			sm->cols[col] = new_list_element;
-		}
-		else
-		{
-			while((insertion_point->next != NULL) && (insertion_point->next->row_ind < new_list_element->row_ind))
-			{
-				insertion_point = insertion_point->next;
-			}
+		next_pos[indexval] = 0;
+		matrices_LU->cols_LU[indexval] = 0;
+	}
 
-			//Duplicate check -- see how we exited
-			if (insertion_point->next != NULL)	//We exited because the next element is GEQ to the new element
-			{
-				if (insertion_point->next->row_ind == new_list_element->row_ind)	//Same entry (by column), so bad
-				{
-					GL_THROW("NR: duplicate admittance entry found - check for parallel circuits between common nodes!");
-					/*  TROUBLESHOOT
-					While building up the admittance matrix for the Newton-Raphson solver, a duplicate entry was found.
-					This is often caused by having multiple lines on the same phases in parallel between two nodes.  Please
-					reconcile this model difference and try again.
-					*/
-				}
-			}
-			else	//No next item, so see if our value matches
-			{
-				if (insertion_point->row_ind == new_list_element->row_ind)	//Same entry (by column), so bad
-				{
-					GL_THROW("NR: duplicate admittance entry found - check for parallel circuits between common nodes!");
-					//Defined above
-				}
-			}
+	for (indexval=0; indexval<nels; indexval++)
+	{
+		element = NR_Amatrix_element(powerflow_values,indexval);
+		next_pos[element->row_ind+1]++;
+		matrices_LU->cols_LU[element->col_ind+1]++;
+	}
 
-			//insert the new list element at the next position
-			new_list_element->next = insertion_point->next;
-			insertion_point->next = new_list_element;
-		}
+	for (indexval=0; indexval<ncols; indexval++)
+	{
+		next_pos[indexval+1] += next_pos[indexval];
+		matrices_LU->cols_LU[indexval+1] += matrices_LU->cols_LU[indexval];
 	}
-	else
-		sm->cols[col] = new_list_element;
-}
 
-void sparse_tonr(SPARSE* sm, NR_SOLVER_VARS *matrices_LU)
-{
-	//traverse each linked list, which are in order, and copy values into new array
-	unsigned int rowidx = 0;
-	unsigned int colidx = 0;
-	unsigned int i;
-	SP_E* LL_pointer;
-
-	matrices_LU->cols_LU[0] = 0;
-	LL_pointer = NULL;
-	for(i = 0; i < sm->ncols; i++)
+	//Sort the elements by row
+	for (indexval=0; indexval<nels; indexval++)
 	{
-		LL_pointer = sm->cols[i];
-		if(LL_pointer != NULL)
-		{
-			matrices_LU->cols_LU[colidx++] = rowidx;
-		}		
-		while(LL_pointer != NULL)
+		element = NR_Amatrix_element(powerflow_values,indexval);
+		by_row[next_pos[element->row_ind]++] = indexval;
+	}
+
+	//Deal them out to the columns in row order, so the rows of each column come out sorted
+	for (indexval=0; indexval<ncols; indexval++)
+		next_pos[indexval] = matrices_LU->cols_LU[indexval];
+
+	for (indexval=0; indexval<nels; indexval++)
+	{
+		element = NR_Amatrix_element(powerflow_values,by_row[indexval]);
+		rowval = element->row_ind;
+		colval = element->col_ind;
+		posval = next_pos[colval]++;
+
+		if ((posval > (unsigned int)matrices_LU->cols_LU[colval]) && (matrices_LU->rows_LU[posval-1] == (int)rowval))
 		{
-			matrices_LU->rows_LU[rowidx] = LL_pointer->row_ind; // row pointers of non zero values
-			matrices_LU->a_LU[rowidx] = LL_pointer->value;
-			++rowidx;
-			LL_pointer = LL_pointer->next;
-		}		
+			GL_THROW("NR: duplicate admittance entry found - check for parallel circuits between common nodes!");
+			/*  TROUBLESHOOT
+			While building up the admittance matrix for the Newton-Raphson solver, a duplicate entry was found.
+			This is often caused by having multiple lines on the same phases in parallel between two nodes.  Please
+			reconcile this model difference and try again.
+			*/
+		}
+
+		matrices_LU->rows_LU[posval] = rowval;
+		powerflow_values->Amatrix_slot[by_row[indexval]] = posval;
 	}
+
+	gl_free(next_pos);
+	gl_free(by_row);
 }
 
 /** Newton-Raphson solver
@@ -318,11 +286,6 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 	unsigned int m,n;
 	double *sol_LU;
 
-	//Spare notation variable - for output
-	SP_E *temp_element;
-	int row, col;
-	double value;
-	
 #ifndef MT
 	superlu_options_t options;	//Additional variables for sequential superLU
 	SuperLUStat_t stat;
@@ -398,6 +361,9 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 
 	if (NR_admit_change)	//If an admittance update was detected, fix it
 	{
+		//The Amatrix pattern follows the admittance, so it needs to be rebuilt too
+		powerflow_values->NR_pattern_valid = false;
+
 		//Build the diagnoal elements of the bus admittance matrix - this should only happen once no matter what
 		if (powerflow_values->BA_diag == NULL)
 		{
@@ -5044,142 +5010,6 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 			return 0;					//Just return some arbitrary value - not technically bad
 		}
 
-		if (powerflow_values->Y_Amatrix == NULL)
-		{
-			powerflow_values->Y_Amatrix = (SPARSE*) gl_malloc(sizeof(SPARSE));
-
-			//Make sure it worked
-			if (powerflow_values->Y_Amatrix == NULL)
-				GL_THROW("NR: Failed to allocate memory for one of the necessary matrices");
-
-			//Initiliaze it
-			sparse_init(powerflow_values->Y_Amatrix, size_Amatrix, 6*NR_bus_count);
-		}
-		else if (powerflow_values->NR_realloc_needed)	//If one of the above changed, we changed too
-		{
-			//Destroy the old version
-			sparse_clear(powerflow_values->Y_Amatrix);
-
-			//Create a new 
-			sparse_init(powerflow_values->Y_Amatrix, size_Amatrix, 6*NR_bus_count);
-		}
-		else
-		{
-			//Just clear it out
-			sparse_reset(powerflow_values->Y_Amatrix, 6*NR_bus_count);
-		}
-
-		//integrate off diagonal components
-		for (indexer=0; indexer<powerflow_values->size_offdiag_PQ*2; indexer++)
-		{
-			row = powerflow_values->Y_offdiag_PQ[indexer].row_ind;
-			col = powerflow_values->Y_offdiag_PQ[indexer].col_ind;
-			value = powerflow_values->Y_offdiag_PQ[indexer].Y_value;
-			sparse_add(powerflow_values->Y_Amatrix, row, col, value);
-		}
-
-		//Integrate fixed portions of diagonal components
-		for (indexer=powerflow_values->size_offdiag_PQ*2; indexer< (powerflow_values->size_offdiag_PQ*2 + powerflow_values->size_diag_fixed*2); indexer++)
-		{
-			row = powerflow_values->Y_diag_fixed[indexer - powerflow_values->size_offdiag_PQ*2 ].row_ind;
-			col = powerflow_values->Y_diag_fixed[indexer - powerflow_values->size_offdiag_PQ*2 ].col_ind;
-			value = powerflow_values->Y_diag_fixed[indexer - powerflow_values->size_offdiag_PQ*2 ].Y_value;
-			sparse_add(powerflow_values->Y_Amatrix, row, col, value);
-		}
-
-		//Integrate the variable portions of the diagonal components
-		for (indexer=powerflow_values->size_offdiag_PQ*2 + powerflow_values->size_diag_fixed*2; indexer< size_Amatrix; indexer++)
-		{
-			row = powerflow_values->Y_diag_update[indexer - powerflow_values->size_offdiag_PQ*2 - powerflow_values->size_diag_fixed*2].row_ind;
-			col = powerflow_values->Y_diag_update[indexer - powerflow_values->size_offdiag_PQ*2 - powerflow_values->size_diag_fixed*2].col_ind;
-			value = powerflow_values->Y_diag_update[indexer - powerflow_values->size_offdiag_PQ*2 - powerflow_values->size_diag_fixed*2].Y_value;
-			sparse_add(powerflow_values->Y_Amatrix, row, col, value);
-		}
-
-		//See if we want to dump out the matrix values
-		if (NRMatDumpMethod != MD_NONE)
-		{
-			//Code to export the sparse matrix values - useful for debugging issues
-
-			//Check our frequency
-			if ((NRMatDumpMethod == MD_ALL) || ((NRMatDumpMethod != MD_ALL) && (Iteration == 0)))
-			{
-				//Open the text file - append now
-				FPoutVal=fopen(MDFileName,"at");
-
-				//See if we wanted references - Only do this once per call, regardless (keeps file size down)
-				if ((NRMatReferences == true) && (Iteration == 0))
-				{
-					//Print the index information
-					fprintf(FPoutVal,"Matrix Index information for this call - start,stop,name\n");
-
-					for (indexer=0; indexer<bus_count; indexer++)
-					{
-						//Extract the start/stop indices
-						jindexer = 2*bus[indexer].Matrix_Loc;
-						kindexer = jindexer + 2*powerflow_values->BA_diag[indexer].size - 1;
-
-						//Print them out
-						fprintf(FPoutVal,"%d,%d,%s\n",jindexer,kindexer,bus[indexer].name);
-					}
-
-					//Add in a blank line so it looks pretty
-					fprintf(FPoutVal,"\n");
-				}//End print the references
-
-				//Print the simulation time and iteration number
-				fprintf(FPoutVal,"Timestamp: %lld - Iteration %lld\n",gl_globalclock,Iteration);
-
-				//Print size - for parsing ease
-				fprintf(FPoutVal,"Matrix Information - non-zero element count = %d\n",size_Amatrix);
-				
-				//Print the values - printed as "row index, column index, value"
-				//This particular output is after they have been column sorted for the algorithm
-				//Header
-				fprintf(FPoutVal,"Matrix Information - row, column, value\n");
-
-				//Null temp variable
-				temp_element = NULL;
-
-				//Loop through the columns, extracting starting point each time
-				for (jindexer=0; jindexer<powerflow_values->Y_Amatrix->ncols; jindexer++)
-				{
-					//Extract the column starting point
-					temp_element = powerflow_values->Y_Amatrix->cols[jindexer];
-
-					//Check for nulling
-					if (temp_element != NULL)
-					{
-						//Print this value
-						fprintf(FPoutVal,"%d,%d,%f\n",temp_element->row_ind,jindexer,temp_element->value);
-
-						//Loop
-						while (temp_element->next != NULL)
-						{
-							//Get next element
-							temp_element = temp_element->next;
-
-							//Repeat the print
-							fprintf(FPoutVal,"%d,%d,%f\n",temp_element->row_ind,jindexer,temp_element->value);
-						}
-					}
-					//If it is null, go next.  Implies we have an invalid matrix size, but that may be what we're looking for
-				}//End sparse matrix traversion for dump
-
-				//Print an extra line, so it looks nice for ALL/PERCALL
-				fprintf(FPoutVal,"\n");
-
-				//Close the file, we're done with it
-				fclose(FPoutVal);
-
-				//See if we were a "ONCE" - if so, deflag us
-				if (NRMatDumpMethod == MD_ONCE)
-				{
-					NRMatDumpMethod = MD_NONE;	//Flag to do no more
-				}
-			}//End Actual output
-		}//End matrix dump desired
-
 		///* Initialize parameters. */
 		m = 2*powerflow_values->total_variables;
 		n = 2*powerflow_values->total_variables;
@@ -5251,6 +5081,10 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 				//Run allocation routine
 				((void (*)(void *,unsigned int, unsigned int, bool))(LUSolverFcns.ext_alloc))(ext_solver_glob_vars,n,n,NR_admit_change);
 			}
+			else if (matrix_solver_method == MM_KLU)
+			{
+				//Nothing to do - KLU allocates when it analyzes a new pattern
+			}
 			else
 			{
 				GL_THROW("Invalid matrix solution method specified for NR solver!");
@@ -5259,6 +5093,9 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 
 			//Update tracking variable
 			powerflow_values->prev_m = m;
+
+			//Pattern arrays changed, so the pattern must be rebuilt
+			powerflow_values->NR_pattern_valid = false;
 		}
 		else if (powerflow_values->NR_realloc_needed)	//Something changed, we'll just destroy everything and start over
 		{
@@ -5324,6 +5161,10 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 				//Run allocation routine
 				((void (*)(void *,unsigned int, unsigned int, bool))(LUSolverFcns.ext_alloc))(ext_solver_glob_vars,n,n,NR_admit_change);
 			}
+			else if (matrix_solver_method == MM_KLU)
+			{
+				//Nothing to do - KLU allocates when it analyzes a new pattern
+			}
 			else
 			{
 				GL_THROW("Invalid matrix solution method specified for NR solver!");
@@ -5332,6 +5173,9 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 
 			//Update tracking variable
 			powerflow_values->prev_m = m;
+
+			//Pattern arrays changed, so the pattern must be rebuilt
+			powerflow_values->NR_pattern_valid = false;
 		}
 		else if (powerflow_values->prev_m != m)	//Non-reallocing size change occurred
 		{
@@ -5348,6 +5192,10 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 				//Run allocation routine
 				((void (*)(void *,unsigned int, unsigned int, bool))(LUSolverFcns.ext_alloc))(ext_solver_glob_vars,n,n,NR_admit_change);
 			}
+			else if (matrix_solver_method == MM_KLU)
+			{
+				//Nothing to do - the size change is caught as a pattern change
+			}
 			else
 			{
 				GL_THROW("Invalid matrix solution method specified for NR solver!");
@@ -5356,6 +5204,9 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 
 			//Update tracking variable
 			powerflow_values->prev_m = m;
+
+			//Pattern arrays changed, so the pattern must be rebuilt
+			powerflow_values->NR_pattern_valid = false;
 		}
 
 #ifndef MT
@@ -5367,8 +5218,102 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 		//Default else - not superLU
 #endif
 		
-		sparse_tonr(powerflow_values->Y_Amatrix, &matrices_LU);
-		matrices_LU.cols_LU[n] = nnz ;// number of non-zeros;
+		//Build the compressed column pattern of the Amatrix - only needed when the topology changed
+		if ((powerflow_values->NR_pattern_valid == false) || (powerflow_values->size_Amatrix != size_Amatrix))
+		{
+			sparse_pattern(powerflow_values, &matrices_LU, size_Amatrix, n);
+
+			powerflow_values->size_Amatrix = size_Amatrix;
+			powerflow_values->NR_pattern_valid = true;
+		}
+
+		//Put the values straight into their places - off diagonal components
+		for (indexer=0; indexer<powerflow_values->size_offdiag_PQ*2; indexer++)
+		{
+			matrices_LU.a_LU[powerflow_values->Amatrix_slot[indexer]] = powerflow_values->Y_offdiag_PQ[indexer].Y_value;
+		}
+
+		//Fixed portions of diagonal components
+		kindexer = powerflow_values->size_offdiag_PQ*2;
+		for (indexer=0; indexer<powerflow_values->size_diag_fixed*2; indexer++)
+		{
+			matrices_LU.a_LU[powerflow_values->Amatrix_slot[kindexer + indexer]] = powerflow_values->Y_diag_fixed[indexer].Y_value;
+		}
+
+		//Variable portions of the diagonal components
+		kindexer += powerflow_values->size_diag_fixed*2;
+		for (indexer=0; indexer<(size_Amatrix - kindexer); indexer++)
+		{
+			matrices_LU.a_LU[powerflow_values->Amatrix_slot[kindexer + indexer]] = powerflow_values->Y_diag_update[indexer].Y_value;
+		}
+
+		//See if we want to dump out the matrix values
+		if (NRMatDumpMethod != MD_NONE)
+		{
+			//Code to export the sparse matrix values - useful for debugging issues
+
+			//Check our frequency
+			if ((NRMatDumpMethod == MD_ALL) || ((NRMatDumpMethod != MD_ALL) && (Iteration == 0)))
+			{
+				//Open the text file - append now
+				FPoutVal=fopen(MDFileName,"at");
+
+				//See if we wanted references - Only do this once per call, regardless (keeps file size down)
+				if ((NRMatReferences == true) && (Iteration == 0))
+				{
+					//Print the index information
+					fprintf(FPoutVal,"Matrix Index information for this call - start,stop,name\n");
+
+					for (indexer=0; indexer<bus_count; indexer++)
+					{
+						//Extract the start/stop indices
+						jindexer = 2*bus[indexer].Matrix_Loc;
+						kindexer = jindexer + 2*powerflow_values->BA_diag[indexer].size - 1;
+
+						//Print them out
+						fprintf(FPoutVal,"%d,%d,%s\n",jindexer,kindexer,bus[indexer].name);
+					}
+
+					//Add in a blank line so it looks pretty
+					fprintf(FPoutVal,"\n");
+				}//End print the references
+
+				//Print the simulation time and iteration number
+				fprintf(FPoutVal,"Timestamp: %lld - Iteration %lld\n",gl_globalclock,Iteration);
+
+				//Print size - for parsing ease
+				fprintf(FPoutVal,"Matrix Information - non-zero element count = %d\n",size_Amatrix);
+				
+				//Print the values - printed as "row index, column index, value"
+				//This particular output is after they have been column sorted for the algorithm
+				//Header
+				fprintf(FPoutVal,"Matrix Information - row, column, value\n");
+
+				//Loop through the columns
+				for (jindexer=0; jindexer<n; jindexer++)
+				{
+					//Print the values of this column
+					for (kindexer=matrices_LU.cols_LU[jindexer]; kindexer<(unsigned int)matrices_LU.cols_LU[jindexer+1]; kindexer++)
+					{
+						fprintf(FPoutVal,"%d,%d,%f\n",matrices_LU.rows_LU[kindexer],jindexer,matrices_LU.a_LU[kindexer]);
+					}
+					//If it is empty, go next.  Implies we have an invalid matrix size, but that may be what we're looking for
+				}//End sparse matrix traversion for dump
+
+				//Print an extra line, so it looks nice for ALL/PERCALL
+				fprintf(FPoutVal,"\n");
+
+				//Close the file, we're done with it
+				fclose(FPoutVal);
+
+				//See if we were a "ONCE" - if so, deflag us
+				if (NRMatDumpMethod == MD_ONCE)
+				{
+					NRMatDumpMethod = MD_NONE;	//Flag to do no more
+				}
+			}//End Actual output
+		}//End matrix dump desired
+
 
 		//Determine how to populate the rhs vector
 		if (mesh_imped_vals == NULL)	//Normal powerflow, copy in the values
@@ -5380,21 +5325,28 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 		}
 		//Default else -- it is NULL - zero it and "populate it" below
 
-		if (matrix_solver_method==MM_SUPERLU)
+		if ((matrix_solver_method==MM_SUPERLU) || (matrix_solver_method==MM_KLU))
 		{
-			////* Create Matrix A in the format expected by Super LU.*/
-			//Populate the matrix values (temporary value)
-			Astore = (NCformat*)A_LU.Store;
-			Astore->nnz = nnz;
-			Astore->nzval = matrices_LU.a_LU;
-			Astore->rowind = matrices_LU.rows_LU;
-			Astore->colptr = matrices_LU.cols_LU;
-		    
-			// Create right-hand side matrix B in format expected by Super LU
-			//Populate the matrix (temporary values)
-			Bstore = (DNformat*)B_LU.Store;
-			Bstore->lda = m;
-			Bstore->nzval = matrices_LU.rhs_LU;
+			if (matrix_solver_method==MM_SUPERLU)
+			{
+				////* Create Matrix A in the format expected by Super LU.*/
+				//Populate the matrix values (temporary value)
+				Astore = (NCformat*)A_LU.Store;
+				Astore->nnz = nnz;
+				Astore->nzval = matrices_LU.a_LU;
+				Astore->rowind = matrices_LU.rows_LU;
+				Astore->colptr = matrices_LU.cols_LU;
+			    
+				// Create right-hand side matrix B in format expected by Super LU
+				//Populate the matrix (temporary values)
+				Bstore = (DNformat*)B_LU.Store;
+				Bstore->lda = m;
+				Bstore->nzval = matrices_LU.rhs_LU;
+			}
+			else if (mesh_imped_vals != NULL)	//KLU - factor once, the solves below only need the factors
+			{
+				info = klu_solver_factor(&klu_LU,n,matrices_LU.cols_LU,matrices_LU.rows_LU,matrices_LU.a_LU);
+			}
 
 			//See how to call the function - if normal mode or not
 			if (mesh_imped_vals != NULL)
@@ -5476,6 +5428,13 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 					matrices_LU.rhs_LU[tempa + kindex] = 1.0;
 
 					//Do a solution to get this entry (copied from below - includes "destructors"
+					if (matrix_solver_method==MM_KLU)
+					{
+						if (info == 0)
+							klu_solver_solve(&klu_LU,matrices_LU.rhs_LU);
+					}
+					else
+					{
 #ifdef MT
 					//superLU_MT commands
 
@@ -5503,10 +5462,12 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 					Destroy_CompCol_Matrix( &U_LU );
 					StatFree ( &stat );
 #endif
+					}
+
 					//Crude superLU checks - see if it is mission accomplished or not
 					if (info != 0)	//Failed inversion, for various reasons
 					{
-						gl_error("solver_nr: superLU failed mesh fault matrix inversion with code %d",info);
+						gl_error("solver_nr: %s failed mesh fault matrix inversion with code %d",(matrix_solver_method==MM_KLU) ? "KLU" : "superLU",info);
 						/*  TROUBLESHOOT
 						superLU failed to invert the equivalent impedance matrix for the mesh fault calculation
 						method.  Please try again and make sure your system is valid.  If the error persists, please
@@ -5523,7 +5484,10 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 					//Default else, must have converged!
 
 					//Map up the solution vector
-					sol_LU = (double*) ((DNformat*) B_LU.Store)->nzval;
+					if (matrix_solver_method==MM_KLU)
+						sol_LU = matrices_LU.rhs_LU;
+					else
+						sol_LU = (double*) ((DNformat*) B_LU.Store)->nzval;
 
 					//Extract out this column into the temporary matrix
 					for (jindex=0; jindex<temp_size; jindex++)
@@ -5621,6 +5585,13 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 				//Exit
 				return 1;	//Non-zero, so success (manual checks outside though)
 			}//End "just mesh impedance calculations"
+			else if (matrix_solver_method==MM_KLU)	//Nulled, "normal" powerflow - KLU
+			{
+				//Factor and solve - independent islands are handled separately and concurrently
+				info = klu_islands_solve(&klu_islands,n,matrices_LU.cols_LU,matrices_LU.rows_LU,matrices_LU.a_LU,matrices_LU.rhs_LU,NR_island_threads());
+
+				sol_LU = matrices_LU.rhs_LU;
+			}
 			else	//Nulled, "normal" powerflow
 			{
 #ifdef MT
@@ -5680,7 +5651,7 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 			GL_THROW("Invalid matrix solution method specified for NR solver!");
 			/*  TROUBLESHOOT
 			An invalid matrix solution method was selected for the Newton-Raphson solver method.
-			Valid options are the superLU solver or an external solver.  Please select one of these methods.
+			Valid options are the superLU solver, the built-in KLU solver, or an external solver.  Please select one of these methods.
 			*/
 		}
 
@@ -5917,6 +5888,10 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 			//Call destruction routine
 			((void (*)(void *, bool))(LUSolverFcns.ext_destroy))(ext_solver_glob_vars,newiter);
 		}
+		else if (matrix_solver_method==MM_KLU)
+		{
+			//Nothing to do - factors are kept so the next call can refactor with the same analysis
+		}
 		else	//Not sure how we get here
 		{
 			GL_THROW("Invalid matrix solution method specified for NR solver!");
@@ -5951,6 +5926,10 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 		{
 			gl_verbose("External LU solver failed out with return value %d",info);
 		}
+		else if (matrix_solver_method==MM_KLU)
+		{
+			gl_verbose("KLU solver failed out with return value %d",info);
+		}
 		//Defaulted else - shouldn't exist (or make it this far), but if it does, we're failing anyways
 
 		*bad_computations = true;	//Flag our output as bad
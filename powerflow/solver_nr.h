@@ -96,21 +96,6 @@ typedef enum {
 	PF_DYNCALC=2	///< Modified powerflow, for dynamics mode after initial powerflow
 	} NRSOLVERMODE;
 
-// Sparse element
-typedef struct SP_E {
-	struct SP_E* next;
-	int row_ind;  ///< row location of the element
-    double value; ///< value of the element
-} SP_E;
-
-// Sparse matrix
-typedef struct {
-	SP_E** cols;
-	SP_E* llheap;
-	unsigned int llptr;
-	unsigned int ncols;
-} SPARSE;
-
 typedef struct {
 	double *deltaI_NR;					/// Storage array for current injection
 	unsigned int size_offdiag_PQ;		/// Number of fixed off-diagonal matrix elements
@@ -118,7 +103,7 @@ typedef struct {
 	unsigned int total_variables;		///Total number of phases to be calculating (size of matrices)
 	unsigned int max_size_offdiag_PQ;	///Maximum allocated space for off-diagonal portion
 	unsigned int max_size_diag_fixed;	///Maximum allocated space for fixed portion of diagonal
-	unsigned int max_total_variables;	///Maximum allocated space for "whole solution" variables - e.g., Y_Amatrix
+	unsigned int max_total_variables;	///Maximum allocated space for "whole solution" variables
 	unsigned int max_size_diag_update;	///Maximum allocated space for updating portion of diagonal
 	unsigned int prev_m;				///Track size of matrix put into superLU form - may not need a realloc, but needs to be updated
 	bool NR_realloc_needed;				///flag to indicate a matrix reallocation is required
@@ -126,7 +111,10 @@ typedef struct {
 	Y_NR *Y_offdiag_PQ;					///Y_offdiag_PQ store the row,column and value of off_diagonal elements of 6n*6n Y_NR matrix. No PV bus is included.
 	Y_NR *Y_diag_fixed;					///Y_diag_fixed store the row,column and value of fixed diagonal elements of 6n*6n Y_NR matrix. No PV bus is included.
 	Y_NR *Y_diag_update;				///Y_diag_update store the row,column and value of updated diagonal elements of 6n*6n Y_NR matrix at each iteration. No PV bus is included.
-	SPARSE *Y_Amatrix;					///Y_Amatrix store all the elements of Amatrix in equation AX=B;
+	unsigned int *Amatrix_slot;			///Position of each Y_offdiag_PQ, Y_diag_fixed and Y_diag_update element in the compressed column form of the Amatrix in equation AX=B
+	unsigned int max_size_Amatrix;		///Maximum allocated space for Amatrix_slot
+	unsigned int size_Amatrix;			///Number of elements the compressed column pattern was built for
+	bool NR_pattern_valid;				///flag to indicate the compressed column pattern matches the current topology
 } NR_SOLVER_STRUCT;
 
 //Mesh-fault-related structure - passing information
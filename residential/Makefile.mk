@@ -25,6 +25,8 @@ residential_residential_la_SOURCES += residential/freezer.cpp
 residential_residential_la_SOURCES += residential/freezer.h
 residential_residential_la_SOURCES += residential/house_a.cpp
 residential_residential_la_SOURCES += residential/house_a.h
+residential_residential_la_SOURCES += residential/house_bulk.cpp
+residential_residential_la_SOURCES += residential/house_bulk.h
 residential_residential_la_SOURCES += residential/house_e.cpp
 residential_residential_la_SOURCES += residential/house_e.h
 residential_residential_la_SOURCES += residential/init.cpp
@@ -0,0 +1,156 @@
+/** $Id$
+	Copyright (C) 2008 Battelle Memorial Institute
+	@file house_bulk.cpp
+	@addtogroup house_e
+	@ingroup residential
+
+	Bulk thermal update of house_e objects (see house_bulk.h)
+
+	The slots are kept as parallel arrays so the kernel runs as a few
+	straight loops over contiguous data.  The exponentials are done in a
+	separate loop so the arithmetic loops around them have no calls and
+	can be vectorized by the compiler.
+ @{
+ **/
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "house_bulk.h"
+
+enumeration thermal_kernel = TK_OBJECT;
+
+static struct {
+	unsigned int n;			///< number of slots in use
+	unsigned int max;		///< number of slots allocated
+	TIMESTAMP *t0;			///< time of the stored model
+	TIMESTAMP *t1;			///< time the results were computed for (TS_NEVER if none)
+	double *k1, *r1, *k2, *r2, *Teq, *A3, *A4;	///< ETP solution
+	double *q1;				///< Qm/Hm
+	double *q2;				///< (Qm+Qa)/U
+	double *Tout;			///< outdoor temperature
+	double *e1, *e2;		///< exponential terms
+	double *Tair, *Tmaterials;	///< results
+	unsigned char *valid;	///< flag indicating the slot has a model to advance (c2!=0)
+} slots = {0,0};
+
+static volatile TIMESTAMP last_step = TS_NEVER;
+static unsigned int slots_lock = 0;
+
+template <class T> static bool grow(T *&data, unsigned int max)
+{
+	T *more = (T*)realloc(data,sizeof(T)*max);
+	if ( more==NULL )
+		return false;
+	data = more;
+	return true;
+}
+
+/** Add a slot for a house
+	@return the slot, or -1 if no memory is available
+ **/
+int house_bulk::add(void)
+{
+	int slot = -1;
+	wlock(&slots_lock);
+	if ( slots.n==slots.max )
+	{
+		unsigned int max = slots.max ? slots.max*2 : 1024;
+		if ( !grow(slots.t0,max) || !grow(slots.t1,max)
+			|| !grow(slots.k1,max) || !grow(slots.r1,max) || !grow(slots.k2,max) || !grow(slots.r2,max)
+			|| !grow(slots.Teq,max) || !grow(slots.A3,max) || !grow(slots.A4,max)
+			|| !grow(slots.q1,max) || !grow(slots.q2,max) || !grow(slots.Tout,max)
+			|| !grow(slots.e1,max) || !grow(slots.e2,max) || !grow(slots.Tair,max) || !grow(slots.Tmaterials,max)
+			|| !grow(slots.valid,max) )
+		{
+			wunlock(&slots_lock);
+			return -1;
+		}
+		slots.max = max;
+	}
+	slot = slots.n++;
+	slots.t0[slot] = TS_NEVER;
+	slots.t1[slot] = TS_NEVER;
+	slots.valid[slot] = 0;
+	wunlock(&slots_lock);
+	return slot;
+}
+
+/** Store the ETP solution of a house after update_model()
+ **/
+void house_bulk::store(int slot, TIMESTAMP t0, double k1, double r1, double k2, double r2, double Teq, double A3, double A4, double Qm, double Qa, double Hm, double Ueff, double Tout, double c2)
+{
+	slots.t0[slot] = t0;
+	slots.t1[slot] = TS_NEVER;
+	slots.k1[slot] = k1;
+	slots.r1[slot] = r1;
+	slots.k2[slot] = k2;
+	slots.r2[slot] = r2;
+	slots.Teq[slot] = Teq;
+	slots.A3[slot] = A3;
+	slots.A4[slot] = A4;
+	slots.q1[slot] = Qm/Hm;
+	slots.q2[slot] = (Qm+Qa)/Ueff;
+	slots.Tout[slot] = Tout;
+	slots.valid[slot] = (c2!=0);
+}
+
+/* advance all slots to t1 */
+void house_bulk::advance(TIMESTAMP t1)
+{
+	const unsigned int n = slots.n;
+	const TIMESTAMP *t0 = slots.t0;
+	double *e1 = slots.e1, *e2 = slots.e2;
+	unsigned int i;
+
+	/* exponents (same dt as house_e::presync) */
+	for ( i=0 ; i<n ; i++ )
+	{
+		const double dt = (double)((t1-t0[i])*TS_SECOND)/3600;
+		const bool use = slots.valid[i] && t0[i]>0 && dt>0;
+		e1[i] = use ? slots.r1[i]*dt : 0;
+		e2[i] = use ? slots.r2[i]*dt : 0;
+	}
+
+	/* exponentials */
+	for ( i=0 ; i<n ; i++ )
+	{
+		e1[i] = exp(e1[i]);
+		e2[i] = exp(e2[i]);
+	}
+
+	/* temperatures */
+	for ( i=0 ; i<n ; i++ )
+	{
+		const double a = slots.k1[i]*e1[i];
+		const double b = slots.k2[i]*e2[i];
+		slots.Tair[i] = a + b + slots.Teq[i];
+		slots.Tmaterials[i] = slots.A3[i]*a + slots.A4[i]*b + slots.q1[i] + slots.q2[i] + slots.Tout[i];
+	}
+	for ( i=0 ; i<n ; i++ )
+		slots.t1[i] = t1;
+}
+
+/** Get the temperatures of a house advanced from t0 to t1
+	@return true if the slot has results for t0 and t1, false if the house must do its own update
+ **/
+bool house_bulk::fetch(int slot, TIMESTAMP t0, TIMESTAMP t1, double &Tair, double &Tmaterials)
+{
+	if ( last_step!=t1 )
+	{
+		wlock(&slots_lock);
+		if ( last_step!=t1 )
+		{
+			advance(t1);
+			last_step = t1;
+		}
+		wunlock(&slots_lock);
+	}
+	if ( slots.t0[slot]!=t0 || slots.t1[slot]!=t1 )
+		return false;
+	Tair = slots.Tair[slot];
+	Tmaterials = slots.Tmaterials[slot];
+	return true;
+}
+
+/**@}**/
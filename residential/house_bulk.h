@@ -0,0 +1,46 @@
+/** $Id$
+	Copyright (C) 2008 Battelle Memorial Institute
+	@file house_bulk.h
+	@addtogroup house_e
+	@ingroup residential
+
+	Bulk thermal update of house_e objects
+
+	When residential::thermal_kernel is BULK or VALIDATE, each house keeps
+	a slot in a set of structure-of-arrays tables.  The house writes its ETP
+	solution into its slot when update_model() runs, and the first house
+	presync of a timestep advances every slot at once.  The other houses
+	pick up their new air and mass temperatures from their slot.
+
+	The kernel uses the same expressions, in the same order, as the per-object
+	update in house_e::presync(), so the temperatures are identical.  In
+	VALIDATE mode each house also computes its own update and stops the
+	simulation if the results differ in any bit.
+ @{
+ **/
+
+#ifndef _HOUSE_BULK_H
+#define _HOUSE_BULK_H
+
+#include "gridlabd.h"
+
+typedef enum {
+	TK_OBJECT=0,	///< each house advances its own thermal state
+	TK_BULK=1,		///< houses are advanced together by the bulk kernel
+	TK_VALIDATE=2,	///< bulk kernel results are checked against the per-object update
+} THERMALKERNEL;
+
+extern enumeration thermal_kernel;
+
+class house_bulk {
+public:
+	static int add(void);
+	static void store(int slot, TIMESTAMP t0, double k1, double r1, double k2, double r2, double Teq, double A3, double A4, double Qm, double Qa, double Hm, double Ueff, double Tout, double c2);
+	static bool fetch(int slot, TIMESTAMP t0, TIMESTAMP t1, double &Tair, double &Tmaterials);
+private:
+	static void advance(TIMESTAMP t1);
+};
+
+#endif
+
+/**@}**/
@@ -84,6 +84,7 @@
 #include <math.h>
 #include "solvers.h"
 #include "house_e.h"
+#include "house_bulk.h"
 #include "complex.h"
 
 #ifndef WIN32
@@ -516,6 +517,7 @@ int house_e::create()
 	hvac_breaker_rating = 0;
 	hvac_power_factor = 0;
 	Tmaterials = 0.0;
+	bulk_slot = -1;
 
 	cooling_supply_air_temp = 50.0;
 	heating_supply_air_temp = 150.0;
@@ -1597,6 +1599,18 @@ int house_e::init(OBJECT *parent)
 		return 0;
 	}
 	update_model();
+
+	// join the bulk thermal kernel
+	if (thermal_kernel!=TK_OBJECT)
+	{
+		bulk_slot = house_bulk::add();
+		if (bulk_slot<0)
+			gl_warning("house_e:%d: unable to join the bulk thermal kernel, using the per-object update", hdr->id);
+			/* TROUBLESHOOT
+			There was not enough memory to add the house to the bulk thermal kernel.  The house
+			advances its own thermal state instead, which gives the same results more slowly.
+			*/
+	}
 	
 	// attach the house_e HVAC to the panel
 	if (hvac_breaker_rating == 0)
@@ -2201,14 +2215,36 @@ TIMESTAMP house_e::presync(TIMESTAMP t0, TIMESTAMP t1)
 		/* calculate model update, if possible */
 		if (c2!=0)
 		{
-			/* update temperatures */
-			const double e1 = k1*exp(r1*dt);
-			const double e2 = k2*exp(r2*dt);
-			Tair = e1 + e2 + Teq;
-			if (window_open == 1)
-				Tmaterials = A3*e1 + A4*e2 + Qm/Hm + (Qm+Qa)/(10*Ua) + Tout;
+			double bulk_Tair, bulk_Tmaterials;
+			bool bulk = (bulk_slot>=0 && house_bulk::fetch(bulk_slot,t0,t1,bulk_Tair,bulk_Tmaterials));
+			if (bulk && thermal_kernel==TK_BULK)
+			{
+				Tair = bulk_Tair;
+				Tmaterials = bulk_Tmaterials;
+			}
 			else
-				Tmaterials = A3*e1 + A4*e2 + Qm/Hm + (Qm+Qa)/(Ua) + Tout;
+			{
+				/* update temperatures */
+				const double e1 = k1*exp(r1*dt);
+				const double e2 = k2*exp(r2*dt);
+				Tair = e1 + e2 + Teq;
+				if (window_open == 1)
+					Tmaterials = A3*e1 + A4*e2 + Qm/Hm + (Qm+Qa)/(10*Ua) + Tout;
+				else
+					Tmaterials = A3*e1 + A4*e2 + Qm/Hm + (Qm+Qa)/(Ua) + Tout;
+				if (bulk && (memcmp(&bulk_Tair,&Tair,sizeof(double))!=0 || memcmp(&bulk_Tmaterials,&Tmaterials,sizeof(double))!=0))
+				{
+					gl_error("%s (house_e:%d) bulk thermal kernel gives Tair=%.17g, Tmaterials=%.17g instead of %.17g, %.17g", 
+						obj->name?obj->name:"(anon)", obj->id, bulk_Tair, bulk_Tmaterials, Tair, Tmaterials);
+					/* TROUBLESHOOT
+					The residential::thermal_kernel VALIDATE mode found that the bulk thermal kernel did
+					not reproduce the per-object thermal update exactly.  This can happen when another
+					object changes the thermal parameters of the house between its sync and its next
+					presync.  Use thermal_kernel OBJECT for this model and report the problem.
+					*/
+					return TS_INVALID;
+				}
+			}
 		}
 	}
 
@@ -2365,6 +2401,8 @@ TIMESTAMP house_e::sync(TIMESTAMP t0, TIMESTAMP t1)
 		// update the model of house
 		update_model(dt1);
 		heat_start = true;
+		if (bulk_slot>=0)
+			house_bulk::store(bulk_slot,t1,k1,r1,k2,r2,Teq,A3,A4,Qm,Qa,Hm,(window_open==1)?(10*Ua):(Ua),Tout,c2);
 
 	}
 
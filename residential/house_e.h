@@ -423,6 +423,7 @@ private:
 	static double system_dwell_time; // time interval at which hvac checks its state (approximates true dwell time)
 	bool check_start;
 	bool heat_start;
+	int bulk_slot;	// slot in the bulk thermal kernel (-1 if none)
 
 	complex load_values[3][3];	//Power, Current, and impedance (admittance) load accumulators for
 
@@ -32,6 +32,7 @@
 
 #include "residential_enduse.h"
 #include "house_e.h"
+#include "house_bulk.h"
 
 complex default_line_voltage[3] = {complex(240,0,A),complex(120,0,A),complex(120,0,A)};
 complex default_line_current[3] = {complex(0,0,J),complex(0,0,J),complex(0,0,J)};
@@ -61,6 +62,11 @@ EXPORT CLASS *init(CALLBACKS *fntable, MODULE *module, int argc, char *argv[])
 	gl_global_create("residential::default_solar",PT_double,&default_solar,PT_SIZE,9,PT_UNITS,"Btu/sf",PT_DESCRIPTION,"solar gains when no climate data is found",NULL);
 	gl_global_create("residential::default_etp_iterations",PT_int64,&default_etp_iterations,PT_DESCRIPTION,"number of iterations ETP solver will run",NULL);
 	gl_global_create("residential::ANSI_voltage_check",PT_bool,&ANSI_voltage_check,PT_DESCRIPTION,"enable or disable messages about ANSI voltage limit violations in the house",NULL);
+	gl_global_create("residential::thermal_kernel",PT_enumeration,&thermal_kernel,
+		PT_KEYWORD,"OBJECT",(enumeration)TK_OBJECT,
+		PT_KEYWORD,"BULK",(enumeration)TK_BULK,
+		PT_KEYWORD,"VALIDATE",(enumeration)TK_VALIDATE,
+		PT_DESCRIPTION,"method used to advance the thermal state of houses (BULK and VALIDATE use the bulk thermal kernel)",NULL);
 
 	new residential_enduse(module);
 	new appliance(module);
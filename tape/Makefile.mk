@@ -7,8 +7,11 @@ tape_tape_la_LDFLAGS =
 tape_tape_la_LDFLAGS += $(AM_LDFLAGS)
 
 tape_tape_la_LIBADD = -ldl
+tape_tape_la_LIBADD += $(PTHREAD_LIBS)
 
 tape_tape_la_SOURCES =
+tape_tape_la_SOURCES += tape/binary.c
+tape_tape_la_SOURCES += tape/binary.h
 tape_tape_la_SOURCES += tape/collector.c
 tape_tape_la_SOURCES += tape/file.c
 tape_tape_la_SOURCES += tape/file.h
@@ -31,3 +34,9 @@ tape_tape_la_SOURCES += tape/recorder.c
 tape_tape_la_SOURCES += tape/shaper.c
 tape_tape_la_SOURCES += tape/tape.c
 tape_tape_la_SOURCES += tape/tape.h
+
+bin_PROGRAMS += tapebin
+
+tapebin_SOURCES =
+tapebin_SOURCES += tape/tapebin.c
+tapebin_SOURCES += tape/binary.h
@@ -0,0 +1,391 @@
+/* $Id$
+ *	Copyright (C) 2008 Battelle Memorial Institute
+ *
+ *	Binary tape writer and reader
+ *
+ *	Records are packed into blocks in the calling (sync) thread.  Full
+ *	blocks are queued and written by a single background thread, so the
+ *	sync threads never wait on the file system unless the queue grows
+ *	beyond BINARY_QUEUE_LIMIT bytes.
+ *
+ *	Tapes are read by mapping the whole file into memory, so the records
+ *	can be used in place.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifndef WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "gridlabd.h"
+#include "tape.h"
+#include "binary.h"
+
+#define BINARY_BLOCK_SIZE 4096 /* target size of a block */
+#define BINARY_QUEUE_LIMIT (64<<20) /* most bytes waiting to be written before writers have to wait */
+
+typedef struct s_binaryblock {
+	BINARYWRITER *writer; /**< writer the block belongs to */
+	size_t used; /**< bytes used in the block */
+	int last; /**< flag indicating the file is closed after this block */
+	struct s_binaryblock *next; /**< next block in the queue */
+	char data[1]; /**< the records */
+} BINARYBLOCK;
+
+struct s_binarywriter {
+	FILE *fp; /**< the output file (used only by the writer thread once open) */
+	char fname[1024]; /**< the file name */
+	size_t record_size; /**< size of a record */
+	size_t block_size; /**< capacity of a block */
+	BINARYBLOCK *block; /**< block being filled */
+	volatile int failed; /**< flag set by the writer thread when a write fails */
+	struct s_binarywriter *next; /**< next open writer */
+};
+
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_ready = PTHREAD_COND_INITIALIZER; /* signals blocks are waiting */
+static pthread_cond_t queue_space = PTHREAD_COND_INITIALIZER; /* signals the queue went below the limit */
+static BINARYBLOCK *queue_head = NULL, *queue_tail = NULL;
+static size_t queue_bytes = 0;
+static BINARYWRITER *open_writers = NULL;
+static pthread_t writer_thread;
+static int writer_running = 0;
+static int writer_stop = 0;
+
+static BINARYBLOCK *new_block(BINARYWRITER *writer)
+{
+	BINARYBLOCK *block = (BINARYBLOCK*)malloc(sizeof(BINARYBLOCK)+writer->block_size);
+	if ( block==NULL )
+		return NULL;
+	block->writer = writer;
+	block->used = 0;
+	block->last = 0;
+	block->next = NULL;
+	return block;
+}
+
+/* write thread main loop */
+static void *binary_writer(void *arg)
+{
+	pthread_mutex_lock(&queue_lock);
+	while ( 1 )
+	{
+		BINARYBLOCK *block;
+		BINARYWRITER *writer;
+
+		while ( queue_head==NULL && !writer_stop )
+			pthread_cond_wait(&queue_ready,&queue_lock);
+		if ( queue_head==NULL )
+			break;
+
+		block = queue_head;
+		queue_head = block->next;
+		if ( queue_head==NULL )
+			queue_tail = NULL;
+		pthread_mutex_unlock(&queue_lock);
+
+		writer = block->writer;
+		if ( block->used>0 && !writer->failed && fwrite(block->data,1,block->used,writer->fp)!=block->used )
+			writer->failed = errno ? errno : EIO;
+		if ( block->last )
+		{
+			if ( fclose(writer->fp)!=0 && !writer->failed )
+				writer->failed = errno ? errno : EIO;
+			if ( writer->failed )
+				fprintf(stderr,"ERROR: binary tape '%s' was not completely written: %s\n", writer->fname, strerror(writer->failed));
+			free(writer);
+		}
+
+		pthread_mutex_lock(&queue_lock);
+		queue_bytes -= block->used;
+		if ( queue_bytes<BINARY_QUEUE_LIMIT )
+			pthread_cond_broadcast(&queue_space);
+		free(block);
+	}
+	pthread_mutex_unlock(&queue_lock);
+	return NULL;
+}
+
+/* hand a block to the writer thread (queue_lock must be held) */
+static void queue_block(BINARYBLOCK *block)
+{
+	while ( queue_bytes>=BINARY_QUEUE_LIMIT && writer_running )
+		pthread_cond_wait(&queue_space,&queue_lock);
+	if ( queue_tail==NULL )
+		queue_head = block;
+	else
+		queue_tail->next = block;
+	queue_tail = block;
+	queue_bytes += block->used;
+	pthread_cond_signal(&queue_ready);
+}
+
+/** Open a binary tape for writing
+	@return the writer, or NULL on failure
+ **/
+BINARYWRITER *binary_open(char *fname, BINARYHEADER *header, int *types)
+{
+	BINARYWRITER *writer = (BINARYWRITER*)malloc(sizeof(BINARYWRITER));
+	if ( writer==NULL )
+	{
+		gl_error("binary tape %s: %s", fname, strerror(ENOMEM));
+		return NULL;
+	}
+	memset(writer,0,sizeof(BINARYWRITER));
+	strncpy(writer->fname,fname,sizeof(writer->fname)-1);
+	writer->record_size = header->record_size;
+	writer->block_size = BINARY_BLOCK_SIZE/writer->record_size*writer->record_size;
+	if ( writer->block_size==0 )
+		writer->block_size = writer->record_size;
+
+	writer->fp = fopen(fname,"wb");
+	if ( writer->fp==NULL )
+	{
+		gl_error("binary tape %s: %s", fname, strerror(errno));
+		free(writer);
+		return NULL;
+	}
+
+	/* blocks are already the size of a disk write, so stdio buffering only adds a copy */
+	setvbuf(writer->fp,NULL,_IONBF,0);
+
+	memcpy(header->magic,BINARY_MAGIC,sizeof(header->magic));
+	header->version = BINARY_VERSION;
+	if ( fwrite(header,sizeof(BINARYHEADER),1,writer->fp)!=1
+		|| fwrite(types,sizeof(int),header->columns,writer->fp)!=(size_t)header->columns )
+	{
+		gl_error("binary tape %s: unable to write header (%s)", fname, strerror(errno));
+		fclose(writer->fp);
+		free(writer);
+		return NULL;
+	}
+
+	writer->block = new_block(writer);
+	if ( writer->block==NULL )
+	{
+		gl_error("binary tape %s: %s", fname, strerror(ENOMEM));
+		fclose(writer->fp);
+		free(writer);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&queue_lock);
+	if ( !writer_running )
+	{
+		writer_stop = 0;
+		if ( pthread_create(&writer_thread,NULL,binary_writer,NULL)!=0 )
+		{
+			pthread_mutex_unlock(&queue_lock);
+			gl_error("binary tape %s: unable to start writer thread", fname);
+			/*	TROUBLESHOOT
+				The background thread that writes binary recorder files could not be
+				started.  Free up system resources and try again, or use a text
+				filetype for the recorder.
+			 */
+			free(writer->block);
+			fclose(writer->fp);
+			free(writer);
+			return NULL;
+		}
+		writer_running = 1;
+	}
+	writer->next = open_writers;
+	open_writers = writer;
+	pthread_mutex_unlock(&queue_lock);
+
+	return writer;
+}
+
+/** Append a record to a binary tape
+	@return 1 on success, 0 on failure
+ **/
+int binary_write(BINARYWRITER *writer, TIMESTAMP ts, void *values)
+{
+	BINARYBLOCK *block = writer->block;
+	int64 t = ts;
+
+	if ( writer->failed )
+		return 0;
+
+	if ( block->used+writer->record_size>writer->block_size )
+	{
+		BINARYBLOCK *next = new_block(writer);
+		if ( next==NULL )
+			return 0;
+		pthread_mutex_lock(&queue_lock);
+		queue_block(block);
+		pthread_mutex_unlock(&queue_lock);
+		writer->block = block = next;
+	}
+
+	memcpy(block->data+block->used,&t,sizeof(t));
+	memcpy(block->data+block->used+sizeof(t),values,writer->record_size-sizeof(t));
+	block->used += writer->record_size;
+	return 1;
+}
+
+/** Close a binary tape
+
+	The file is closed by the writer thread once all its records are written.
+	The writer may not be used after this call.
+ **/
+void binary_close(BINARYWRITER *writer)
+{
+	BINARYWRITER **pw;
+
+	pthread_mutex_lock(&queue_lock);
+	for ( pw=&open_writers ; *pw!=NULL ; pw=&(*pw)->next )
+	{
+		if ( *pw==writer )
+		{
+			*pw = writer->next;
+			break;
+		}
+	}
+	writer->block->last = 1;
+	queue_block(writer->block);
+	pthread_mutex_unlock(&queue_lock);
+}
+
+/** Close all binary tapes and wait until they are written
+ **/
+void binary_term(void)
+{
+	while ( open_writers!=NULL )
+		binary_close(open_writers);
+
+	pthread_mutex_lock(&queue_lock);
+	if ( !writer_running )
+	{
+		pthread_mutex_unlock(&queue_lock);
+		return;
+	}
+	writer_stop = 1;
+	pthread_cond_signal(&queue_ready);
+	pthread_mutex_unlock(&queue_lock);
+
+	pthread_join(writer_thread,NULL);
+	writer_running = 0;
+}
+
+/** Map a binary tape into memory
+	@return the tape, or NULL on failure
+ **/
+BINARYTAPE *binary_map(char *fname, BINARYKIND kind)
+{
+	BINARYTAPE *tape = (BINARYTAPE*)malloc(sizeof(BINARYTAPE));
+	size_t size, n;
+	int columns;
+#ifdef WIN32
+	FILE *fp;
+#else
+	struct stat st;
+	int fd;
+#endif
+
+	if ( tape==NULL )
+	{
+		gl_error("binary tape %s: %s", fname, strerror(ENOMEM));
+		return NULL;
+	}
+	memset(tape,0,sizeof(BINARYTAPE));
+
+#ifdef WIN32
+	/* read the whole file */
+	fp = fopen(fname,"rb");
+	if ( fp==NULL || fseek(fp,0,SEEK_END)!=0 )
+	{
+		gl_error("binary tape %s: %s", fname, strerror(errno));
+		if ( fp!=NULL ) fclose(fp);
+		free(tape);
+		return NULL;
+	}
+	tape->size = ftell(fp);
+	rewind(fp);
+	tape->data = malloc(tape->size>0?tape->size:1);
+	if ( tape->data==NULL || fread(tape->data,1,tape->size,fp)!=tape->size )
+	{
+		gl_error("binary tape %s: unable to load the file", fname);
+		fclose(fp);
+		free(tape->data);
+		free(tape);
+		return NULL;
+	}
+	fclose(fp);
+#else
+	fd = open(fname,O_RDONLY);
+	if ( fd<0 || fstat(fd,&st)!=0 )
+	{
+		gl_error("binary tape %s: %s", fname, strerror(errno));
+		if ( fd>=0 ) close(fd);
+		free(tape);
+		return NULL;
+	}
+	tape->size = (size_t)st.st_size;
+	tape->data = tape->size>0 ? mmap(NULL,tape->size,PROT_READ,MAP_PRIVATE,fd,0) : MAP_FAILED;
+	close(fd);
+	if ( tape->data==MAP_FAILED )
+	{
+		gl_error("binary tape %s: unable to map the file (%s)", fname, strerror(errno));
+		free(tape);
+		return NULL;
+	}
+	madvise(tape->data,tape->size,MADV_SEQUENTIAL);
+#endif
+
+	/* check the header and the column types */
+	tape->header = (BINARYHEADER*)tape->data;
+	size = sizeof(BINARYHEADER);
+	if ( tape->size<size || memcmp(tape->header->magic,BINARY_MAGIC,sizeof(BINARY_MAGIC))!=0 )
+	{
+		gl_error("binary tape %s: not a binary tape", fname);
+		binary_unmap(tape);
+		return NULL;
+	}
+	columns = tape->header->columns;
+	if ( tape->header->version!=BINARY_VERSION || tape->header->kind!=kind || columns<0 || columns>65536 )
+	{
+		gl_error("binary tape %s: version %d %s tape is not supported", fname, tape->header->version, tape->header->kind==BK_PLAYER?"player":"recorder");
+		/*	TROUBLESHOOT
+			The binary tape was written by a different version of the tape module,
+			or it is not the kind of tape the object needs (recorder output cannot
+			be played directly).  Convert the source again with tapebin.
+		 */
+		binary_unmap(tape);
+		return NULL;
+	}
+	tape->types = (int*)((char*)tape->data+size);
+	size += sizeof(int)*columns;
+	n = (kind==BK_PLAYER ? 2 : 1)*sizeof(int64);
+	while ( columns-->0 )
+		n += BINARY_COLUMN_SIZE(tape->types[columns]);
+	if ( tape->size<size || (int)n!=tape->header->record_size )
+	{
+		gl_error("binary tape %s: record size does not match the columns", fname);
+		binary_unmap(tape);
+		return NULL;
+	}
+	tape->records = (char*)tape->data+size;
+	tape->count = (tape->size-size)/n;
+	return tape;
+}
+
+/** Release a mapped binary tape
+ **/
+void binary_unmap(BINARYTAPE *tape)
+{
+#ifdef WIN32
+	free(tape->data);
+#else
+	munmap(tape->data,tape->size);
+#endif
+	free(tape);
+}
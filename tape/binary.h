@@ -0,0 +1,67 @@
+/* $Id$
+ *	Copyright (C) 2008 Battelle Memorial Institute
+ *
+ *	Binary tape format
+ *
+ *	A binary tape starts with a BINARYHEADER, followed by one column type
+ *	(int) for each column, followed by fixed-size records.  Each record is
+ *	a 64-bit timestamp (seconds) followed by the column values in order:
+ *	BC_DOUBLE and BC_INTEGER columns take 8 bytes, BC_COMPLEX columns take
+ *	16 bytes (real then imaginary).  Player tapes have a single column, and
+ *	their records have a second 64-bit field after the timestamp holding
+ *	the relative step of the source line (+N), or -1 if the source line
+ *	had an absolute time.  The step is what is replayed when the player
+ *	loops.  Values are stored in the byte order of the machine that wrote
+ *	them.
+ *
+ *	This header does not depend on gridlabd.h so that standalone tools
+ *	(see tapebin.c) can read and write the format.
+ */
+
+#ifndef _BINARY_H
+#define _BINARY_H
+
+#define BINARY_MAGIC "GLDTAPE"
+#define BINARY_VERSION 1
+
+typedef enum {BK_RECORDER=1, BK_PLAYER=2} BINARYKIND;
+typedef enum {BC_DOUBLE=1, BC_COMPLEX=2, BC_INTEGER=3} BINARYCOLUMN;
+
+typedef struct s_binaryheader {
+	char magic[8]; /**< BINARY_MAGIC */
+	int version; /**< BINARY_VERSION */
+	int kind; /**< BINARYKIND */
+	int columns; /**< number of columns after the timestamp */
+	int record_size; /**< size of a record in bytes, including the timestamp */
+	long long interval; /**< sampling interval of the recorder (-1 for transients only) */
+	char target[256]; /**< object that was recorded */
+	char property[1024]; /**< column names, comma-separated */
+} BINARYHEADER;
+
+#define BINARY_COLUMN_SIZE(T) ((T)==BC_COMPLEX?16:8)
+#define BINARY_ABSOLUTE (-1) /* step of a player record with an absolute time */
+
+#ifdef _TAPE_H
+
+typedef struct s_binarywriter BINARYWRITER;
+
+BINARYWRITER *binary_open(char *fname, BINARYHEADER *header, int *types);
+int binary_write(BINARYWRITER *writer, TIMESTAMP ts, void *values);
+void binary_close(BINARYWRITER *writer);
+void binary_term(void);
+
+typedef struct s_binarytape {
+	BINARYHEADER *header; /**< header of the tape */
+	int *types; /**< column types */
+	char *records; /**< first record */
+	size_t count; /**< number of records */
+	void *data; /**< the mapped (or loaded) file */
+	size_t size; /**< size of the file */
+} BINARYTAPE;
+
+BINARYTAPE *binary_map(char *fname, BINARYKIND kind);
+void binary_unmap(BINARYTAPE *tape);
+
+#endif
+
+#endif
@@ -11,6 +11,7 @@
 	The default \p name is the target (parent) objects \p classname-\p id
 	The default \p flags is \p "r"
 	- \p filetype specifies the source file extension, default is \p "txt".  Valid types are \p txt, \p odbc, and \p memory.
+	Use \p bin to play a binary tape made with \p "tapebin -p", which is mapped into memory and played without parsing.
 	- \p property is the target (parent) that is written to
 	- \p loop is the number of times the tape is to be repeated
 
@@ -43,6 +44,7 @@
 #include "tape.h"
 #include "file.h"
 #include "odbc.h"
+#include "binary.h"
 
 CLASS *player_class = NULL;
 static OBJECT *last_player = NULL;
@@ -70,11 +72,173 @@ EXPORT int create_player(OBJECT **obj, OBJECT *parent)
 		my->delta_track.ns = 0;
 		my->delta_track.ts = TS_NEVER;
 		my->delta_track.value[0] = '\0';
+		my->binary = NULL;
+		my->record = NULL;
 		return 1;
 	}
 	return 0;
 }
 
+/* check that a binary column can be stored in the target property */
+static int binary_player_compatible(int type, PROPERTYTYPE ptype)
+{
+	switch ( type ) {
+	case BC_COMPLEX:
+		return ptype==PT_complex;
+	case BC_DOUBLE:
+		return ptype==PT_double || ptype==PT_float || ptype==PT_complex;
+	case BC_INTEGER:
+		return ptype==PT_int16 || ptype==PT_int32 || ptype==PT_int64 || ptype==PT_enumeration
+			|| ptype==PT_set || ptype==PT_bool || ptype==PT_timestamp || ptype==PT_double;
+	default:
+		return 0;
+	}
+}
+
+static int binary_player_open(OBJECT *obj, char *fname)
+{
+	struct player *my = OBJECTDATA(obj,struct player);
+	char ff[1024];
+	int type;
+
+	if ( (obj->flags)&OF_DELTAMODE )
+	{
+		gl_error("player:%d: binary players do not support deltamode", obj->id);
+		/*	TROUBLESHOOT
+			Binary tapes only hold whole-second timestamps, so a player with filetype "bin"
+			cannot drive deltamode updates.  Use a text filetype for deltamode players.
+		 */
+		my->status = TS_DONE;
+		return 0;
+	}
+	if ( !gl_findfile(fname,NULL,R_OK,ff,sizeof(ff)) )
+	{
+		gl_error("player file %s: %s", fname, strerror(ENOENT));
+		my->status = TS_DONE;
+		return 0;
+	}
+	my->binary = binary_map(ff,BK_PLAYER);
+	if ( my->binary==NULL )
+	{
+		my->status = TS_DONE;
+		return 0;
+	}
+
+	/* the target is needed now to check the column type */
+	if ( my->target==NULL && obj->parent!=NULL )
+		my->target = gl_get_property(obj->parent,my->property,NULL);
+	type = my->binary->header->columns==1 ? my->binary->types[0] : 0;
+	if ( my->target!=NULL && !binary_player_compatible(type,my->target->ptype) )
+	{
+		gl_error("player:%d: binary tape %s cannot be played into property %s", obj->id, fname, my->target->name);
+		/*	TROUBLESHOOT
+			The values in the binary tape do not have a type that can be stored directly
+			in the target property.  Convert the source again using "tapebin -p -t <type>"
+			with the type that matches the property, or use a text player.
+		 */
+		binary_unmap(my->binary);
+		my->binary = NULL;
+		my->status = TS_DONE;
+		return 0;
+	}
+	my->record = NULL;
+	my->loopnum = my->loop;
+	my->status = TS_OPEN;
+	my->type = FT_FILE;
+	return 1;
+}
+
+/* store the value of the current binary record directly in the target */
+static void binary_player_set(OBJECT *obj, OBJECT *target)
+{
+	struct player *my = OBJECTDATA(obj,struct player);
+	PROPERTY *prop = my->target;
+	char *addr = (char*)GETADDR(target,prop);
+	char *data = my->record+2*sizeof(int64);
+	double x=0, y=0;
+	int64 i=0;
+
+	if ( my->binary->types[0]==BC_INTEGER )
+		memcpy(&i,data,sizeof(i));
+	else
+	{
+		memcpy(&x,data,sizeof(x));
+		if ( my->binary->types[0]==BC_COMPLEX )
+			memcpy(&y,data+sizeof(x),sizeof(y));
+	}
+
+	/* properties with notifiers need the value as text */
+	if ( prop->access!=PA_PUBLIC || prop->notify!=NULL || prop->notify_override || target->oclass->notify!=NULL )
+	{
+		switch ( my->binary->types[0] ) {
+		case BC_INTEGER: sprintf(my->next.value,"%" FMT_INT64 "d",i); break;
+		case BC_COMPLEX: sprintf(my->next.value,"%.17g%+.17gj",x,y); break;
+		default: sprintf(my->next.value,"%.17g",x); break;
+		}
+		gl_set_value(target,addr,my->next.value,prop);
+		return;
+	}
+
+	if ( prop->flags&PF_RECALC )
+		target->flags |= OF_RECALC;
+	switch ( prop->ptype ) {
+	case PT_double: *(double*)addr = my->binary->types[0]==BC_INTEGER ? (double)i : x; break;
+	case PT_float: *(float*)addr = (float)x; break;
+	case PT_complex: ((complex*)addr)->r = x; ((complex*)addr)->i = y; ((complex*)addr)->f = J; break;
+	case PT_int16: *(int16*)addr = (int16)i; break;
+	case PT_int32: *(int32*)addr = (int32)i; break;
+	case PT_int64: *(int64*)addr = i; break;
+	case PT_enumeration: *(enumeration*)addr = (enumeration)i; break;
+	case PT_set: *(set*)addr = (set)i; break;
+	case PT_bool: *(bool*)addr = (i!=0); break;
+	case PT_timestamp: *(TIMESTAMP*)addr = (TIMESTAMP)i; break;
+	default: break;
+	}
+}
+
+/* advance to the next record of a binary tape */
+static TIMESTAMP binary_player_read(OBJECT *obj)
+{
+	struct player *my = OBJECTDATA(obj,struct player);
+	BINARYTAPE *tape = my->binary;
+	size_t size = tape->header->record_size;
+	char *end = tape->records+tape->count*size;
+	int64 ts, step;
+
+	while ( 1 )
+	{
+		my->record = my->record==NULL ? tape->records : my->record+size;
+		if ( my->record>=end )
+		{
+			if ( my->loopnum>0 && tape->count>0 )
+			{
+				my->loopnum--;
+				my->record = NULL;
+				continue;
+			}
+			binary_unmap(tape);
+			my->binary = NULL;
+			my->record = NULL;
+			my->status = TS_DONE;
+			my->next.ts = TS_NEVER;
+			my->next.ns = 0;
+			return TS_NEVER;
+		}
+		memcpy(&ts,my->record,sizeof(ts));
+		memcpy(&step,my->record+sizeof(ts),sizeof(step));
+
+		/* absolute times are ignored on all but the first loop */
+		if ( my->loop==my->loopnum )
+			my->next.ts = ts;
+		else if ( step!=BINARY_ABSOLUTE )
+			my->next.ts += step;
+		else
+			continue;
+		my->next.ns = 0;
+		return my->next.ts;
+	}
+}
+
 static int player_open(OBJECT *obj)
 {
 	char32 type="file";
@@ -97,6 +261,10 @@ static int player_open(OBJECT *obj)
 		/* use object name-id as default file name */
 		sprintf(fname,"%s-%d.%s",obj->parent->oclass->name,obj->parent->id, my->filetype);
 
+	/* binary tapes do not use the mode's text operations */
+	if ( strcmp(my->filetype,"bin")==0 )
+		return binary_player_open(obj,fname);
+
 	/* if type is file or file is stdin */
 	tf = get_ftable(my->mode);
 	if(tf == NULL)
@@ -175,6 +343,9 @@ TIMESTAMP player_read(OBJECT *obj)
 		else dateformat = ISO;
 	}
 
+	if ( my->binary!=NULL )
+		return binary_player_read(obj);
+
 Retry:
 	result = my->ops->read(my, buffer, sizeof(buffer));
 
@@ -365,7 +536,10 @@ EXPORT TIMESTAMP sync_player(OBJECT *obj, TIMESTAMP t0, PASSCONFIG pass)
 		if (my->target!=NULL)
 		{
 			OBJECT *target = obj->parent ? obj->parent : obj; /* target myself if no parent */
-			gl_set_value(target,GETADDR(target,my->target),my->next.value,my->target); /* pointer => int64 */
+			if ( my->binary!=NULL )
+				binary_player_set(obj,target);
+			else
+				gl_set_value(target,GETADDR(target,my->target),my->next.value,my->target); /* pointer => int64 */
 		}
 		
 		/* Copy the current value into our "tracking" variable */
@@ -27,6 +27,7 @@
 #include "tape.h"
 #include "file.h"
 #include "odbc.h"
+#include "binary.h"
 
 #ifndef WIN32
 #define strtok_s strtok_r
@@ -99,11 +100,190 @@ EXPORT int create_recorder(OBJECT **obj, OBJECT *parent)
 		my->header_units = HU_DEFAULT;
 		my->line_units = LU_DEFAULT;
 		my->flush = -1; /* -1 (default): flush when buffer full, 0 flush each line, >0 flush seconds */
+		my->binary = NULL;
 		return 1;
 	}
 	return 0;
 }
 
+/* Binary recorders (filetype "bin") keep the raw values of the properties
+   instead of formatting them, and write them through the binary tape writer */
+typedef struct s_binaryrecorder {
+	BINARYWRITER *writer; /**< the output, NULL until opened and after closing */
+	int columns; /**< number of columns */
+	int *types; /**< column types */
+	double *scale; /**< unit conversion scale of each column */
+	double *offset; /**< unit conversion offset of each column */
+	size_t size; /**< size of the values of a sample */
+	char *sample; /**< values being read */
+	char *last; /**< values waiting to be written */
+	int has_last; /**< flag indicating last holds a sample */
+} BINARYRECORDER;
+
+static int is_binary(struct recorder *my)
+{
+	return strcmp(my->filetype,"bin")==0;
+}
+
+/* set up the columns of a binary recorder for the linked properties */
+static int binary_recorder_setup(OBJECT *obj)
+{
+	struct recorder *my = OBJECTDATA(obj,struct recorder);
+	BINARYRECORDER *bin;
+	PROPERTY *p;
+	int n;
+
+	if ( my->trigger[0]!='\0' || my->multifile[0]!='\0' || ((obj->flags)&OF_DELTAMODE) )
+	{
+		gl_error("recorder:%d: binary recorders do not support triggers, multi-run files, or deltamode", obj->id);
+		/*	TROUBLESHOOT
+			A recorder with filetype "bin" can only sample properties at regular intervals
+			or on change.  Use a text filetype if you need triggers, multifile output, or
+			deltamode sampling.
+		 */
+		return 0;
+	}
+
+	bin = (BINARYRECORDER*)malloc(sizeof(BINARYRECORDER));
+	if ( bin==NULL )
+		return 0;
+	memset(bin,0,sizeof(BINARYRECORDER));
+	for ( p=my->target ; p!=NULL ; p=p->next )
+		bin->columns++;
+	bin->types = (int*)malloc(sizeof(int)*bin->columns);
+	bin->scale = (double*)malloc(sizeof(double)*bin->columns);
+	bin->offset = (double*)malloc(sizeof(double)*bin->columns);
+	if ( bin->types==NULL || bin->scale==NULL || bin->offset==NULL )
+		return 0;
+
+	for ( p=my->target, n=0 ; p!=NULL ; p=p->next, n++ )
+	{
+		PROPERTY *base;
+		switch ( p->ptype ) {
+		case PT_double:
+		case PT_float:
+			bin->types[n] = BC_DOUBLE;
+			break;
+		case PT_complex:
+			bin->types[n] = BC_COMPLEX;
+			break;
+		case PT_int16:
+		case PT_int32:
+		case PT_int64:
+		case PT_enumeration:
+		case PT_set:
+		case PT_bool:
+		case PT_timestamp:
+			bin->types[n] = BC_INTEGER;
+			break;
+		default:
+			gl_error("recorder:%d: property '%s' cannot be written to a binary recorder", obj->id, p->name);
+			/*	TROUBLESHOOT
+				Binary recorders only store numeric properties (doubles, complex values,
+				integers, enumerations, sets, and timestamps).  Record the property with
+				a text recorder instead.
+			 */
+			return 0;
+		}
+		bin->size += BINARY_COLUMN_SIZE(bin->types[n]);
+
+		/* requested units are converted like the text recorders do */
+		bin->scale[n] = 1.0;
+		bin->offset[n] = 0.0;
+		base = gl_get_property(obj->parent,p->name,NULL);
+		if ( p->unit!=NULL && base!=NULL && base->unit!=NULL && p->unit!=base->unit )
+		{
+			double zero = 0.0, one = 1.0;
+			if ( gl_convert_ex(base->unit,p->unit,&zero) && gl_convert_ex(base->unit,p->unit,&one) )
+			{
+				if ( bin->types[n]==BC_COMPLEX )
+					bin->scale[n] = one;
+				else
+				{
+					bin->scale[n] = one-zero;
+					bin->offset[n] = zero;
+				}
+			}
+		}
+	}
+
+	bin->sample = (char*)malloc(bin->size);
+	bin->last = (char*)malloc(bin->size);
+	if ( bin->sample==NULL || bin->last==NULL )
+		return 0;
+	my->binary = bin;
+	return 1;
+}
+
+/* read the raw values of the properties into the binary sample */
+static int binary_read_properties(struct recorder *my, OBJECT *obj)
+{
+	BINARYRECORDER *bin = my->binary;
+	char *pos = bin->sample;
+	PROPERTY *p;
+	int n;
+
+	for ( p=my->target, n=0 ; p!=NULL ; p=p->next, n++ )
+	{
+		void *addr = GETADDR(obj,p);
+		double x;
+		int64 i;
+		switch ( p->ptype ) {
+		case PT_double: x = *(double*)addr; break;
+		case PT_float: x = *(float*)addr; break;
+		case PT_complex:
+			x = ((complex*)addr)->r*bin->scale[n];
+			memcpy(pos,&x,sizeof(x));
+			x = ((complex*)addr)->i*bin->scale[n];
+			memcpy(pos+sizeof(x),&x,sizeof(x));
+			pos += 2*sizeof(x);
+			continue;
+		case PT_int16: i = *(int16*)addr; break;
+		case PT_int32: i = *(int32*)addr; break;
+		case PT_enumeration: i = *(enumeration*)addr; break;
+		case PT_set: i = (int64)*(set*)addr; break;
+		case PT_bool: i = *(unsigned char*)addr; break;
+		default: i = *(int64*)addr; break; /* PT_int64, PT_timestamp */
+		}
+		if ( bin->types[n]==BC_DOUBLE )
+		{
+			x = x*bin->scale[n]+bin->offset[n];
+			memcpy(pos,&x,sizeof(x));
+		}
+		else
+			memcpy(pos,&i,sizeof(i));
+		pos += 8;
+	}
+	return n;
+}
+
+static int binary_recorder_open(OBJECT *obj, char *fname)
+{
+	struct recorder *my = OBJECTDATA(obj,struct recorder);
+	BINARYRECORDER *bin = my->binary;
+	BINARYHEADER header;
+
+	memset(&header,0,sizeof(header));
+	header.kind = BK_RECORDER;
+	header.columns = bin->columns;
+	header.record_size = (int)(sizeof(int64)+bin->size);
+	header.interval = my->interval;
+	snprintf(header.target,sizeof(header.target),"%s %d", obj->parent->oclass->name, obj->parent->id);
+	strncpy(header.property,my->property,sizeof(header.property)-1);
+
+	bin->writer = binary_open(fname,&header,bin->types);
+	if ( bin->writer==NULL )
+	{
+		my->status = TS_DONE;
+		return 0;
+	}
+	my->type = FT_FILE;
+	my->last.ts = TS_ZERO;
+	my->status = TS_OPEN;
+	my->samples = 0;
+	return 1;
+}
+
 static int recorder_open(OBJECT *obj)
 {
 	char32 type="file";
@@ -280,6 +460,10 @@ static int recorder_open(OBJECT *obj)
 		}
 	}
 
+	/* binary recorders use their own writer */
+	if ( my->binary!=NULL )
+		return binary_recorder_open(obj,fname);
+
 	/* if type is file or file is stdin */
 	f = get_ftable(my->mode);
 	if(f != 0){
@@ -362,7 +546,10 @@ static int recorder_open(OBJECT *obj)
 
 static int write_recorder(struct recorder *my, char *ts, char *value)
 {
-	int rc=my->ops->write(my, ts, value);
+	int rc;
+	if ( my->binary!=NULL )
+		return my->binary->writer!=NULL && binary_write(my->binary->writer,my->last.ts,my->binary->last);
+	rc=my->ops->write(my, ts, value);
 	if ( (my->flush==0 || (my->flush>0 && my->flush%gl_globalclock==0)) && my->ops->flush!=NULL ) 
 		my->ops->flush(my);
 	return rc;
@@ -370,6 +557,10 @@ static int write_recorder(struct recorder *my, char *ts, char *value)
 
 static void close_recorder(struct recorder *my)
 {
+	if (my->binary && my->binary->writer){
+		binary_close(my->binary->writer);
+		my->binary->writer = NULL;
+	}
 	if (my->ops){
 		my->ops->close(my);
 	}
@@ -400,7 +591,9 @@ static TIMESTAMP recorder_write(OBJECT *obj)
 {
 	struct recorder *my = OBJECTDATA(obj,struct recorder);
 	char ts[64]="0"; /* 0 = INIT */
-	if (my->format==0)
+	if (my->binary!=NULL)
+		; /* binary records keep the raw timestamp */
+	else if (my->format==0)
 	{
 		if (my->last.ts>TS_ZERO)
 		{
@@ -650,13 +843,20 @@ EXPORT TIMESTAMP sync_recorder(OBJECT *obj, TIMESTAMP t0, PASSCONFIG pass)
 		my->status = TS_ERROR;
 		goto Error;
 	}
+	if (my->binary==NULL && is_binary(my) && !binary_recorder_setup(obj))
+	{
+		sprintf(buffer,"unable to set up binary output for '%s'", my->property);
+		close_recorder(my);
+		my->status = TS_ERROR;
+		goto Error;
+	}
 
 	// update clock
 	if ((my->status==TS_OPEN) && (t0 > obj->clock)) 
 	{	
 		obj->clock = t0;
 		// if the recorder is clock-based, write the value
-		if((my->interval > 0) && (my->last.ts < t0) && (my->last.value[0] != 0)){
+		if((my->interval > 0) && (my->last.ts < t0) && (my->binary ? my->binary->has_last : my->last.value[0] != 0)){
 			if (my->last.ns == 0)
 			{
 				recorder_write(obj);
@@ -664,12 +864,14 @@ EXPORT TIMESTAMP sync_recorder(OBJECT *obj, TIMESTAMP t0, PASSCONFIG pass)
 			}
 			else	//Just dump it, we already recorded this "timestamp"
 				my->last.value[0] = 0;
+			if (my->binary)
+				my->binary->has_last = 0;
 		}
 	}
 
 	/* update property value */
 	if ((my->target != NULL) && (my->interval == 0 || my->interval == -1)){	
-		if(read_properties(my, obj->parent,my->target,buffer,sizeof(buffer))==0)
+		if((my->binary ? binary_read_properties(my, obj->parent) : read_properties(my, obj->parent,my->target,buffer,sizeof(buffer)))==0)
 		{
 			sprintf(buffer,"unable to read property '%s' of %s %d", my->property, obj->parent->oclass->name, obj->parent->id);
 			close_recorder(my);
@@ -678,7 +880,7 @@ EXPORT TIMESTAMP sync_recorder(OBJECT *obj, TIMESTAMP t0, PASSCONFIG pass)
 	}
 	if ((my->target != NULL) && (my->interval > 0)){
 		if((t0 >=my->last.ts + my->interval) || ((t0 == my->last.ts) && (my->last.ns == 0))){
-			if(read_properties(my, obj->parent,my->target,buffer,sizeof(buffer))==0)
+			if((my->binary ? binary_read_properties(my, obj->parent) : read_properties(my, obj->parent,my->target,buffer,sizeof(buffer)))==0)
 			{
 				sprintf(buffer,"unable to read property '%s' of %s %d", my->property, obj->parent->oclass->name, obj->parent->id);
 				close_recorder(my);
@@ -719,11 +921,18 @@ EXPORT TIMESTAMP sync_recorder(OBJECT *obj, TIMESTAMP t0, PASSCONFIG pass)
 	if (my->status==TS_OPEN)
 	{	
 		if (my->interval==0 /* sample on every pass */
-			|| ((my->interval==-1) && my->last.ts!=t0 && strcmp(buffer,my->last.value)!=0) /* sample only when value changes */
+			|| ((my->interval==-1) && my->last.ts!=t0 && (my->binary /* sample only when value changes */
+				? (!my->binary->has_last || memcmp(my->binary->sample,my->binary->last,my->binary->size)!=0)
+				: strcmp(buffer,my->last.value)!=0))
 			)
 
 		{
 			strncpy(my->last.value,buffer,sizeof(my->last.value));
+			if (my->binary)
+			{
+				memcpy(my->binary->last,my->binary->sample,my->binary->size);
+				my->binary->has_last = 1;
+			}
 
 			/* Deltamode-related check -- if we're ahead, don't overwrite this */
 			if (my->last.ts < t0)
@@ -734,6 +943,11 @@ EXPORT TIMESTAMP sync_recorder(OBJECT *obj, TIMESTAMP t0, PASSCONFIG pass)
 			}
 		} else if ((my->interval > 0) && (my->last.ts == t0) && (my->last.ns == 0)){
 			strncpy(my->last.value,buffer,sizeof(my->last.value));
+			if (my->binary)
+			{
+				memcpy(my->binary->last,my->binary->sample,my->binary->size);
+				my->binary->has_last = 1;
+			}
 		}
 	}
 Error:
@@ -29,6 +29,7 @@
 #include "tape.h"
 #include "file.h"
 #include "odbc.h"
+#include "binary.h"
 
 #define MAP_DOUBLE(X,LO,HI) {#X,VT_DOUBLE,&X,LO,HI}
 #define MAP_INTEGER(X,LO,HI) {#X,VT_INTEGER,&X,LO,HI}
@@ -640,6 +641,12 @@ EXPORT STATUS postupdate(MODULE *module, TIMESTAMP t0, unsigned int64 dt)
 	return SUCCESS;
 }
 
+EXPORT void term(void)
+{
+	/* finish writing the binary recorders */
+	binary_term();
+}
+
 int do_kill()
 {
 	/* if global memory needs to be released, this is the time to do it */
@@ -92,6 +92,8 @@ struct player {
 	PROPERTY *target;
 	TAPEOPS *ops;
 	char lasterr[1024];
+	struct s_binarytape *binary; /**< binary source (filetype "bin") */
+	char *record; /**< next record of the binary source */
 }; /**< a player item */
 /** @}
 	@addtogroup shaper
@@ -179,6 +181,7 @@ struct recorder {
 	} last;
 	int32 samples;
 	PROPERTY *target;
+	struct s_binaryrecorder *binary; /**< binary output state (filetype "bin") */
 };
 /** @}
 	@addtogroup collector
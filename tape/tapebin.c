@@ -0,0 +1,393 @@
+/* $Id$
+ *	Copyright (C) 2008 Battelle Memorial Institute
+ *
+ *	tapebin - convert binary tapes to CSV, and player CSV files to binary tapes
+ *
+ *	Usage: tapebin [-d] [-o output.csv] input.bin
+ *	       tapebin -p [-t double|complex|integer] [-z timezone] input.csv output.bin
+ *
+ *	-d	write timestamps as local date and time (uses TZ) instead of seconds
+ *	-o	write to the given file instead of standard output
+ *	-p	convert a player file to a binary tape for a player with filetype "bin"
+ *	-t	type of the player values (default double)
+ *	-z	timezone of the date and time stamps in the player file (default TZ);
+ *		this must be the timezone of the model that plays the tape
+ *
+ *	Player files use the text player format: ISO date and time stamps (with
+ *	an optional timezone abbreviation), seconds with a unit (s, m, h, or d),
+ *	or times relative to the previous line (+N with a unit).  Fractional
+ *	seconds and values with units are not supported.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "binary.h"
+
+static void usage(void)
+{
+	fprintf(stderr,"Usage: tapebin [-d] [-o output.csv] input.bin\n");
+	fprintf(stderr,"       tapebin -p [-t double|complex|integer] [-z timezone] input.csv output.bin\n");
+	exit(2);
+}
+
+static void write_timestamp(FILE *out, long long ts, int dates)
+{
+	if ( dates )
+	{
+		char buffer[64];
+		time_t t = (time_t)ts;
+		struct tm *tm = localtime(&t);
+		if ( tm!=NULL && strftime(buffer,sizeof(buffer),"%Y-%m-%d %H:%M:%S %Z",tm)>0 )
+		{
+			fputs(buffer,out);
+			return;
+		}
+	}
+	fprintf(out,"%lld",ts);
+}
+
+static int dump_tape(FILE *in, FILE *out, BINARYHEADER *header, int *types, char *fname, int dates)
+{
+	char *record = (char*)malloc(header->record_size);
+	long long ts;
+	int n;
+
+	if ( record==NULL )
+	{
+		fprintf(stderr,"tapebin: %s\n", strerror(ENOMEM));
+		return 0;
+	}
+
+	fprintf(out,"# file...... %s\n", fname);
+	fprintf(out,"# target.... %s\n", header->target);
+	fprintf(out,"# interval.. %lld\n", header->interval);
+	fprintf(out,"# timestamp,%s\n", header->property);
+
+	while ( fread(record,header->record_size,1,in)==1 )
+	{
+		char *pos = record+(header->kind==BK_PLAYER?2:1)*sizeof(ts); /* players also have the step */
+		memcpy(&ts,record,sizeof(ts));
+		write_timestamp(out,ts,dates);
+		for ( n=0 ; n<header->columns ; n++ )
+		{
+			double x, y;
+			long long i;
+			switch ( types[n] ) {
+			case BC_DOUBLE:
+				memcpy(&x,pos,sizeof(x));
+				fprintf(out,",%+lg",x);
+				break;
+			case BC_COMPLEX:
+				memcpy(&x,pos,sizeof(x));
+				memcpy(&y,pos+sizeof(x),sizeof(y));
+				fprintf(out,",%+lg%+lgj",x,y);
+				break;
+			default:
+				memcpy(&i,pos,sizeof(i));
+				fprintf(out,",%lld",i);
+				break;
+			}
+			pos += BINARY_COLUMN_SIZE(types[n]);
+		}
+		fputc('\n',out);
+	}
+	fprintf(out,"# end of tape\n");
+	free(record);
+
+	if ( ferror(in) )
+	{
+		fprintf(stderr,"tapebin: %s: %s\n", fname, strerror(errno));
+		return 0;
+	}
+	return 1;
+}
+
+/* read the time of a player line, returns 0 if it cannot be used */
+static int read_player_time(char *text, long long *ts, long long *step)
+{
+	struct tm tm;
+	char tz[8]="", unit[2]="";
+	int Y, m, d, H, M, n;
+	double S;
+	long long t;
+
+	while ( *text==' ' || *text=='\t' )
+		text++;
+	memset(&tm,0,sizeof(tm));
+	if ( (n=sscanf(text,"%d-%d-%d %d:%d:%lf %7s",&Y,&m,&d,&H,&M,&S,tz))>=4 )
+	{
+		if ( n<6 ) S = 0;
+		if ( n<5 ) M = 0;
+		if ( S!=(int)S )
+			return 0;
+		tm.tm_year = Y-1900;
+		tm.tm_mon = m-1;
+		tm.tm_mday = d;
+		tm.tm_hour = H;
+		tm.tm_min = M;
+		tm.tm_sec = (int)S;
+		tm.tm_isdst = -1;
+		if ( n==7 )
+		{
+			tzset();
+			if ( strcmp(tz,tzname[0])==0 )
+				tm.tm_isdst = 0;
+			else if ( strcmp(tz,tzname[1])==0 )
+				tm.tm_isdst = 1;
+			else
+				return 0;
+		}
+		*ts = (long long)mktime(&tm);
+		*step = BINARY_ABSOLUTE;
+		return *ts!=-1;
+	}
+	if ( sscanf(text,"%lld%1s",&t,unit)!=2 )
+		return 0;
+	switch ( unit[0] ) {
+	case 's': break;
+	case 'm': t *= 60; break;
+	case 'h': t *= 3600; break;
+	case 'd': t *= 86400; break;
+	default: return 0;
+	}
+	if ( text[0]=='+' )
+	{
+		*ts += t;
+		*step = t;
+	}
+	else
+	{
+		*ts = t;
+		*step = BINARY_ABSOLUTE;
+	}
+	return 1;
+}
+
+/* read the value of a player line, returns 0 if it cannot be used */
+static int read_player_value(char *text, int type, char *data)
+{
+	char *end;
+	double x, y=0;
+	long long i;
+
+	while ( *text==' ' || *text=='\t' )
+		text++;
+	if ( type==BC_INTEGER )
+	{
+		i = strtoll(text,&end,0);
+		memcpy(data,&i,sizeof(i));
+	}
+	else
+	{
+		x = strtod(text,&end);
+		if ( type==BC_COMPLEX && end!=text )
+		{
+			char *im = end;
+			y = strtod(im,&end);
+			if ( end==im || (*end!='j' && *end!='i') )
+			{
+				if ( end!=im ) return 0;
+				y = 0;
+			}
+			else
+				end++;
+		}
+		memcpy(data,&x,sizeof(x));
+		if ( type==BC_COMPLEX )
+			memcpy(data+sizeof(x),&y,sizeof(y));
+	}
+	if ( end==text )
+		return 0;
+	while ( *end==' ' || *end=='\t' || *end=='\r' || *end=='\n' )
+		end++;
+	return *end=='\0';
+}
+
+static int convert_player(char *input, char *output, int type)
+{
+	FILE *in, *out;
+	BINARYHEADER header;
+	char line[1024], record[2*sizeof(long long)+16];
+	long long ts=0, step;
+	int linenum=0, ok=1;
+
+	in = fopen(input,"r");
+	if ( in==NULL )
+	{
+		fprintf(stderr,"tapebin: %s: %s\n", input, strerror(errno));
+		return 0;
+	}
+	out = fopen(output,"wb");
+	if ( out==NULL )
+	{
+		fprintf(stderr,"tapebin: %s: %s\n", output, strerror(errno));
+		fclose(in);
+		return 0;
+	}
+
+	memset(&header,0,sizeof(header));
+	memcpy(header.magic,BINARY_MAGIC,sizeof(header.magic));
+	header.version = BINARY_VERSION;
+	header.kind = BK_PLAYER;
+	header.columns = 1;
+	header.record_size = 2*sizeof(long long)+BINARY_COLUMN_SIZE(type);
+	strncpy(header.target,input,sizeof(header.target)-1);
+	strcpy(header.property,"value");
+	if ( fwrite(&header,sizeof(header),1,out)!=1 || fwrite(&type,sizeof(type),1,out)!=1 )
+		ok = 0;
+
+	while ( ok && fgets(line,sizeof(line),in)!=NULL )
+	{
+		char *comma;
+		linenum++;
+		if ( line[0]=='#' || line[0]=='\n' || line[0]=='\r' )
+			continue;
+		comma = strchr(line,',');
+		if ( comma==NULL )
+		{
+			fprintf(stderr,"tapebin: %s(%d): missing value\n", input, linenum);
+			ok = 0;
+			break;
+		}
+		*comma = '\0';
+		if ( !read_player_time(line,&ts,&step) )
+		{
+			fprintf(stderr,"tapebin: %s(%d): unable to use time '%s'\n", input, linenum, line);
+			ok = 0;
+			break;
+		}
+		if ( !read_player_value(comma+1,type,record+2*sizeof(long long)) )
+		{
+			fprintf(stderr,"tapebin: %s(%d): unable to use value '%s'\n", input, linenum, comma+1);
+			ok = 0;
+			break;
+		}
+		memcpy(record,&ts,sizeof(ts));
+		memcpy(record+sizeof(ts),&step,sizeof(step));
+		if ( fwrite(record,header.record_size,1,out)!=1 )
+			ok = 0;
+	}
+	if ( ferror(in) || ferror(out) )
+	{
+		fprintf(stderr,"tapebin: %s\n", strerror(errno));
+		ok = 0;
+	}
+	fclose(in);
+	if ( fclose(out)!=0 )
+		ok = 0;
+	if ( !ok )
+		remove(output);
+	return ok;
+}
+
+int main(int argc, char *argv[])
+{
+	char *input = NULL, *output = NULL;
+	int dates = 0, player = 0, type = BC_DOUBLE;
+	FILE *in, *out;
+	BINARYHEADER header;
+	int *types;
+	int n, size, ok;
+
+	for ( n=1 ; n<argc ; n++ )
+	{
+		if ( strcmp(argv[n],"-d")==0 )
+			dates = 1;
+		else if ( strcmp(argv[n],"-o")==0 && n+1<argc )
+			output = argv[++n];
+		else if ( strcmp(argv[n],"-p")==0 )
+			player = 1;
+		else if ( strcmp(argv[n],"-t")==0 && n+1<argc )
+		{
+			n++;
+			if ( strcmp(argv[n],"double")==0 ) type = BC_DOUBLE;
+			else if ( strcmp(argv[n],"complex")==0 ) type = BC_COMPLEX;
+			else if ( strcmp(argv[n],"integer")==0 ) type = BC_INTEGER;
+			else usage();
+		}
+		else if ( strcmp(argv[n],"-z")==0 && n+1<argc )
+		{
+			static char tz[256];
+			snprintf(tz,sizeof(tz),"TZ=%s",argv[++n]);
+			putenv(tz);
+		}
+		else if ( argv[n][0]=='-' )
+			usage();
+		else if ( input==NULL )
+			input = argv[n];
+		else if ( player && output==NULL )
+			output = argv[n];
+		else
+			usage();
+	}
+	if ( input==NULL )
+		usage();
+	if ( player )
+	{
+		if ( output==NULL )
+			usage();
+		return convert_player(input,output,type) ? 0 : 1;
+	}
+
+	in = fopen(input,"rb");
+	if ( in==NULL )
+	{
+		fprintf(stderr,"tapebin: %s: %s\n", input, strerror(errno));
+		return 1;
+	}
+	if ( fread(&header,sizeof(header),1,in)!=1
+		|| memcmp(header.magic,BINARY_MAGIC,sizeof(BINARY_MAGIC))!=0 )
+	{
+		fprintf(stderr,"tapebin: %s is not a binary tape\n", input);
+		return 1;
+	}
+	if ( header.version!=BINARY_VERSION || header.columns<0 || header.columns>65536 )
+	{
+		fprintf(stderr,"tapebin: %s has an unsupported version (%d)\n", input, header.version);
+		return 1;
+	}
+
+	/* read and check the column types */
+	types = (int*)malloc(sizeof(int)*(header.columns+1));
+	if ( types==NULL || fread(types,sizeof(int),header.columns,in)!=(size_t)header.columns )
+	{
+		fprintf(stderr,"tapebin: %s: unable to read the column types\n", input);
+		return 1;
+	}
+	size = (header.kind==BK_PLAYER?2:1)*sizeof(long long);
+	for ( n=0 ; n<header.columns ; n++ )
+		size += BINARY_COLUMN_SIZE(types[n]);
+	if ( size!=header.record_size )
+	{
+		fprintf(stderr,"tapebin: %s: record size does not match the columns\n", input);
+		return 1;
+	}
+
+	out = output ? fopen(output,"w") : stdout;
+	if ( out==NULL )
+	{
+		fprintf(stderr,"tapebin: %s: %s\n", output, strerror(errno));
+		return 1;
+	}
+
+	if ( header.kind==BK_RECORDER || header.kind==BK_PLAYER )
+		ok = dump_tape(in,out,&header,types,input,dates);
+	else
+	{
+		fprintf(stderr,"tapebin: %s: unknown tape kind %d\n", input, header.kind);
+		ok = 0;
+	}
+
+	fclose(in);
+	if ( out!=stdout && fclose(out)!=0 )
+	{
+		fprintf(stderr,"tapebin: %s: %s\n", output, strerror(errno));
+		ok = 0;
+	}
+	free(types);
+	return ok ? 0 : 1;
+}